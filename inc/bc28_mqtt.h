@@ -9,6 +9,15 @@
  * 2020-06-04     luhuadong    v0.0.1
  * 2020-07-25     luhuadong    support state transition
  * 2020-08-16     luhuadong    uniform function name
+ * 2026-10-19     agent        support adaptive keepalive
+ * 2026-10-19     agent        wait for URCs instead of polling
+ * 2026-10-19     agent        add link quality monitor
+ * 2026-10-19     agent        support MQTT-SN transport
+ * 2026-10-19     agent        support MQTT over module TCP sockets
+ * 2026-10-19     agent        add AT traffic record and replay
+ * 2026-10-19     agent        add fault injection scenarios
+ * 2026-10-19     agent        add telemetry aggregation
+ * 2026-10-19     agent        add OTA download over MQTT
  */
 
 #ifndef __AT_BC28_H__
@@ -31,15 +40,54 @@ struct bc28_device
     rt_base_t         reset_pin;
     rt_base_t         adc_pin;
     bc28_stat_t       stat;
-    rt_mutex_t        lock;
+    rt_event_t        event;
     char              imei[16];
     char              ipaddr[16];
+    char              tac[8];
+    char              ci[12];
 
     struct at_client *client;
     void (*parser)(const char *json);
 };
 typedef struct bc28_device *bc28_device_t;
 
+typedef enum bc28_transport
+{
+    BC28_TRANSPORT_FIRMWARE = 0,    /* AT+QMTxxx, MQTT over TCP in the module */
+    BC28_TRANSPORT_MQTTSN,          /* MQTT-SN over module UDP sockets */
+    BC28_TRANSPORT_MQTT             /* MQTT 3.1.1 encoded here, over module TCP sockets */
+
+} bc28_transport_t;
+
+/* MQTT-SN topic id types */
+#define BC28_MQTTSN_TOPIC_NORMAL      0
+#define BC28_MQTTSN_TOPIC_PREDEFINED  1
+#define BC28_MQTTSN_TOPIC_SHORT       2
+
+/* statistics published for an aggregated series */
+#define BC28_AGGR_MIN                 (1 << 0)
+#define BC28_AGGR_MAX                 (1 << 1)
+#define BC28_AGGR_MEAN                (1 << 2)
+#define BC28_AGGR_LAST                (1 << 3)
+#define BC28_AGGR_P50                 (1 << 4)
+#define BC28_AGGR_P90                 (1 << 5)
+#define BC28_AGGR_P99                 (1 << 6)
+#define BC28_AGGR_BASIC               (BC28_AGGR_MIN | BC28_AGGR_MAX | BC28_AGGR_MEAN | BC28_AGGR_LAST)
+#define BC28_AGGR_PERCENTILES         (BC28_AGGR_P50 | BC28_AGGR_P90 | BC28_AGGR_P99)
+
+struct bc28_link_info
+{
+    rt_int16_t        rsrp;         /* signal power, 0.1 dBm */
+    rt_int16_t        sinr;         /* SNR, 0.1 dB */
+    rt_int8_t         ecl;          /* coverage enhancement level 0~2, -1 unknown */
+    rt_uint8_t        csq;          /* 0~31, 99 unknown */
+    rt_tick_t         updated;      /* tick of the last sample, 0 if never sampled */
+
+    rt_uint16_t       batch;        /* suggested messages per batch */
+    rt_uint32_t       pace;         /* minimum interval between publishes (ms) */
+    rt_uint32_t       timeout;      /* publish response timeout (ms) */
+};
+
 /* NB-IoT */
 int  bc28_client_attach(void);
 int  bc28_client_deattach(void);
@@ -54,6 +102,62 @@ int  bc28_mqtt_subscribe(const char *topic);
 int  bc28_mqtt_unsubscribe(const char *topic);
 int  bc28_mqtt_publish(const char *topic, const char *msg);
 void bc28_bind_parser(void (*callback)(const char *json));
+int  bc28_mqtt_set_transport(bc28_transport_t type);
+
+#ifdef PKG_USING_BC28_MQTT_SN
+/* MQTT-SN */
+int  bc28_mqttsn_predefine(const char *topic, rt_uint16_t id);
+int  bc28_mqttsn_connect(void);
+int  bc28_mqttsn_close(void);
+int  bc28_mqttsn_publish(const char *topic, const void *data, rt_size_t len, int qos);
+int  bc28_mqttsn_sleep(rt_uint16_t duration);
+int  bc28_mqttsn_wake(void);
+#endif
+
+#ifdef PKG_USING_BC28_MQTT_CODEC
+/* MQTT 3.1.1 over module sockets */
+void bc28_mqttc_set_auth(const char *client_id, const char *username, const char *password);
+int  bc28_mqttc_connect(void);
+int  bc28_mqttc_close(void);
+int  bc28_mqttc_publish(const char *topic, const void *payload, rt_size_t len, int qos, int retain);
+int  bc28_mqttc_flush(rt_int32_t timeout);
+#endif
+
+#ifdef PKG_USING_BC28_MQTT_TAP
+/* AT traffic capture */
+int  bc28_tap_record(const char *path);
+int  bc28_tap_replay(const char *path, rt_uint32_t speed);
+int  bc28_tap_stop(void);
+#endif
+
+#ifdef PKG_USING_BC28_MQTT_AGGR
+/* telemetry aggregation */
+int  bc28_aggr_create(const char *name, rt_uint32_t window, rt_uint32_t slide, rt_uint8_t flags);
+void bc28_aggr_delete(int handle);
+void bc28_aggr_update(int handle, float value);
+void bc28_aggr_flush(void);
+#endif
+
+#ifdef PKG_USING_BC28_MQTT_OTA
+/* OTA download */
+int  bc28_ota_start(const char *version);
+int  bc28_ota_stop(void);
+void bc28_ota_bind(void (*callback)(int result, const char *version));
+#endif
+
+#ifdef PKG_USING_BC28_MQTT_FAULT
+/* fault injection */
+int  bc28_fault_run(const char *name, const char *path);
+#endif
+
+#ifdef PKG_USING_BC28_MQTT_LINK_MONITOR
+int  bc28_link_get(struct bc28_link_info *info);
+#endif
+
+#ifdef PKG_USING_BC28_MQTT_ADAPTIVE_KEEPALIVE
+void bc28_bind_keepalive_store(int (*load)(const char *cell, rt_uint32_t *keepalive),
+                               int (*save)(const char *cell, rt_uint32_t keepalive));
+#endif
 
 /* NB-IoT Network */
 int  bc28_init(void);
@@ -0,0 +1,701 @@
+/*
+ * Copyright (c) 2023, RudyLo <luhuadong@163.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     agent        the first version
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <rtthread.h>
+#include <rthw.h>
+
+#define DBG_TAG                       "pkg.bc28_aggr"
+#ifdef PKG_USING_BC28_MQTT_DEBUG
+#define DBG_LVL                       DBG_LOG
+#else
+#define DBG_LVL                       DBG_ERROR
+#endif
+#include <rtdbg.h>
+
+#include "bc28_mqtt_internal.h"
+
+#ifdef PKG_USING_BC28_MQTT_AGGR
+
+/*
+ * Telemetry aggregation. Every series owns a fixed ring of panes; a
+ * tumbling window is one pane, a sliding window of W ms moving every S ms
+ * is W / S panes of S ms. Samples only touch the current pane, so an
+ * update costs the same whatever the window and the number of series.
+ * When panes close, every series closing at that moment is summarised
+ * into one JSON message, split where the transport's payload limit or
+ * AGGR_MSG_LEN would be exceeded.
+ *
+ * Percentiles use the P-square estimator (Jain & Chlamtac), five markers
+ * per quantile. Estimators cannot be merged, so percentiles are available
+ * on tumbling windows only.
+ */
+
+#ifndef PKG_USING_BC28_MQTT_AGGR_SERIES
+#define PKG_USING_BC28_MQTT_AGGR_SERIES          16
+#endif
+#ifndef PKG_USING_BC28_MQTT_AGGR_PANES
+#define PKG_USING_BC28_MQTT_AGGR_PANES           6
+#endif
+#ifndef PKG_USING_BC28_MQTT_AGGR_DECIMALS
+#define PKG_USING_BC28_MQTT_AGGR_DECIMALS        2
+#endif
+#ifndef PKG_USING_BC28_MQTT_AGGR_MSG_LEN
+#define PKG_USING_BC28_MQTT_AGGR_MSG_LEN         512
+#endif
+#ifndef PKG_USING_BC28_MQTT_AGGR_TOPIC
+#define PKG_USING_BC28_MQTT_AGGR_TOPIC           "/" PKG_USING_BC28_MQTT_PRODUCT_KEY "/" \
+                                                 PKG_USING_BC28_MQTT_DEVICE_NAME "/user/update"
+#endif
+
+#define AGGR_SERIES                   PKG_USING_BC28_MQTT_AGGR_SERIES
+#define AGGR_PANES                    PKG_USING_BC28_MQTT_AGGR_PANES
+#define AGGR_DECIMALS                 PKG_USING_BC28_MQTT_AGGR_DECIMALS
+#define AGGR_MSG_LEN                  PKG_USING_BC28_MQTT_AGGR_MSG_LEN
+#define AGGR_TOPIC                    PKG_USING_BC28_MQTT_AGGR_TOPIC
+#define AGGR_NAME_MAX                 16
+#define AGGR_QUANTILES                3
+#define AGGR_THREAD_STACK             2048
+#define AGGR_THREAD_PRIORITY          (RT_THREAD_PRIORITY_MAX - 3)
+
+#define AGGR_STR(x)                   #x
+#define AGGR_XSTR(x)                  AGGR_STR(x)
+
+struct aggr_pane
+{
+    float        min;
+    float        max;
+    float        sum;
+    float        last;
+    rt_uint32_t  count;
+};
+
+#ifdef PKG_USING_BC28_MQTT_AGGR_PERCENTILE
+struct aggr_p2
+{
+    float        q[5];              /* marker heights */
+    float        n[5];              /* marker positions */
+    float        np[5];             /* desired positions */
+    float        dn[5];             /* desired position increments */
+    float        p;
+    rt_uint32_t  count;
+};
+#endif
+
+struct aggr_series
+{
+    char         name[AGGR_NAME_MAX];
+    rt_uint8_t   flags;             /* BC28_AGGR_xxx, 0 if the slot is free */
+    rt_uint8_t   panes;             /* 1 for a tumbling window */
+    rt_uint8_t   cur;
+    rt_uint32_t  pane_ms;
+    rt_tick_t    pane_end;
+    struct aggr_pane pane[AGGR_PANES];
+#ifdef PKG_USING_BC28_MQTT_AGGR_PERCENTILE
+    struct aggr_p2 p2[AGGR_QUANTILES];
+#endif
+};
+
+/* summary of one closed window */
+struct aggr_result
+{
+    struct aggr_pane all;
+#ifdef PKG_USING_BC28_MQTT_AGGR_PERCENTILE
+    float        quantile[AGGR_QUANTILES];
+#endif
+};
+
+static struct aggr_series series[AGGR_SERIES];
+static rt_thread_t aggr_tid = RT_NULL;
+static rt_sem_t    aggr_wake = RT_NULL;
+static rt_bool_t   aggr_flush_all = RT_FALSE;
+static rt_uint32_t aggr_published = 0, aggr_failed = 0;
+static char        aggr_msg[AGGR_MSG_LEN];
+
+#ifdef PKG_USING_BC28_MQTT_AGGR_PERCENTILE
+static const float   quantile_p[AGGR_QUANTILES]    = { 0.5f, 0.9f, 0.99f };
+static const char   *quantile_name[AGGR_QUANTILES] = { "p50", "p90", "p99" };
+static const rt_uint8_t quantile_flag[AGGR_QUANTILES] = { BC28_AGGR_P50, BC28_AGGR_P90, BC28_AGGR_P99 };
+
+static void p2_reset(struct aggr_p2 *e, float p)
+{
+    rt_memset(e, 0, sizeof(*e));
+    e->p = p;
+}
+
+static void p2_add(struct aggr_p2 *e, float x)
+{
+    float d = 0, s = 0, qp = 0, t = 0;
+    int i = 0, k = 0;
+
+    if (e->count < 5)
+    {
+        /* insertion sort of the first five samples */
+        for (i = e->count++; i > 0 && e->q[i - 1] > x; i--)
+        {
+            e->q[i] = e->q[i - 1];
+        }
+        e->q[i] = x;
+
+        if (e->count == 5)
+        {
+            for (i = 0; i < 5; i++)
+            {
+                e->n[i] = i;
+            }
+            e->np[0] = 0;  e->np[1] = 2 * e->p;  e->np[2] = 4 * e->p;  e->np[3] = 2 + 2 * e->p;  e->np[4] = 4;
+            e->dn[0] = 0;  e->dn[1] = e->p / 2;  e->dn[2] = e->p;      e->dn[3] = (1 + e->p) / 2; e->dn[4] = 1;
+        }
+        return;
+    }
+
+    if (x < e->q[0])
+    {
+        e->q[0] = x;
+        k = 0;
+    }
+    else if (x >= e->q[4])
+    {
+        e->q[4] = x;
+        k = 3;
+    }
+    else
+    {
+        for (k = 0; k < 3 && x >= e->q[k + 1]; k++);
+    }
+
+    for (i = k + 1; i < 5; i++)
+    {
+        e->n[i] += 1;
+    }
+    for (i = 0; i < 5; i++)
+    {
+        e->np[i] += e->dn[i];
+    }
+
+    for (i = 1; i < 4; i++)
+    {
+        d = e->np[i] - e->n[i];
+        if ((d >= 1 && e->n[i + 1] - e->n[i] > 1) || (d <= -1 && e->n[i - 1] - e->n[i] < -1))
+        {
+            s = d > 0 ? 1 : -1;
+
+            /* piecewise parabolic prediction, linear if it leaves the neighbours */
+            t  = (e->n[i] - e->n[i - 1] + s) * (e->q[i + 1] - e->q[i]) / (e->n[i + 1] - e->n[i]);
+            t += (e->n[i + 1] - e->n[i] - s) * (e->q[i] - e->q[i - 1]) / (e->n[i] - e->n[i - 1]);
+            qp = e->q[i] + s / (e->n[i + 1] - e->n[i - 1]) * t;
+
+            if (e->q[i - 1] < qp && qp < e->q[i + 1])
+            {
+                e->q[i] = qp;
+            }
+            else
+            {
+                k = i + (int)s;
+                e->q[i] += s * (e->q[k] - e->q[i]) / (e->n[k] - e->n[i]);
+            }
+            e->n[i] += s;
+        }
+    }
+
+    e->count++;
+}
+
+static float p2_get(const struct aggr_p2 *e)
+{
+    if (e->count >= 5)
+    {
+        return e->q[2];
+    }
+
+    /* too few samples for the markers, they are still sorted */
+    return e->q[(int)(e->p * (e->count - 1) + 0.5f)];
+}
+#endif /* PKG_USING_BC28_MQTT_AGGR_PERCENTILE */
+
+static void pane_reset(struct aggr_pane *pane)
+{
+    pane->count = 0;
+    pane->sum   = 0;
+}
+
+/* O(1), interrupts are off around it */
+static void aggr_add(struct aggr_series *s, float value)
+{
+    struct aggr_pane *pane = &s->pane[s->cur];
+
+    if (pane->count == 0 || value < pane->min) pane->min = value;
+    if (pane->count == 0 || value > pane->max) pane->max = value;
+    pane->sum += value;
+    pane->last = value;
+    pane->count++;
+
+#ifdef PKG_USING_BC28_MQTT_AGGR_PERCENTILE
+    for (int i = 0; i < AGGR_QUANTILES; i++)
+    {
+        if (s->flags & quantile_flag[i])
+        {
+            p2_add(&s->p2[i], value);
+        }
+    }
+#endif
+}
+
+/**
+ * Summarise the window ending with the current pane and open the next pane.
+ * Interrupts are off around it.
+ */
+static void aggr_close(struct aggr_series *s, struct aggr_result *r)
+{
+    struct aggr_pane *all = &r->all;
+    struct aggr_pane *pane = RT_NULL;
+
+    rt_memset(r, 0, sizeof(*r));
+
+    /* oldest first so that last is the latest sample */
+    for (int i = 1; i <= s->panes; i++)
+    {
+        pane = &s->pane[(s->cur + i) % s->panes];
+        if (pane->count == 0)
+        {
+            continue;
+        }
+        if (all->count == 0 || pane->min < all->min) all->min = pane->min;
+        if (all->count == 0 || pane->max > all->max) all->max = pane->max;
+        all->sum  += pane->sum;
+        all->last  = pane->last;
+        all->count += pane->count;
+    }
+
+#ifdef PKG_USING_BC28_MQTT_AGGR_PERCENTILE
+    for (int i = 0; i < AGGR_QUANTILES; i++)
+    {
+        if (s->flags & quantile_flag[i])
+        {
+            r->quantile[i] = p2_get(&s->p2[i]);
+            p2_reset(&s->p2[i], quantile_p[i]);
+        }
+    }
+#endif
+
+    /* the next pane takes the place of the oldest one */
+    s->cur = (s->cur + 1) % s->panes;
+    pane_reset(&s->pane[s->cur]);
+}
+
+static int aggr_fmt(char *buf, rt_size_t size, float v)
+{
+    const rt_uint32_t scale = (AGGR_DECIMALS == 0) ? 1 : (AGGR_DECIMALS == 1) ? 10 :
+                              (AGGR_DECIMALS == 2) ? 100 : 1000;
+    const char *sign = "";
+    rt_uint32_t fixed = 0;
+
+    /* rt_snprintf has no %f, print fixed point */
+    if (v != v)
+    {
+        return rt_snprintf(buf, size, "null");
+    }
+    if (v < 0)
+    {
+        sign = "-";
+        v = -v;
+    }
+    if (v > 4.0e9f / scale)
+    {
+        v = 4.0e9f / scale;
+    }
+
+    fixed = (rt_uint32_t)(v * scale + 0.5f);
+#if AGGR_DECIMALS == 0
+    return rt_snprintf(buf, size, "%s%u", sign, fixed);
+#else
+    return rt_snprintf(buf, size, "%s%u.%0" AGGR_XSTR(AGGR_DECIMALS) "u", sign, fixed / scale, fixed % scale);
+#endif
+}
+
+static int aggr_format(char *buf, rt_size_t size, const struct aggr_series *s, const struct aggr_result *r)
+{
+    rt_size_t n = 0;
+
+#define AGGR_PUT(...)  do { n += rt_snprintf(buf + n, size > n ? size - n : 0, __VA_ARGS__); } while (0)
+#define AGGR_NUM(key, v)  do { AGGR_PUT(",\"" key "\":"); n += aggr_fmt(buf + n, size > n ? size - n : 0, v); } while (0)
+
+    AGGR_PUT("\"%s\":{\"n\":%u", s->name, r->all.count);
+    if (s->flags & BC28_AGGR_MIN)  AGGR_NUM("min", r->all.min);
+    if (s->flags & BC28_AGGR_MAX)  AGGR_NUM("max", r->all.max);
+    if (s->flags & BC28_AGGR_MEAN) AGGR_NUM("avg", r->all.sum / r->all.count);
+    if (s->flags & BC28_AGGR_LAST) AGGR_NUM("last", r->all.last);
+#ifdef PKG_USING_BC28_MQTT_AGGR_PERCENTILE
+    for (int i = 0; i < AGGR_QUANTILES; i++)
+    {
+        if (s->flags & quantile_flag[i])
+        {
+            AGGR_PUT(",\"%s\":", quantile_name[i]);
+            n += aggr_fmt(buf + n, size > n ? size - n : 0, r->quantile[i]);
+        }
+    }
+#endif
+    AGGR_PUT("}");
+
+#undef AGGR_NUM
+#undef AGGR_PUT
+
+    return n < size ? (int)n : -1;
+}
+
+static void aggr_publish(rt_size_t len)
+{
+    if (len <= 1)
+    {
+        return;
+    }
+
+    aggr_msg[len]     = '}';
+    aggr_msg[len + 1] = '\0';
+
+    if (bc28_mqtt_publish(AGGR_TOPIC, aggr_msg) == RT_EOK)
+    {
+        aggr_published++;
+    }
+    else
+    {
+        aggr_failed++;
+    }
+}
+
+static void aggr_thread_entry(void *parameter)
+{
+    struct aggr_result r;
+    char item[192];
+    rt_base_t level;
+    rt_tick_t now = 0, next = 0;
+    rt_size_t len = 0, size = 0;
+    rt_bool_t all = RT_FALSE;
+    int n = 0;
+
+    while (1)
+    {
+        /* sleep until the earliest pane ends */
+        now  = rt_tick_get();
+        next = now + RT_TICK_PER_SECOND * 60;
+        for (int i = 0; i < AGGR_SERIES; i++)
+        {
+            if (series[i].flags && (rt_int32_t)(series[i].pane_end - next) < 0)
+            {
+                next = series[i].pane_end;
+            }
+        }
+        if ((rt_int32_t)(next - now) > 0)
+        {
+            rt_sem_take(aggr_wake, next - now);
+        }
+
+        now = rt_tick_get();
+        all = aggr_flush_all;
+        aggr_flush_all = RT_FALSE;
+
+        /* every window closing now goes into one message, split where
+         * the buffer or the transport's payload limit ends */
+        size = bc28_mqtt_payload_max() + 1;
+        if (size > AGGR_MSG_LEN)
+        {
+            size = AGGR_MSG_LEN;
+        }
+        aggr_msg[0] = '{';
+        len = 1;
+
+        for (int i = 0; i < AGGR_SERIES; i++)
+        {
+            struct aggr_series *s = &series[i];
+
+            if (!s->flags || (!all && (rt_int32_t)(s->pane_end - now) > 0))
+            {
+                continue;
+            }
+
+            level = rt_hw_interrupt_disable();
+            aggr_close(s, &r);
+            s->pane_end += rt_tick_from_millisecond(s->pane_ms);
+            if ((rt_int32_t)(s->pane_end - now) <= 0 || all)
+            {
+                /* fell behind or flushed: realign to now */
+                s->pane_end = now + rt_tick_from_millisecond(s->pane_ms);
+            }
+            rt_hw_interrupt_enable(level);
+
+            if (r.all.count == 0 || (n = aggr_format(item, sizeof(item), s, &r)) < 0)
+            {
+                continue;
+            }
+
+            /* one separator, one closing brace and the terminator */
+            if (len + n + 3 > size)
+            {
+                aggr_publish(len);
+                len = 1;
+            }
+            if (len + n + 3 > size)
+            {
+                LOG_W("%s does not fit one message, dropped.", s->name);
+                continue;
+            }
+            if (len > 1)
+            {
+                aggr_msg[len++] = ',';
+            }
+            rt_memcpy(aggr_msg + len, item, n);
+            len += n;
+        }
+
+        aggr_publish(len);
+    }
+}
+
+static int aggr_start(void)
+{
+    if (aggr_tid)
+    {
+        return RT_EOK;
+    }
+
+    aggr_wake = rt_sem_create("bc28agg", 0, RT_IPC_FLAG_FIFO);
+    if (aggr_wake == RT_NULL)
+    {
+        return -RT_ENOMEM;
+    }
+
+    aggr_tid = rt_thread_create("bc28agg", aggr_thread_entry, RT_NULL,
+                                AGGR_THREAD_STACK, AGGR_THREAD_PRIORITY, 10);
+    if (aggr_tid == RT_NULL)
+    {
+        LOG_E("create aggregation thread failed.");
+        return -RT_ENOMEM;
+    }
+
+    return rt_thread_startup(aggr_tid);
+}
+
+static int aggr_setup(struct aggr_series *s, const char *name, rt_uint32_t window, rt_uint32_t slide, rt_uint8_t flags)
+{
+    if (slide == 0)
+    {
+        slide = window;
+    }
+    if (window == 0 || window % slide || window / slide > AGGR_PANES || flags == 0)
+    {
+        return -RT_EINVAL;
+    }
+
+#ifdef PKG_USING_BC28_MQTT_AGGR_PERCENTILE
+    if ((flags & BC28_AGGR_PERCENTILES) && window != slide)
+    {
+        LOG_E("percentiles need a tumbling window.");
+        return -RT_EINVAL;
+    }
+#else
+    if (flags & BC28_AGGR_PERCENTILES)
+    {
+        LOG_E("enable PKG_USING_BC28_MQTT_AGGR_PERCENTILE for percentiles.");
+        return -RT_ENOSYS;
+    }
+#endif
+
+    rt_memset(s, 0, sizeof(*s));
+    rt_strncpy(s->name, name, AGGR_NAME_MAX - 1);
+    s->panes    = window / slide;
+    s->pane_ms  = slide;
+    s->pane_end = rt_tick_get() + rt_tick_from_millisecond(slide);
+#ifdef PKG_USING_BC28_MQTT_AGGR_PERCENTILE
+    for (int i = 0; i < AGGR_QUANTILES; i++)
+    {
+        p2_reset(&s->p2[i], quantile_p[i]);
+    }
+#endif
+    s->flags = flags;
+
+    return RT_EOK;
+}
+
+/**
+ * Create an aggregated series.
+ *
+ * @param name   : property name, the key in the published JSON
+ * @param window : window length in ms
+ * @param slide  : a window is published every slide ms, 0 or window for
+ *                 a tumbling window; window must be a multiple of slide
+ *                 and at most PKG_USING_BC28_MQTT_AGGR_PANES slides long
+ * @param flags  : BC28_AGGR_xxx
+ *
+ * @return >=0 : handle for bc28_aggr_update()
+ *          <0 : failed, -RT_EFULL if all PKG_USING_BC28_MQTT_AGGR_SERIES are used
+ */
+int bc28_aggr_create(const char *name, rt_uint32_t window, rt_uint32_t slide, rt_uint8_t flags)
+{
+    int result = 0;
+
+    if ((result = aggr_start()) != RT_EOK)
+    {
+        return result;
+    }
+
+    for (int i = 0; i < AGGR_SERIES; i++)
+    {
+        if (series[i].flags == 0)
+        {
+            if ((result = aggr_setup(&series[i], name, window, slide, flags)) != RT_EOK)
+            {
+                return result;
+            }
+            rt_sem_release(aggr_wake);
+            return i;
+        }
+    }
+
+    return -RT_EFULL;
+}
+
+/**
+ * Delete a series, samples not yet published are discarded.
+ *
+ * @return void
+ */
+void bc28_aggr_delete(int handle)
+{
+    if (handle >= 0 && handle < AGGR_SERIES)
+    {
+        series[handle].flags = 0;
+    }
+}
+
+/**
+ * Add a sample. Constant time, may be called from interrupts.
+ *
+ * @return void
+ */
+void bc28_aggr_update(int handle, float value)
+{
+    rt_base_t level;
+
+    if (handle < 0 || handle >= AGGR_SERIES)
+    {
+        return;
+    }
+
+    level = rt_hw_interrupt_disable();
+    if (series[handle].flags)
+    {
+        aggr_add(&series[handle], value);
+    }
+    rt_hw_interrupt_enable(level);
+}
+
+/**
+ * Close every window now and publish what has been collected, e.g. before
+ * the device goes to sleep.
+ *
+ * @return void
+ */
+void bc28_aggr_flush(void)
+{
+    if (aggr_wake)
+    {
+        aggr_flush_all = RT_TRUE;
+        rt_sem_release(aggr_wake);
+    }
+}
+
+#ifdef FINSH_USING_MSH
+static void bc28_aggr_info(void)
+{
+    rt_kprintf("published : %u, failed %u\n", aggr_published, aggr_failed);
+
+    for (int i = 0; i < AGGR_SERIES; i++)
+    {
+        if (series[i].flags)
+        {
+            rt_kprintf("[%d] %-16s window %u ms, slide %u ms, %u samples in pane\n", i, series[i].name,
+                       series[i].pane_ms * series[i].panes, series[i].pane_ms, series[i].pane[series[i].cur].count);
+        }
+    }
+}
+MSH_CMD_EXPORT(bc28_aggr_info, show aggregated series);
+
+/* update cost per sample over many series, on the target itself */
+static void bc28_aggr_bench(int argc, char *argv[])
+{
+    int count = argc >= 2 ? atoi(argv[1]) : 64;
+    rt_uint32_t samples = argc >= 3 ? atoi(argv[2]) : 100000;
+    static const struct { const char *name; rt_uint32_t slide; rt_uint8_t flags; } mode[] = {
+        { "tumbling", 60000, BC28_AGGR_BASIC },
+        { "sliding",  10000, BC28_AGGR_BASIC },
+#ifdef PKG_USING_BC28_MQTT_AGGR_PERCENTILE
+        { "p50/p90/p99", 60000, BC28_AGGR_BASIC | BC28_AGGR_PERCENTILES },
+#endif
+    };
+    struct aggr_series *pool = RT_NULL;
+    struct aggr_result r;
+    rt_base_t level;
+    rt_tick_t start = 0, ticks = 0;
+    rt_uint32_t x = 1;
+
+    if (count <= 0 || samples == 0)
+    {
+        rt_kprintf("Usage: bc28_aggr_bench [series] [samples]\n");
+        return;
+    }
+
+    /* a private pool so the live series are not disturbed */
+    pool = rt_malloc(sizeof(struct aggr_series) * count);
+    if (pool == RT_NULL)
+    {
+        rt_kprintf("no memory for %d series (%u bytes each)\n", count, (unsigned int)sizeof(struct aggr_series));
+        return;
+    }
+
+    rt_kprintf("%d series, %u samples, %u bytes per series\n", count, samples, (unsigned int)sizeof(struct aggr_series));
+
+    for (rt_size_t m = 0; m < sizeof(mode) / sizeof(mode[0]); m++)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            aggr_setup(&pool[i], "bench", 60000, mode[m].slide, mode[m].flags);
+        }
+
+        start = rt_tick_get();
+        for (rt_uint32_t i = 0; i < samples; i++)
+        {
+            /* cheap pseudo random samples, same sequence for every mode */
+            x = x * 1103515245 + 12345;
+            level = rt_hw_interrupt_disable();
+            aggr_add(&pool[i % count], (float)((x >> 16) & 0x3FF) / 10);
+            rt_hw_interrupt_enable(level);
+        }
+        ticks = rt_tick_get() - start;
+
+        start = rt_tick_get();
+        for (int i = 0; i < count; i++)
+        {
+            aggr_close(&pool[i], &r);
+        }
+
+        rt_kprintf("%-12s update %u ns/sample, close %u us/series\n", mode[m].name,
+                   (rt_uint32_t)((rt_uint64_t)ticks * 1000000000 / RT_TICK_PER_SECOND / samples),
+                   (rt_tick_get() - start) * 1000000 / RT_TICK_PER_SECOND / count);
+    }
+
+    rt_free(pool);
+}
+MSH_CMD_EXPORT(bc28_aggr_bench, benchmark aggregation update cost);
+#endif
+
+#endif /* PKG_USING_BC28_MQTT_AGGR */
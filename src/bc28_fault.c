@@ -0,0 +1,597 @@
+/*
+ * Copyright (c) 2023, RudyLo <luhuadong@163.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     agent        the first version
+ * 2026-10-19     agent        report reconnect latency per phase
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <rtthread.h>
+#include <rtdevice.h>
+#include <at.h>
+
+#define DBG_TAG                       "pkg.bc28_fault"
+#ifdef PKG_USING_BC28_MQTT_DEBUG
+#define DBG_LVL                       DBG_LOG
+#else
+#define DBG_LVL                       DBG_ERROR
+#endif
+#include <rtdbg.h>
+
+#include "bc28_mqtt_internal.h"
+
+#ifdef PKG_USING_BC28_MQTT_FAULT
+
+#ifndef PKG_USING_BC28_MQTT_TAP
+#error "PKG_USING_BC28_MQTT_FAULT filters the module through the tap, enable PKG_USING_BC28_MQTT_TAP"
+#endif
+
+/*
+ * Fault injection scenarios, run on the target against the real module or
+ * on the host against the emulated one (tests/run.sh fault).
+ * The tap hands everything the module sends to a filter thread that
+ * drops, holds back or adds lines on their way to the AT client, while a
+ * publisher thread keeps the link busy. Each scenario prints one JSON
+ * line with the time to recover, the publishes lost and memory figures.
+ */
+
+#ifndef PKG_USING_BC28_MQTT_FAULT_TOPIC
+#define PKG_USING_BC28_MQTT_FAULT_TOPIC          PKG_USING_BC28_MQTT_PRODUCT_KEY "/" \
+                                                 PKG_USING_BC28_MQTT_DEVICE_NAME "/user/update"
+#endif
+
+#define FAULT_TOPIC                   PKG_USING_BC28_MQTT_FAULT_TOPIC
+#define FAULT_LINE_MAX                256
+#define FAULT_ENTRY_LEN               96
+#define FAULT_QUEUE_LEN               8
+#define FAULT_PARTIAL_MS              20         /* flush a line without '\n' (the '>' prompt) */
+#define FAULT_PUB_PERIOD              500
+#define FAULT_BASELINE                (FAULT_PUB_PERIOD * 4)
+#define FAULT_TIMEOUT                 180000
+#define FAULT_STORM_COUNT             20
+#define FAULT_STORM_GAP               50
+#define FAULT_DELAY                   3000
+#define FAULT_RESET_PULSE             300
+#define FAULT_THREAD_STACK            1536
+#define FAULT_THREAD_PRIORITY         (RT_THREAD_PRIORITY_MAX / 2 - 1)
+
+/* RT_VERSION_CHECK() is not there before 4.1, it cannot share the #if */
+#if defined(RT_VERSION_CHECK)
+#if RTTHREAD_VERSION >= RT_VERSION_CHECK(5, 0, 0)
+#define FAULT_MEM_SIZE_T
+#endif
+#endif
+#ifdef FAULT_MEM_SIZE_T
+typedef rt_size_t fault_mem_t;
+#else
+typedef rt_uint32_t fault_mem_t;
+#endif
+
+enum fault_action
+{
+    FAULT_PASS = 0,
+    FAULT_DROP,
+    FAULT_HOLD
+};
+
+struct fault_scenario
+{
+    const char  *name;
+    const char  *match;             /* module lines to act on, RT_NULL for none */
+    rt_uint8_t   action;
+    rt_uint8_t   count;             /* matching lines to act on, 0 for all */
+    rt_bool_t    recover;           /* expected to go through the recovery worker */
+    void       (*trigger)(int arg);
+    int          arg;
+};
+
+struct fault_entry
+{
+    rt_tick_t    due;
+    rt_uint16_t  len;
+    char         data[FAULT_ENTRY_LEN];
+};
+
+static struct
+{
+    const struct fault_scenario *sc;
+    volatile rt_bool_t running;
+    rt_sem_t     notify;
+    rt_sem_t     done;
+    rt_mutex_t   qlock;
+
+    /* filter */
+    char         line[FAULT_LINE_MAX];
+    rt_size_t    line_len;
+    rt_tick_t    line_tick;
+    int          left;
+    rt_uint32_t  hits;
+    struct fault_entry queue[FAULT_QUEUE_LEN];
+    int          head, count;
+
+    /* publisher */
+    rt_uint32_t  published;
+    rt_uint32_t  lost;
+    rt_uint32_t  recoveries;        /* before the trigger */
+    rt_tick_t    triggered;
+    rt_tick_t    recovered;
+
+    rt_thread_t  filter_tid;
+    rt_thread_t  publisher_tid;
+
+} fault;
+
+/* call with qlock held */
+static void fault_release(rt_bool_t all)
+{
+    struct fault_entry *e = RT_NULL;
+
+    while (fault.count > 0)
+    {
+        e = &fault.queue[fault.head];
+        if (!all && (rt_int32_t)(e->due - rt_tick_get()) > 0)
+        {
+            break;
+        }
+
+        bc28_tap_feed(e->data, e->len);
+        fault.head = (fault.head + 1) % FAULT_QUEUE_LEN;
+        fault.count--;
+    }
+}
+
+/* queue behind what is held back so the order on the wire is kept */
+static void fault_queue(const char *data, rt_size_t len, rt_uint32_t delay)
+{
+    rt_tick_t due = rt_tick_get() + rt_tick_from_millisecond(delay);
+    struct fault_entry *e = RT_NULL;
+
+    rt_mutex_take(fault.qlock, RT_WAITING_FOREVER);
+
+    if (fault.count == 0 && delay == 0)
+    {
+        bc28_tap_feed(data, len);
+    }
+    else if (fault.count == FAULT_QUEUE_LEN || len > FAULT_ENTRY_LEN)
+    {
+        /* no room to hold it, give up the delay rather than the order */
+        fault_release(RT_TRUE);
+        bc28_tap_feed(data, len);
+    }
+    else
+    {
+        if (fault.count > 0)
+        {
+            e = &fault.queue[(fault.head + fault.count - 1) % FAULT_QUEUE_LEN];
+            if ((rt_int32_t)(e->due - due) > 0)
+            {
+                due = e->due;
+            }
+        }
+
+        e = &fault.queue[(fault.head + fault.count) % FAULT_QUEUE_LEN];
+        e->due = due;
+        e->len = len;
+        rt_memcpy(e->data, data, len);
+        fault.count++;
+    }
+
+    rt_mutex_release(fault.qlock);
+}
+
+static void fault_inject(const char *text)
+{
+    fault_queue(text, strlen(text), 0);
+}
+
+static void fault_line(void)
+{
+    const struct fault_scenario *sc = fault.sc;
+    rt_uint8_t action = FAULT_PASS;
+
+    if (sc->match && fault.left != 0 && !strncmp(fault.line, sc->match, strlen(sc->match)))
+    {
+        if (fault.left > 0)
+        {
+            fault.left--;
+        }
+        fault.hits++;
+        action = sc->action;
+    }
+
+    if (action != FAULT_DROP)
+    {
+        fault_queue(fault.line, fault.line_len, action == FAULT_HOLD ? FAULT_DELAY : 0);
+    }
+    fault.line_len = 0;
+}
+
+static void fault_filter_entry(void *parameter)
+{
+    char ch = 0;
+
+    while (fault.running)
+    {
+        rt_sem_take(fault.notify, rt_tick_from_millisecond(FAULT_PARTIAL_MS / 2));
+
+        while (bc28_tap_uart_read(&ch, 1) == 1)
+        {
+            fault.line[fault.line_len++] = ch;
+            fault.line_tick = rt_tick_get();
+
+            if (ch == '\n' || fault.line_len == FAULT_LINE_MAX)
+            {
+                fault_line();
+            }
+        }
+
+        if (fault.line_len && rt_tick_get() - fault.line_tick > rt_tick_from_millisecond(FAULT_PARTIAL_MS))
+        {
+            fault_line();
+        }
+
+        rt_mutex_take(fault.qlock, RT_WAITING_FOREVER);
+        fault_release(RT_FALSE);
+        rt_mutex_release(fault.qlock);
+    }
+
+    /* nothing held back outlives the scenario */
+    if (fault.line_len)
+    {
+        fault_line();
+    }
+    rt_mutex_take(fault.qlock, RT_WAITING_FOREVER);
+    fault_release(RT_TRUE);
+    rt_mutex_release(fault.qlock);
+
+    rt_sem_release(fault.done);
+}
+
+static void fault_publisher_entry(void *parameter)
+{
+    struct bc28_recovery_info info;
+    char msg[32];
+
+    while (fault.running)
+    {
+        rt_snprintf(msg, sizeof(msg), "{\"seq\":%u}", fault.published++);
+
+        if (bc28_mqtt_publish(FAULT_TOPIC, msg) != RT_EOK)
+        {
+            fault.lost++;
+        }
+        else if (fault.triggered && !fault.recovered)
+        {
+            /* the first publish that gets through once the link is back */
+            bc28_recovery_get(&info);
+            if (!info.pending && (!fault.sc->recover || info.recoveries > fault.recoveries))
+            {
+                fault.recovered = rt_tick_get();
+            }
+        }
+
+        rt_thread_mdelay(FAULT_PUB_PERIOD);
+    }
+
+    rt_sem_release(fault.done);
+}
+
+static void fault_stat(int code)
+{
+    char text[24];
+
+    rt_snprintf(text, sizeof(text), "\r\n+QMTSTAT: 0,%d\r\n", code);
+    fault_inject(text);
+}
+
+static void fault_storm(int code)
+{
+    for (int i = 0; i < FAULT_STORM_COUNT; i++)
+    {
+        fault_stat(code);
+        rt_thread_mdelay(FAULT_STORM_GAP);
+    }
+}
+
+static void fault_garble(int arg)
+{
+    static const char *garbage[] = {
+        "\r\n+QMTSTAT: \r\n",
+        "\r\n+QMTSTAT: 0,99\r\n",
+        "\r\n+QMTSTAT: x,\xff\r\n",
+        "\r\n+QMTRECV: 0,1,\"" FAULT_TOPIC "\r\n",
+        "\r\n+QMTRECV: \r\n",
+        "\r\n+CEREG:\r\n",
+        "\r\n+CEREG:1,\"\r\n",
+        "\r\n\xfe\xff\x01+QMT\r\n",
+        "\r\nNeu\r\n",
+    };
+
+    for (rt_size_t i = 0; i < sizeof(garbage) / sizeof(garbage[0]); i++)
+    {
+        fault_inject(garbage[i]);
+    }
+}
+
+static void fault_reboot(int arg)
+{
+    /* pulse the reset line while the publisher is busy */
+    rt_pin_mode(PKG_USING_BC28_RESET_PIN, PIN_MODE_OUTPUT);
+    rt_pin_write(PKG_USING_BC28_RESET_PIN, PIN_HIGH);
+    rt_thread_mdelay(FAULT_RESET_PULSE);
+    rt_pin_write(PKG_USING_BC28_RESET_PIN, PIN_LOW);
+}
+
+static void fault_deregister(int arg)
+{
+    at_obj_exec_cmd(bc28_get_device()->client, RT_NULL, "AT+CGATT=0");
+}
+
+static const struct fault_scenario scenarios[] = {
+    { "delayed_ok",         "OK",        FAULT_HOLD, 0, RT_TRUE,  fault_stat,       1 },
+    { "drop_qmtopen",       "+QMTOPEN:", FAULT_DROP, 2, RT_TRUE,  fault_stat,       1 },
+    { "qmtstat_storm_1",    RT_NULL,     FAULT_PASS, 0, RT_TRUE,  fault_storm,      1 },
+    { "qmtstat_storm_2",    RT_NULL,     FAULT_PASS, 0, RT_TRUE,  fault_storm,      2 },
+    { "qmtstat_storm_3",    RT_NULL,     FAULT_PASS, 0, RT_TRUE,  fault_storm,      3 },
+    { "qmtstat_storm_4",    RT_NULL,     FAULT_PASS, 0, RT_TRUE,  fault_storm,      4 },
+    { "qmtstat_storm_5",    RT_NULL,     FAULT_PASS, 0, RT_FALSE, fault_storm,      5 },
+    { "qmtstat_storm_6",    RT_NULL,     FAULT_PASS, 0, RT_TRUE,  fault_storm,      6 },
+    { "qmtstat_storm_7",    RT_NULL,     FAULT_PASS, 0, RT_TRUE,  fault_storm,      7 },
+    { "garbled_urc",        RT_NULL,     FAULT_PASS, 0, RT_FALSE, fault_garble,     0 },
+    { "reboot_mid_publish", RT_NULL,     FAULT_PASS, 0, RT_TRUE,  fault_reboot,     0 },
+    { "deregister",         RT_NULL,     FAULT_PASS, 0, RT_TRUE,  fault_deregister, 0 },
+};
+
+static rt_uint32_t fault_stack_used(rt_thread_t tid)
+{
+    rt_uint8_t *p = RT_NULL;
+
+    if (tid == RT_NULL)
+    {
+        return 0;
+    }
+
+    /* stacks are filled with '#' when the thread is created */
+#ifdef ARCH_CPU_STACK_GROWS_UPWARD
+    p = (rt_uint8_t *)tid->stack_addr + tid->stack_size - 1;
+    while (p > (rt_uint8_t *)tid->stack_addr && *p == '#') p--;
+    return p - (rt_uint8_t *)tid->stack_addr + 1;
+#else
+    p = (rt_uint8_t *)tid->stack_addr;
+    while (p < (rt_uint8_t *)tid->stack_addr + tid->stack_size && *p == '#') p++;
+    return tid->stack_size - (p - (rt_uint8_t *)tid->stack_addr);
+#endif
+}
+
+/* the heap keeps one high-water mark since boot, it cannot be reset per scenario */
+static void fault_heap(fault_mem_t *used, fault_mem_t *max_since_boot)
+{
+    *used = *max_since_boot = 0;
+#ifdef RT_USING_HEAP
+    fault_mem_t total = 0;
+    rt_memory_info(&total, used, max_since_boot);
+#endif
+}
+
+static rt_bool_t fault_link_up(void)
+{
+    struct bc28_recovery_info info;
+
+    bc28_recovery_get(&info);
+    return bc28_get_device()->stat == BC28_STAT_CONNECTED && !info.pending;
+}
+
+static rt_thread_t fault_thread(const char *name, void (*entry)(void *))
+{
+    rt_thread_t tid = rt_thread_create(name, entry, RT_NULL, FAULT_THREAD_STACK, FAULT_THREAD_PRIORITY, 10);
+
+    if (tid)
+    {
+        rt_thread_startup(tid);
+    }
+
+    return tid;
+}
+
+/**
+ * Run one scenario and report it as a JSON line.
+ *
+ * @param sc : scenario
+ * @param fd : file the line is appended to, -1 for the console only
+ *
+ * @return 0 : recovered
+ *        <0 : not run or not recovered in time
+ */
+static int fault_run(const struct fault_scenario *sc, int fd)
+{
+    struct bc28_recovery_info before, after;
+    fault_mem_t used0 = 0, used1 = 0, heap_max = 0;
+    rt_tick_t deadline = rt_tick_get() + rt_tick_from_millisecond(FAULT_TIMEOUT);
+    char json[384];
+    int n = 0, threads = 0;
+
+    while (!fault_link_up())
+    {
+        if ((rt_int32_t)(deadline - rt_tick_get()) <= 0)
+        {
+            rt_kprintf("{\"scenario\":\"%s\",\"result\":\"skipped\"}\n", sc->name);
+            return -RT_EBUSY;
+        }
+        rt_thread_mdelay(100);
+    }
+
+    fault.sc        = sc;
+    fault.left      = sc->count ? sc->count : -1;
+    fault.line_len  = 0;
+    fault.hits      = 0;
+    fault.head      = 0;
+    fault.count     = 0;
+    fault.published = 0;
+    fault.lost      = 0;
+    fault.triggered = 0;
+    fault.recovered = 0;
+    fault.running   = RT_TRUE;
+
+    bc28_recovery_get(&before);
+    fault.recoveries = before.recoveries;
+    fault_heap(&used0, &heap_max);
+
+    if (bc28_tap_filter(fault.notify) != RT_EOK)
+    {
+        LOG_E("tap is busy, stop recording or replay first.");
+        fault.running = RT_FALSE;
+        return -RT_EBUSY;
+    }
+
+    fault.filter_tid    = fault_thread("bc28flt", fault_filter_entry);
+    fault.publisher_tid = fault_thread("bc28pub", fault_publisher_entry);
+    threads = (fault.filter_tid != RT_NULL) + (fault.publisher_tid != RT_NULL);
+
+    if (threads == 2)
+    {
+        rt_thread_mdelay(FAULT_BASELINE);
+
+        fault.triggered = rt_tick_get();
+        sc->trigger(sc->arg);
+
+        deadline = fault.triggered + rt_tick_from_millisecond(FAULT_TIMEOUT);
+        while (!fault.recovered && (rt_int32_t)(deadline - rt_tick_get()) > 0)
+        {
+            rt_thread_mdelay(100);
+        }
+    }
+
+    n = rt_snprintf(json, sizeof(json),
+                    "{\"scenario\":\"%s\",\"result\":\"%s\",\"ttr_ms\":%u,",
+                    sc->name, fault.recovered ? "pass" : (threads == 2 ? "timeout" : "no_memory"),
+                    fault.recovered ? (fault.recovered - fault.triggered) * 1000 / RT_TICK_PER_SECOND : 0);
+
+    /* stack figures of the test threads are taken before they exit */
+    n += rt_snprintf(json + n, sizeof(json) - n,
+                     "\"stack\":{\"at\":%u,\"recovery\":%u,\"filter\":%u,\"publisher\":%u},",
+                     fault_stack_used(bc28_get_device()->client->parser),
+                     fault_stack_used(before.tid),
+                     fault_stack_used(fault.filter_tid),
+                     fault_stack_used(fault.publisher_tid));
+
+    fault.running = RT_FALSE;
+    while (threads--)
+    {
+        rt_sem_take(fault.done, RT_WAITING_FOREVER);
+    }
+    bc28_tap_filter(RT_NULL);
+
+    bc28_recovery_get(&after);
+    fault_heap(&used1, &heap_max);
+
+    n += rt_snprintf(json + n, sizeof(json) - n,
+                     "\"recoveries\":%u,\"attempts\":%u,\"published\":%u,\"lost\":%u,\"matched\":%u,"
+                     "\"phase_ms\":{\"cfg\":%u,\"open\":%u,\"conn\":%u,\"resub\":%u},"
+                     "\"heap_max_since_boot\":%u,\"heap_delta\":%d}\n",
+                     after.recoveries - before.recoveries, after.attempts - before.attempts,
+                     fault.published, fault.lost, fault.hits,
+                     after.cfg_ms, after.open_ms, after.conn_ms, after.resub_ms,
+                     (rt_uint32_t)heap_max, (int)(used1 - used0));
+
+    rt_kprintf("%s", json);
+    if (fd >= 0)
+    {
+        write(fd, json, n);
+    }
+
+    return fault.recovered ? RT_EOK : -RT_ETIMEOUT;
+}
+
+/**
+ * Run a fault scenario, or all of them.
+ *
+ * @param name : scenario name, RT_NULL or "all" for every scenario
+ * @param path : JSON lines are appended to this file, RT_NULL for the console only
+ *
+ * @return number of scenarios that did not recover, <0 on error
+ */
+int bc28_fault_run(const char *name, const char *path)
+{
+    int fd = -1, failed = 0, found = 0;
+
+    if (fault.notify == RT_NULL)
+    {
+        fault.notify = rt_sem_create("bc28flt", 0, RT_IPC_FLAG_FIFO);
+        fault.done   = rt_sem_create("bc28fld", 0, RT_IPC_FLAG_FIFO);
+        fault.qlock  = rt_mutex_create("bc28flt", RT_IPC_FLAG_PRIO);
+        if (!fault.notify || !fault.done || !fault.qlock)
+        {
+            LOG_E("No memory for fault injection!");
+            return -RT_ENOMEM;
+        }
+    }
+
+    if (path)
+    {
+        fd = open(path, O_WRONLY | O_CREAT | O_APPEND, 0);
+        if (fd < 0)
+        {
+            LOG_E("open %s failed.", path);
+            return -RT_EIO;
+        }
+    }
+
+    for (rt_size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++)
+    {
+        if (name == RT_NULL || !strcmp(name, "all") || !strcmp(name, scenarios[i].name))
+        {
+            found++;
+            if (fault_run(&scenarios[i], fd) != RT_EOK)
+            {
+                failed++;
+            }
+        }
+    }
+
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+
+    if (!found)
+    {
+        LOG_E("no scenario named %s.", name);
+        return -RT_EINVAL;
+    }
+
+    return failed;
+}
+
+#ifdef FINSH_USING_MSH
+static void bc28_fault(int argc, char *argv[])
+{
+    if (argc >= 2 && !strcmp(argv[1], "run"))
+    {
+        bc28_fault_run(argc >= 3 ? argv[2] : RT_NULL, argc >= 4 ? argv[3] : RT_NULL);
+        return;
+    }
+
+    if (argc >= 2 && strcmp(argv[1], "list"))
+    {
+        rt_kprintf("Usage: bc28_fault [list | run [name|all] [file]]\n");
+        return;
+    }
+
+    for (rt_size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++)
+    {
+        rt_kprintf("%s\n", scenarios[i].name);
+    }
+}
+MSH_CMD_EXPORT(bc28_fault, run fault injection scenarios);
+#endif
+
+#endif /* PKG_USING_BC28_MQTT_FAULT */
@@ -10,11 +10,21 @@
  * 2020-07-25     luhuadong    support state transition
  * 2020-08-16     luhuadong    support bind recv parser
  * 2023-03-28     kurisaW      support serial v2
+ * 2026-10-19     agent        support adaptive keepalive
+ * 2026-10-19     agent        wait for URCs instead of polling
+ * 2026-10-19     agent        add link quality monitor
+ * 2026-10-19     agent        support MQTT-SN transport
+ * 2026-10-19     agent        support MQTT over module TCP sockets
+ * 2026-10-19     agent        add AT traffic record and replay
+ * 2026-10-19     agent        recover the link in a worker thread
+ * 2026-10-19     agent        share one command buffer, match responses by prefix
+ * 2026-10-19     agent        cache QMTCFG settings, persistent session and resubscribe
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdarg.h>
 
 #include <rtthread.h>
 #include <rtdevice.h>
@@ -29,7 +39,7 @@
 #endif
 #include <rtdbg.h>
 
-#include "bc28_mqtt.h"
+#include "bc28_mqtt_internal.h"
 
 #define BC28_ADC0_PIN                 PKG_USING_BC28_ADC0_PIN
 #define BC28_RESET_N_PIN              PKG_USING_BC28_RESET_PIN
@@ -38,12 +48,39 @@
 #define AT_CLIENT_DEV_NAME            PKG_USING_BC28_AT_CLIENT_DEV_NAME
 #define AT_CLIENT_BAUD_RATE           PKG_USING_BC28_MQTT_BAUD_RATE
 
+/* with the tap enabled the AT client reaches the UART through it */
+#ifdef PKG_USING_BC28_MQTT_TAP
+#define AT_CLIENT_PORT_NAME           BC28_TAP_DEV_NAME
+#else
+#define AT_CLIENT_PORT_NAME           AT_CLIENT_DEV_NAME
+#endif
+
 #define PRODUCT_KEY                   PKG_USING_BC28_MQTT_PRODUCT_KEY
 #define DEVICE_NAME                   PKG_USING_BC28_MQTT_DEVICE_NAME
 #define DEVICE_SECRET                 PKG_USING_BC28_MQTT_DEVICE_SECRET
 
 #define KEEP_ALIVE_TIME               PKG_USING_BC28_MQTT_KEEP_ALIVE
 
+/* commands built from configuration are complete string literals */
+#define BC28_STR(x)                   #x
+#define BC28_XSTR(x)                  BC28_STR(x)
+
+#ifdef PKG_USING_BC28_MQTT_ADAPTIVE_KEEPALIVE
+#ifndef PKG_USING_BC28_MQTT_KEEP_ALIVE_MIN
+#define PKG_USING_BC28_MQTT_KEEP_ALIVE_MIN       60
+#endif
+#ifndef PKG_USING_BC28_MQTT_KEEP_ALIVE_MAX
+#define PKG_USING_BC28_MQTT_KEEP_ALIVE_MAX       3600
+#endif
+#ifndef PKG_USING_BC28_MQTT_KEEP_ALIVE_PROBE
+#define PKG_USING_BC28_MQTT_KEEP_ALIVE_PROBE     3
+#endif
+#define KEEP_ALIVE_MIN                PKG_USING_BC28_MQTT_KEEP_ALIVE_MIN
+#define KEEP_ALIVE_MAX                PKG_USING_BC28_MQTT_KEEP_ALIVE_MAX
+#define KEEP_ALIVE_PROBE              PKG_USING_BC28_MQTT_KEEP_ALIVE_PROBE   /* periods to survive before probing longer */
+#define KEEP_ALIVE_RESOLUTION         30                                     /* stop bisecting below this gap (s) */
+#endif
+
 #define AT_OK                         "OK"
 #define AT_ERROR                      "ERROR"
 
@@ -52,7 +89,7 @@
 #define AT_QREGSWT_2                  "AT+QREGSWT=2"
 #define AT_AUTOCONNECT_DISABLE        "AT+NCONFIG=AUTOCONNECT,FALSE"
 #define AT_REBOOT                     "AT+NRB"
-#define AT_NBAND                      "AT+NBAND=%d"
+#define AT_NBAND                      "AT+NBAND=" BC28_XSTR(BC28_OP_BAND)
 #define AT_FUN_ON                     "AT+CFUN=1"
 #define AT_LED_ON                     "AT+QLEDMODE=1"
 #define AT_EDRX_OFF                   "AT+CEDRXS=0,5"
@@ -63,24 +100,28 @@
 #define AT_QUERY_IMEI                 "AT+CGSN=1"
 #define AT_QUERY_IMSI                 "AT+CIMI"
 #define AT_QUERY_STATUS               "AT+NUESTATS"
+#define AT_QUERY_CSQ                  "AT+CSQ"
 #define AT_QUERY_REG                  "AT+CEREG?"
+#define AT_REG_REPORT_CELL            "AT+CEREG=2"
 #define AT_QUERY_IPADDR               "AT+CGPADDR"
 #define AT_QUERY_ATTACH               "AT+CGATT?"
 #define AT_UE_ATTACH_SUCC             "+CGATT:1"
 
-#define AT_MQTT_AUTH                  "AT+QMTCFG=\"aliauth\",0,\"%s\",\"%s\",\"%s\""
+#define AT_MQTT_AUTH                  "AT+QMTCFG=\"aliauth\",0,\"" PRODUCT_KEY "\",\"" DEVICE_NAME "\",\"" DEVICE_SECRET "\""
 #define AT_MQTT_ALIVE                 "AT+QMTCFG=\"keepalive\",0,%u"
-#define AT_MQTT_OPEN                  "AT+QMTOPEN=0,\"%s.iot-as-mqtt.cn-shanghai.aliyuncs.com\",1883"
+#define AT_MQTT_OPEN                  "AT+QMTOPEN=0,\"" PRODUCT_KEY ".iot-as-mqtt.cn-shanghai.aliyuncs.com\",1883"
 #define AT_MQTT_OPEN_SUCC             "+QMTOPEN: 0,0"
 #define AT_MQTT_CLOSE                 "AT+QMTCLOSE=0"
 #define AT_MQTT_CONNECT               "AT+QMTCONN=0,\"%s\""
 #define AT_MQTT_CONNECT_SUCC          "+QMTCONN: 0,0,0"
 #define AT_MQTT_DISCONNECT            "AT+QMTDISC=0"
-#define AT_MQTT_SUB                   "AT+QMTSUB=0,1,\"%s\",0"
-#define AT_MQTT_SUB_SUCC              "+QMTSUB: 0,1,0,1"
+#define AT_MQTT_SESSION               "AT+QMTCFG=\"session\",0," BC28_XSTR(BC28_CLEAN_SESSION)
+#define AT_MQTT_SUB                   "AT+QMTSUB=0,1,\"%s\"," BC28_XSTR(BC28_SUB_QOS)
+#define AT_MQTT_SUB_SUCC              "+QMTSUB: 0,1,0"
 #define AT_MQTT_UNSUB                 "AT+QMTUNS=0,1, \"%s\""
 #define AT_MQTT_PUB                   "AT+QMTPUB=0,0,0,0,\"%s\",%d"
 #define AT_MQTT_PUB_SUCC              "+QMTPUB: 0,0,0"
+#define AT_MQTT_PUB_MAX               1024       /* payload of one AT+QMTPUB */
 
 #define AT_QMTSTAT_CLOSED             1
 #define AT_QMTSTAT_PINGREQ_TIMEOUT    2
@@ -92,16 +133,147 @@
 
 #define AT_QMTRECV_DATA               "+QMTRECV: %d,%d,\"%s\",\"%s\""
 
-#define AT_CLIENT_RECV_BUFF_LEN       256
+#define AT_URC_BOOT_CAUSE             "REBOOT_CAUSE"
+#define AT_URC_BOOT_DONE              "Neul"
+#define AT_URC_REG                    "+CEREG:"
+
 #define AT_DEFAULT_TIMEOUT            5000
 
+#ifndef PKG_USING_BC28_MQTT_BOOT_TIMEOUT
+#define PKG_USING_BC28_MQTT_BOOT_TIMEOUT         10000
+#endif
+#ifndef PKG_USING_BC28_MQTT_ATTACH_TIMEOUT
+#define PKG_USING_BC28_MQTT_ATTACH_TIMEOUT       90000
+#endif
+#define BC28_BOOT_TIMEOUT             PKG_USING_BC28_MQTT_BOOT_TIMEOUT
+#define BC28_ATTACH_TIMEOUT           PKG_USING_BC28_MQTT_ATTACH_TIMEOUT
+
+#ifdef PKG_USING_BC28_MQTT_LINK_MONITOR
+#ifndef PKG_USING_BC28_MQTT_LINK_PERIOD
+#define PKG_USING_BC28_MQTT_LINK_PERIOD          60000
+#endif
+#define BC28_LINK_PERIOD              PKG_USING_BC28_MQTT_LINK_PERIOD
+#define BC28_LINK_RETRY               1000       /* AT channel busy, sample again after (ms) */
+#define BC28_LINK_CMD_TIMEOUT         1000
+#define BC28_LINK_THREAD_STACK        1024
+#define BC28_LINK_THREAD_PRIORITY     (RT_THREAD_PRIORITY_MAX - 2)
+#endif
+
+#define BC28_EVENT_READY              (1 << 0)   /* boot banner seen, module accepts AT */
+#define BC28_EVENT_REG                (1 << 1)   /* registered on the network (+CEREG stat 1 or 5) */
+
+#ifndef PKG_USING_BC28_MQTT_RECOVERY_BACKOFF
+#define PKG_USING_BC28_MQTT_RECOVERY_BACKOFF     60000
+#endif
+#define BC28_RECOVERY_BACKOFF_MIN     1000
+#define BC28_RECOVERY_BACKOFF_MAX     PKG_USING_BC28_MQTT_RECOVERY_BACKOFF
+#define BC28_RECOVERY_THREAD_STACK    2048
+#define BC28_RECOVERY_THREAD_PRIORITY (RT_THREAD_PRIORITY_MAX / 2)
+
+#ifndef PKG_USING_BC28_MQTT_SUB_MAX
+#define PKG_USING_BC28_MQTT_SUB_MAX              4
+#endif
+#define BC28_SUB_MAX                  PKG_USING_BC28_MQTT_SUB_MAX
+#define BC28_TOPIC_LEN                96
+
+/* a persistent session keeps subscriptions, and QoS 1 ones keep messages while offline */
+#ifdef PKG_USING_BC28_MQTT_PERSISTENT_SESSION
+#define BC28_CLEAN_SESSION            0
+#define BC28_SUB_QOS                  1
+#else
+#define BC28_CLEAN_SESSION            1
+#define BC28_SUB_QOS                  0
+#endif
+
+#define BC28_CFG_AUTH                 (1 << 0)
+#define BC28_CFG_ALIVE                (1 << 1)
+#define BC28_CFG_SESSION              (1 << 2)
+
 static struct bc28_device bc28 = {
     .reset_pin = PKG_USING_BC28_RESET_PIN,
     .adc_pin   = PKG_USING_BC28_ADC0_PIN,
     .stat      = BC28_STAT_DISCONNECTED
 };
 
-static char   buf[AT_CLIENT_RECV_BUFF_LEN];
+/* every formatted command is built here, one at a time */
+static char   cmd_buf[AT_CMD_MAX_LEN];
+static struct rt_mutex cmd_lock;
+
+/* payload of the last +QMTRECV, only touched by the AT parser thread */
+static char   recv_msg[AT_CLIENT_RECV_BUFF_LEN];
+
+/* RT_NULL selects the MQTT stack in the module firmware */
+static const struct bc28_transport_ops *transport = RT_NULL;
+
+#ifdef PKG_USING_BC28_MQTT_LINK_MONITOR
+/* publish policy per coverage enhancement level */
+struct bc28_link_policy
+{
+    rt_uint16_t batch;
+    rt_uint32_t pace;
+    rt_uint32_t timeout;
+};
+
+static const struct bc28_link_policy link_policy[] = {
+    {  8,     0,  5000 },   /* ECL 0, normal coverage */
+    {  4,  2000, 10000 },   /* ECL 1, robust coverage */
+    {  1, 10000, 20000 },   /* ECL 2, extreme coverage */
+};
+
+static struct bc28_link_info link = {
+    .ecl     = -1,
+    .csq     = 99,
+    .batch   = 1,
+    .timeout = AT_DEFAULT_TIMEOUT
+};
+
+/* end of the last publish, read by publishers before they take cmd_lock,
+ * so it is accessed under the scheduler lock like the link cache */
+static rt_tick_t last_publish = 0;
+#endif
+
+/* URC handlers run in the AT parser thread and must not send commands,
+ * they leave the rebuild to this worker */
+static struct
+{
+    rt_thread_t  tid;
+    rt_sem_t     sem;
+    rt_uint8_t   pending;           /* BC28_RECOVER_xxx */
+    rt_bool_t    boot_expected;     /* a reboot we asked for, not a crash */
+    rt_tick_t    since;             /* tick of the first failure, 0 if healthy */
+    struct bc28_recovery_info info;
+
+} recovery;
+
+/* what the module and the broker still hold, so a reconnect only redoes
+ * what was lost */
+static struct
+{
+    rt_uint8_t   held;              /* BC28_CFG_xxx set since the last reboot */
+    rt_uint32_t  keepalive;         /* value behind BC28_CFG_ALIVE */
+    char         topic[BC28_SUB_MAX][BC28_TOPIC_LEN];
+
+} session;
+
+#ifdef PKG_USING_BC28_MQTT_ADAPTIVE_KEEPALIVE
+struct bc28_keepalive
+{
+    rt_uint32_t cur;        /* keepalive applied on the next connect (s) */
+    rt_uint32_t good;       /* longest value survived in this cell, 0 if unknown */
+    rt_uint32_t bad;        /* shortest value seen timing out, 0 if unknown */
+    rt_uint32_t timeouts;   /* PINGREQ timeouts seen in this cell */
+    rt_tick_t   since;      /* tick of the last successful connect, 0 if down */
+    rt_timer_t  probe;      /* reconnects a stable session to try a longer value */
+    char        cell[24];   /* "<tac>:<ci>" of the serving cell */
+
+    int (*load)(const char *cell, rt_uint32_t *keepalive);
+    int (*save)(const char *cell, rt_uint32_t keepalive);
+};
+
+static struct bc28_keepalive keepalive = {
+    .cur = KEEP_ALIVE_TIME
+};
+#endif
 
 /**
  * This function will show response information.
@@ -129,12 +301,135 @@ static void show_resp_info(at_response_t resp)
     return;
 }
 
+/**
+ * Find the response line starting with the given text, without copying or
+ * scanning the line.
+ *
+ * @param resp   the response
+ * @param prefix expected start of the line
+ *
+ * @return the rest of the line after prefix, RT_NULL if no line matches
+ */
+static const char *resp_match(at_response_t resp, const char *prefix)
+{
+    const char *line = RT_NULL;
+    rt_size_t len = strlen(prefix);
+
+    for (rt_size_t i = 1; i <= resp->line_counts; i++)
+    {
+        if ((line = at_resp_get_line(resp, i)) != RT_NULL && strncmp(line, prefix, len) == 0)
+        {
+            return line + len;
+        }
+    }
+
+    return RT_NULL;
+}
+
+/* copy a response field up to the separator or the end of the line */
+static rt_size_t resp_copy(char *dst, rt_size_t size, const char *src, char sep)
+{
+    rt_size_t n = 0;
+
+    while (src && src[n] && src[n] != sep && src[n] != '\r' && src[n] != '\n' && n < size - 1)
+    {
+        dst[n] = src[n];
+        n++;
+    }
+    dst[n] = '\0';
+
+    return n;
+}
+
+/**
+ * Format a command into the shared command buffer and send it.
+ *
+ * @param resp     response, RT_NULL if the reply lines are not needed
+ * @param cmd_expr command format
+ *
+ * @return  RT_EOK       success
+ *         -RT_ERROR     send failed
+ *         -RT_ETIMEOUT  response timeout
+ */
+int bc28_exec_vcmd(at_response_t resp, const char *cmd_expr, va_list args)
+{
+    int result = 0;
+
+    rt_mutex_take(&cmd_lock, RT_WAITING_FOREVER);
+    rt_vsnprintf(cmd_buf, sizeof(cmd_buf), cmd_expr, args);
+    result = at_obj_exec_cmd(bc28.client, resp, "%s", cmd_buf);
+    rt_mutex_release(&cmd_lock);
+
+    return result;
+}
+
+/**
+ * Send a command longer than the shared command buffer. The head is
+ * formatted as usual, the rest of the line is pulled from body piece by
+ * piece and written straight to the AT device.
+ *
+ * @param resp      response, RT_NULL if the reply lines are not needed
+ * @param body      fills at most size bytes of the line, returns 0 at the end
+ * @param arg       passed to body
+ * @param head_expr command head format
+ *
+ * @return  RT_EOK       success
+ *         -RT_ERROR     send failed
+ *         -RT_ETIMEOUT  response timeout
+ */
+int bc28_exec_long(at_response_t resp, bc28_cmd_body_t body, void *arg, const char *head_expr, ...)
+{
+    struct at_client *client = bc28.client;
+    rt_size_t len = 0;
+    va_list args;
+    int result = 0;
+
+    rt_mutex_take(&cmd_lock, RT_WAITING_FOREVER);
+    /* keep other writers off the device until the line is complete */
+    rt_mutex_take(client->lock, RT_WAITING_FOREVER);
+
+    va_start(args, head_expr);
+    len = rt_vsnprintf(cmd_buf, sizeof(cmd_buf), head_expr, args);
+    va_end(args);
+    if (len >= sizeof(cmd_buf))
+    {
+        len = sizeof(cmd_buf) - 1;
+    }
+
+    do
+    {
+        if (len > 0)
+        {
+            at_client_obj_send(client, cmd_buf, len);
+        }
+    } while ((len = body(cmd_buf, sizeof(cmd_buf), arg)) > 0);
+
+    /* the client ends the line and waits for the response */
+    result = at_obj_exec_cmd(client, resp, "%s", "");
+
+    rt_mutex_release(client->lock);
+    rt_mutex_release(&cmd_lock);
+
+    return result;
+}
+
+int bc28_exec_cmd(at_response_t resp, const char *cmd_expr, ...)
+{
+    int result = 0;
+    va_list args;
+
+    va_start(args, cmd_expr);
+    result = bc28_exec_vcmd(resp, cmd_expr, args);
+    va_end(args);
+
+    return result;
+}
+
 /**
  * This function will send command and check the result.
  *
- * @param client    at client handle
- * @param cmd       command to at client
- * @param resp_expr expected response expression
+ * @param cmd_expr  command format, followed by its arguments
+ * @param resp_expr expected start of a response line, RT_NULL to skip the check
  * @param lines     response lines
  * @param timeout   waiting time
  *
@@ -143,12 +438,12 @@ static void show_resp_info(at_response_t resp)
  *         -RT_ETIMEOUT  response timeout
  *         -RT_ENOMEM    alloc memory failed
  */
-static int check_send_cmd(const char* cmd, const char* resp_expr, 
-                          const rt_size_t lines, const rt_int32_t timeout)
+static int check_send_cmd(const char *cmd_expr, const char *resp_expr,
+                          const rt_size_t lines, const rt_int32_t timeout, ...)
 {
     at_response_t resp = RT_NULL;
     int result = 0;
-    char resp_arg[AT_CMD_MAX_LEN] = { 0 };
+    va_list args;
 
     resp = at_create_resp(AT_CLIENT_RECV_BUFF_LEN, lines, rt_tick_from_millisecond(timeout));
     if (resp == RT_NULL)
@@ -157,7 +452,9 @@ static int check_send_cmd(const char* cmd, const char* resp_expr,
         return -RT_ENOMEM;
     }
 
-    result = at_obj_exec_cmd(bc28.client, resp, cmd);
+    va_start(args, timeout);
+    result = bc28_exec_vcmd(resp, cmd_expr, args);
+    va_end(args);
     if (result < 0)
     {
         LOG_E("AT client send commands failed or wait response timeout!");
@@ -166,36 +463,27 @@ static int check_send_cmd(const char* cmd, const char* resp_expr,
 
     show_resp_info(resp);
 
-    if (resp_expr)
+    if (resp_expr && !resp_match(resp, resp_expr))
     {
-        if (at_resp_parse_line_args_by_kw(resp, resp_expr, "%s", resp_arg) <= 0)
-        {
-            LOG_D("# >_< Failed");
-            result = -RT_ERROR;
-            goto __exit;
-        }
-        else
-        {
-            LOG_D("# ^_^ successed");
-        }
+        LOG_D("# >_< Failed");
+        result = -RT_ERROR;
+        goto __exit;
     }
-    
+    LOG_D("# ^_^ successed");
+
     result = RT_EOK;
 
 __exit:
-    if (resp)
-    {
-        at_delete_resp(resp);
-    }
+    at_delete_resp(resp);
 
     return result;
 }
 
-static char *bc28_get_imei(bc28_device_t device)
+static char *bc28_get_imei(bc28_device_t device, rt_int32_t timeout)
 {
     at_response_t resp = RT_NULL;
 
-    resp = at_create_resp(AT_CLIENT_RECV_BUFF_LEN, 0, rt_tick_from_millisecond(AT_DEFAULT_TIMEOUT));
+    resp = at_create_resp(AT_CLIENT_RECV_BUFF_LEN, 0, rt_tick_from_millisecond(timeout));
     if (resp == RT_NULL)
     {
         LOG_E("No memory for response structure!");
@@ -209,7 +497,7 @@ static char *bc28_get_imei(bc28_device_t device)
         return RT_NULL;
     }
     
-    if (at_resp_parse_line_args(resp, 2, "+CGSN:%s", device->imei) <= 0)
+    if (resp_copy(device->imei, sizeof(device->imei), resp_match(resp, "+CGSN:"), ',') == 0)
     {
         LOG_E("device parse \"%s\" cmd error.", AT_QUERY_IMEI);
         at_delete_resp(resp);
@@ -221,11 +509,12 @@ static char *bc28_get_imei(bc28_device_t device)
     return device->imei;
 }
 
-static char *bc28_get_ipaddr(bc28_device_t device)
+static char *bc28_get_ipaddr(bc28_device_t device, rt_int32_t timeout)
 {
     at_response_t resp = RT_NULL;
+    const char *addr = RT_NULL;
 
-    resp = at_create_resp(AT_CLIENT_RECV_BUFF_LEN, 0, rt_tick_from_millisecond(AT_DEFAULT_TIMEOUT));
+    resp = at_create_resp(AT_CLIENT_RECV_BUFF_LEN, 0, rt_tick_from_millisecond(timeout));
     if (resp == RT_NULL)
     {
         LOG_E("No memory for response structure!");
@@ -240,7 +529,9 @@ static char *bc28_get_ipaddr(bc28_device_t device)
     }
 
     /* parse response data "+CGPADDR: 0,<IP_address>" */
-    if (at_resp_parse_line_args_by_kw(resp, "+CGPADDR:", "+CGPADDR:%*d,%s", device->ipaddr) <= 0)
+    addr = resp_match(resp, "+CGPADDR:");
+    if (addr == RT_NULL || (addr = strchr(addr, ',')) == RT_NULL ||
+        resp_copy(device->ipaddr, sizeof(device->ipaddr), addr + 1, ',') == 0)
     {
         LOG_E("device parse \"%s\" cmd error.", AT_QUERY_IPADDR);
         at_delete_resp(resp);
@@ -256,255 +547,900 @@ static int bc28_mqtt_set_alive(rt_uint32_t keepalive_time)
 {
     LOG_D("MQTT set alive.");
 
-    char cmd[AT_CMD_MAX_LEN] = {0};
-    rt_sprintf(cmd, AT_MQTT_ALIVE, keepalive_time);
+    if (check_send_cmd(AT_MQTT_ALIVE, AT_OK, 0, AT_DEFAULT_TIMEOUT, keepalive_time) != RT_EOK)
+    {
+        return -RT_ERROR;
+    }
 
-    return check_send_cmd(cmd, AT_OK, 0, AT_DEFAULT_TIMEOUT);
+    session.held     |= BC28_CFG_ALIVE;
+    session.keepalive = keepalive_time;
+    return RT_EOK;
 }
 
-int bc28_mqtt_auth(void)
+#ifdef PKG_USING_BC28_MQTT_ADAPTIVE_KEEPALIVE
+static rt_uint32_t keepalive_clamp(rt_uint32_t value)
 {
-    LOG_D("MQTT set auth info.");
+    if (value < KEEP_ALIVE_MIN) return KEEP_ALIVE_MIN;
+    if (value > KEEP_ALIVE_MAX) return KEEP_ALIVE_MAX;
+    return value;
+}
 
-    char cmd[AT_CMD_MAX_LEN] = {0};
-    rt_sprintf(cmd, AT_MQTT_AUTH, PRODUCT_KEY, DEVICE_NAME, DEVICE_SECRET);
+static void keepalive_save(void)
+{
+    LOG_I("keepalive %us in cell %s, %u -> %u pings/h", keepalive.cur, keepalive.cell,
+          3600 / KEEP_ALIVE_TIME, 3600 / keepalive.cur);
 
-    return check_send_cmd(cmd, AT_OK, 0, AT_DEFAULT_TIMEOUT);
+    if (keepalive.save && keepalive.cell[0])
+    {
+        keepalive.save(keepalive.cell, keepalive.cur);
+    }
 }
 
 /**
- * Open MQTT socket.
+ * Restore the keepalive learned for the serving cell reported by +CEREG.
  *
- * @return 0 : exec at cmd success
- *        <0 : exec at cmd failed
+ * @param device  bc28 device
+ *
+ * @return void
  */
-int bc28_mqtt_open(void)
+static void keepalive_update_cell(bc28_device_t device)
 {
-    LOG_D("MQTT open socket.");
+    char cell[sizeof(keepalive.cell)] = {0};
+    rt_uint32_t value = 0;
+
+    if (device->tac[0] == '\0' || device->ci[0] == '\0')
+    {
+        return;
+    }
+
+    rt_snprintf(cell, sizeof(cell), "%s:%s", device->tac, device->ci);
+    if (rt_strcmp(cell, keepalive.cell) == 0)
+    {
+        return;
+    }
 
-    char cmd[AT_CMD_MAX_LEN] = {0};
-    rt_sprintf(cmd, AT_MQTT_OPEN, PRODUCT_KEY);
+    /* a new cell means a new carrier NAT path, start learning again */
+    rt_strncpy(keepalive.cell, cell, sizeof(keepalive.cell) - 1);
+    keepalive.cur      = KEEP_ALIVE_TIME;
+    keepalive.good     = 0;
+    keepalive.bad      = 0;
+    keepalive.timeouts = 0;
+    keepalive.since    = 0;
 
-    return check_send_cmd(cmd, AT_MQTT_OPEN_SUCC, 4, 75000);
+    if (keepalive.load && keepalive.load(cell, &value) == RT_EOK && value > 0)
+    {
+        keepalive.cur = keepalive_clamp(value);
+    }
+    LOG_D("serving cell %s, keepalive %us", cell, keepalive.cur);
 }
 
 /**
- * Close MQTT socket.
+ * Pick the keepalive for the coming connect. A session that survived
+ * KEEP_ALIVE_PROBE periods marks the current value good and probes a
+ * longer one: bisect towards the known bad value, or grow by half.
  *
- * @return 0 : exec at cmd success
- *        <0 : exec at cmd failed
+ * @return keepalive time in seconds
  */
-int bc28_mqtt_close(void)
+static rt_uint32_t keepalive_next(void)
 {
-    LOG_D("MQTT close socket.");
+    rt_uint32_t alive = 0, next = 0;
 
-    return check_send_cmd(AT_MQTT_CLOSE, AT_OK, 0, AT_DEFAULT_TIMEOUT);
+    if (keepalive.since == 0)
+    {
+        return keepalive.cur;
+    }
+
+    alive = (rt_tick_get() - keepalive.since) / RT_TICK_PER_SECOND;
+    keepalive.since = 0;
+
+    if (alive < keepalive.cur * KEEP_ALIVE_PROBE)
+    {
+        return keepalive.cur;
+    }
+
+    if (keepalive.cur > keepalive.good)
+    {
+        keepalive.good = keepalive.cur;
+    }
+
+    if (keepalive.bad == 0)
+    {
+        next = keepalive.cur + keepalive.cur / 2;
+    }
+    else if (keepalive.bad - keepalive.cur > KEEP_ALIVE_RESOLUTION)
+    {
+        next = (keepalive.cur + keepalive.bad) / 2;
+    }
+    else
+    {
+        return keepalive.cur;
+    }
+
+    next = keepalive_clamp(next);
+    if (next != keepalive.cur)
+    {
+        keepalive.cur = next;
+        keepalive_save();
+    }
+
+    return keepalive.cur;
+}
+
+static void keepalive_probe(void *parameter)
+{
+    /* timer context, the reconnect is left to the recovery worker */
+    if (bc28.stat == BC28_STAT_CONNECTED && keepalive.since && transport == RT_NULL)
+    {
+        bc28_recover(BC28_RECOVER_PROBE);
+    }
 }
 
 /**
- * Connect MQTT socket.
+ * The module applies the keepalive only when connecting, so a link that
+ * never drops would keep its first value. Reconnect once the session has
+ * survived KEEP_ALIVE_PROBE periods, keepalive_next() then picks a longer
+ * value.
  *
- * @return 0 : exec at cmd success
- *        <0 : exec at cmd failed
+ * @return void
  */
-int bc28_mqtt_connect(void)
+static void keepalive_arm_probe(void)
 {
-    LOG_D("MQTT connect...");
+    rt_tick_t ticks = rt_tick_from_millisecond(keepalive.cur * KEEP_ALIVE_PROBE * 1000);
 
-    char cmd[AT_CMD_MAX_LEN] = {0};
-    rt_sprintf(cmd, AT_MQTT_CONNECT, bc28.imei);
-    LOG_D("%s", cmd);
+    /* nothing longer left to try */
+    if (keepalive.cur >= KEEP_ALIVE_MAX ||
+        (keepalive.bad && keepalive.bad - keepalive.cur <= KEEP_ALIVE_RESOLUTION))
+    {
+        if (keepalive.probe)
+        {
+            rt_timer_stop(keepalive.probe);
+        }
+        return;
+    }
 
-    if (check_send_cmd(cmd, AT_MQTT_CONNECT_SUCC, 4, 10000) < 0)
+    if (keepalive.probe == RT_NULL)
     {
-        LOG_D("MQTT connect failed.");
-        return -RT_ERROR;
+        keepalive.probe = rt_timer_create("bc28ka", keepalive_probe, RT_NULL, ticks,
+                                          RT_TIMER_FLAG_ONE_SHOT | RT_TIMER_FLAG_SOFT_TIMER);
+        if (keepalive.probe == RT_NULL)
+        {
+            LOG_E("create keepalive probe timer failed.");
+            return;
+        }
     }
-    
-    bc28.stat = BC28_STAT_CONNECTED;
-    return RT_EOK;
+
+    rt_timer_stop(keepalive.probe);
+    rt_timer_control(keepalive.probe, RT_TIMER_CTRL_SET_TIME, &ticks);
+    rt_timer_start(keepalive.probe);
 }
 
 /**
- * Disconnect MQTT socket.
+ * The carrier NAT dropped us within one keepalive period, fall back to
+ * the last value known to survive or halve the interval. Runs in the
+ * recovery worker, the same thread as keepalive_next().
  *
- * @return 0 : exec at cmd success
- *        <0 : exec at cmd failed
+ * @return void
  */
-int bc28_mqtt_disconnect(void)
+static void keepalive_backoff(void)
 {
-    if (check_send_cmd(AT_MQTT_DISCONNECT, AT_OK, 0, AT_DEFAULT_TIMEOUT) < 0)
+    keepalive.timeouts++;
+    keepalive.since = 0;
+    keepalive.bad   = keepalive.cur;
+
+    /* the good value stopped working, the NAT timeout has changed */
+    if (keepalive.good >= keepalive.bad)
     {
-        LOG_D("MQTT disconnect failed.");
-        return -RT_ERROR;
+        keepalive.good = 0;
     }
-    
-    bc28.stat = BC28_STAT_CONNECTED;
-    return RT_EOK;
+
+    keepalive.cur = keepalive_clamp(keepalive.good ? keepalive.good : keepalive.cur / 2);
+    keepalive_save();
 }
 
 /**
- * Subscribe MQTT topic.
+ * Bind persistent storage for the keepalive learned per cell.
  *
- * @param  topic : mqtt topic
- * 
- * @return 0 : exec at cmd success
- *        <0 : exec at cmd failed
+ * @param load : read the value stored for cell, return RT_EOK if found
+ * @param save : store the value for cell, called from the recovery thread
+ *
+ * @return void
  */
-int bc28_mqtt_subscribe(const char *topic)
+void bc28_bind_keepalive_store(int (*load)(const char *cell, rt_uint32_t *keepalive),
+                               int (*save)(const char *cell, rt_uint32_t keepalive))
 {
-    char cmd[AT_CMD_MAX_LEN] = {0};
-    rt_sprintf(cmd, AT_MQTT_SUB, topic);
-
-    return check_send_cmd(cmd, AT_MQTT_SUB_SUCC, 4, AT_DEFAULT_TIMEOUT);
+    keepalive.load = load;
+    keepalive.save = save;
 }
 
-/**
- * Unsubscribe MQTT topic.
- *
- * @param  topic : mqtt topic
- * 
- * @return 0 : exec at cmd success
- *        <0 : exec at cmd failed
- */
-int bc28_mqtt_unsubscribe(const char *topic)
+static void bc28_keepalive_info(void)
 {
-    char cmd[AT_CMD_MAX_LEN] = {0};
-    rt_sprintf(cmd, AT_MQTT_UNSUB, topic);
+    rt_kprintf("cell      : %s\n", keepalive.cell[0] ? keepalive.cell : "unknown");
+    rt_kprintf("keepalive : %us (good %us, bad %us)\n", keepalive.cur, keepalive.good, keepalive.bad);
+    rt_kprintf("timeouts  : %u\n", keepalive.timeouts);
+    rt_kprintf("pings/h   : %u -> %u\n", 3600 / KEEP_ALIVE_TIME, 3600 / keepalive.cur);
+}
+#endif /* PKG_USING_BC28_MQTT_ADAPTIVE_KEEPALIVE */
 
-    return check_send_cmd(cmd, AT_OK, 0, AT_DEFAULT_TIMEOUT);
+static rt_uint32_t bc28_keepalive_time(void)
+{
+#ifdef PKG_USING_BC28_MQTT_ADAPTIVE_KEEPALIVE
+    return keepalive_next();
+#else
+    return KEEP_ALIVE_TIME;
+#endif
 }
 
+#ifdef PKG_USING_BC28_MQTT_LINK_MONITOR
 /**
- * Publish MQTT message to topic.
+ * Classify coverage from the sampled metrics, ECL first, then RSRP, then CSQ.
  *
- * @param  topic : mqtt topic
- * @param  msg   : message
- * 
- * @return 0 : exec at cmd success
- *        <0 : exec at cmd failed
+ * @return coverage enhancement level 0..2
  */
-int bc28_mqtt_publish(const char *topic, const char *msg)
+static int link_class(const struct bc28_link_info *info)
 {
-    char cmd[AT_CMD_MAX_LEN] = {0};
-    rt_sprintf(cmd, AT_MQTT_PUB, topic, strlen(msg));
+    if (info->ecl >= 0 && info->ecl <= 2)
+    {
+        return info->ecl;
+    }
 
-    /* set AT client end sign to deal with '>' sign.*/
-    at_set_end_sign('>');
+    if (info->updated && info->rsrp != 0)
+    {
+        return info->rsrp > -1050 ? 0 : (info->rsrp > -1150 ? 1 : 2);
+    }
 
-    //check_send_cmd(cmd, ">", 3, AT_DEFAULT_TIMEOUT);
-    check_send_cmd(cmd, RT_NULL, 2, AT_DEFAULT_TIMEOUT);
-    LOG_D("publish...");
+    if (info->csq != 99)
+    {
+        return info->csq >= 15 ? 0 : (info->csq >= 8 ? 1 : 2);
+    }
 
-    /* reset the end sign for data conflict */
-    at_set_end_sign(0);
+    return 0;
+}
+
+static int link_query(at_response_t resp, const char *cmd)
+{
+    /* never wait behind another command, the cached values are good enough;
+     * the lock is dropped after each query, so a publish that arrives while
+     * one is running waits for that query only, up to BC28_LINK_CMD_TIMEOUT */
+    if (rt_mutex_take(&cmd_lock, RT_WAITING_NO) != RT_EOK)
+    {
+        return -RT_EBUSY;
+    }
+
+    int result = at_obj_exec_cmd(bc28.client, resp, cmd);
+    rt_mutex_release(&cmd_lock);
 
-    return check_send_cmd(msg, AT_MQTT_PUB_SUCC, 4, AT_DEFAULT_TIMEOUT);
+    return result;
 }
 
 /**
- * Attach BC28 device to network.
+ * Sample AT+CSQ and AT+NUESTATS into the link cache.
  *
- * @return 0 : attach success
- *        <0 : attach failed
+ * @return  RT_EOK     sampled
+ *         -RT_EBUSY   AT channel in use, try later
+ *         -RT_ERROR   query failed
+ */
+static int link_sample(void)
+{
+    at_response_t resp = RT_NULL;
+    struct bc28_link_info info = link;
+    const struct bc28_link_policy *policy = RT_NULL;
+    int rssi = 99, rsrp = 0, sinr = 0, ecl = -1;
+    int result = RT_EOK;
+
+    resp = at_create_resp(AT_CLIENT_RECV_BUFF_LEN, 0, rt_tick_from_millisecond(BC28_LINK_CMD_TIMEOUT));
+    if (resp == RT_NULL)
+    {
+        LOG_E("No memory for response structure!");
+        return -RT_ENOMEM;
+    }
+
+    /* "+CSQ:<rssi>,<ber>" */
+    result = link_query(resp, AT_QUERY_CSQ);
+    if (result != RT_EOK) goto __exit;
+    at_resp_parse_line_args_by_kw(resp, "+CSQ:", "+CSQ:%d", &rssi);
+
+    /* "Signal power:<rsrp>" ... "SNR:<sinr>" ... "ECL:<ecl>", in 0.1 dBm / 0.1 dB */
+    result = link_query(resp, AT_QUERY_STATUS);
+    if (result != RT_EOK) goto __exit;
+    at_resp_parse_line_args_by_kw(resp, "Signal power:", "Signal power:%d", &rsrp);
+    at_resp_parse_line_args_by_kw(resp, "SNR:", "SNR:%d", &sinr);
+    at_resp_parse_line_args_by_kw(resp, "ECL:", "ECL:%d", &ecl);
+
+    info.csq     = rssi;
+    info.rsrp    = rsrp;
+    info.sinr    = sinr;
+    info.ecl     = ecl;
+    info.updated = rt_tick_get();
+
+    policy = &link_policy[link_class(&info)];
+    info.batch   = policy->batch;
+    info.pace    = policy->pace;
+    info.timeout = policy->timeout;
+
+    if (info.batch != link.batch)
+    {
+        LOG_I("coverage class %d, rsrp %d sinr %d csq %d", link_class(&info), rsrp, sinr, rssi);
+    }
+
+    /* single writer, readers copy the struct under the scheduler lock */
+    rt_enter_critical();
+    link = info;
+    rt_exit_critical();
+
+__exit:
+    at_delete_resp(resp);
+    return result;
+}
+
+static void link_monitor_entry(void *parameter)
+{
+    rt_int32_t delay = BC28_LINK_PERIOD;
+
+    while (1)
+    {
+        rt_thread_mdelay(delay);
+
+        if (bc28.stat != BC28_STAT_ATTACH && bc28.stat != BC28_STAT_CONNECTED)
+        {
+            delay = BC28_LINK_PERIOD;
+            continue;
+        }
+
+        delay = (link_sample() == -RT_EBUSY) ? BC28_LINK_RETRY : BC28_LINK_PERIOD;
+    }
+}
+
+static int link_monitor_start(void)
+{
+    static rt_thread_t tid = RT_NULL;
+
+    if (tid != RT_NULL)
+    {
+        return RT_EOK;
+    }
+
+    tid = rt_thread_create("bc28lnk", link_monitor_entry, RT_NULL,
+                           BC28_LINK_THREAD_STACK, BC28_LINK_THREAD_PRIORITY, 10);
+    if (tid == RT_NULL)
+    {
+        LOG_E("create link monitor thread failed.");
+        return -RT_ENOMEM;
+    }
+
+    return rt_thread_startup(tid);
+}
+
+/**
+ * Get the cached link quality and the publish policy derived from it.
+ *
+ * @param info : output link information
+ *
+ * @return 0 : cached values available
+ *        <0 : never sampled, info holds the defaults
+ */
+int bc28_link_get(struct bc28_link_info *info)
+{
+    RT_ASSERT(info);
+
+    rt_enter_critical();
+    *info = link;
+    rt_exit_critical();
+
+    return info->updated ? RT_EOK : -RT_ERROR;
+}
+
+static void bc28_link_info(void)
+{
+    struct bc28_link_info info;
+
+    bc28_link_get(&info);
+    rt_kprintf("rsrp    : %d (0.1 dBm)\n", info.rsrp);
+    rt_kprintf("sinr    : %d (0.1 dB)\n", info.sinr);
+    rt_kprintf("ecl     : %d\n", info.ecl);
+    rt_kprintf("csq     : %d\n", info.csq);
+    rt_kprintf("batch   : %u\n", info.batch);
+    rt_kprintf("pace    : %u ms\n", info.pace);
+    rt_kprintf("timeout : %u ms\n", info.timeout);
+}
+#endif /* PKG_USING_BC28_MQTT_LINK_MONITOR */
+
+int bc28_mqtt_auth(void)
+{
+    LOG_D("MQTT set auth info.");
+
+    if (check_send_cmd(AT_MQTT_AUTH, AT_OK, 0, AT_DEFAULT_TIMEOUT) != RT_EOK)
+    {
+        return -RT_ERROR;
+    }
+
+    session.held |= BC28_CFG_AUTH;
+    return RT_EOK;
+}
+
+/**
+ * Open MQTT socket.
+ *
+ * @return 0 : exec at cmd success
+ *        <0 : exec at cmd failed
+ */
+int bc28_mqtt_open(void)
+{
+    LOG_D("MQTT open socket.");
+
+    return check_send_cmd(AT_MQTT_OPEN, AT_MQTT_OPEN_SUCC, 4, 75000);
+}
+
+/**
+ * Close MQTT socket.
+ *
+ * @return 0 : exec at cmd success
+ *        <0 : exec at cmd failed
+ */
+int bc28_mqtt_close(void)
+{
+    if (transport)
+    {
+        return transport->close();
+    }
+
+    LOG_D("MQTT close socket.");
+
+    return check_send_cmd(AT_MQTT_CLOSE, AT_OK, 0, AT_DEFAULT_TIMEOUT);
+}
+
+/**
+ * Connect MQTT socket.
+ *
+ * @return 0 : exec at cmd success
+ *        <0 : exec at cmd failed
+ */
+int bc28_mqtt_connect(void)
+{
+    LOG_D("MQTT connect...");
+
+    if (check_send_cmd(AT_MQTT_CONNECT, AT_MQTT_CONNECT_SUCC, 4, 10000, bc28.imei) < 0)
+    {
+        LOG_D("MQTT connect failed.");
+        return -RT_ERROR;
+    }
+    
+    bc28.stat = BC28_STAT_CONNECTED;
+#ifdef PKG_USING_BC28_MQTT_ADAPTIVE_KEEPALIVE
+    keepalive.since = rt_tick_get();
+    keepalive_arm_probe();
+#endif
+    return RT_EOK;
+}
+
+/**
+ * Disconnect MQTT socket.
+ *
+ * @return 0 : exec at cmd success
+ *        <0 : exec at cmd failed
+ */
+int bc28_mqtt_disconnect(void)
+{
+    if (check_send_cmd(AT_MQTT_DISCONNECT, AT_OK, 0, AT_DEFAULT_TIMEOUT) < 0)
+    {
+        LOG_D("MQTT disconnect failed.");
+        return -RT_ERROR;
+    }
+    
+    bc28.stat = BC28_STAT_CONNECTED;
+    return RT_EOK;
+}
+
+static int mqtt_subscribe(const char *topic)
+{
+    if (transport)
+    {
+        return transport->subscribe(topic);
+    }
+
+    at_response_t resp = RT_NULL;
+    const char *granted = RT_NULL;
+    int result = 0;
+
+    resp = at_create_resp(AT_CLIENT_RECV_BUFF_LEN, 4, rt_tick_from_millisecond(AT_DEFAULT_TIMEOUT));
+    if (resp == RT_NULL)
+    {
+        LOG_E("No memory for response structure!");
+        return -RT_ENOMEM;
+    }
+
+    /* +QMTSUB: 0,1,0,<value>, a granted QoS of 128 is the broker refusing */
+    result = bc28_exec_cmd(resp, AT_MQTT_SUB, topic);
+    if (result == RT_EOK)
+    {
+        granted = resp_match(resp, AT_MQTT_SUB_SUCC);
+        if (granted == RT_NULL || (granted[0] == ',' && atoi(granted + 1) == 128))
+        {
+            LOG_E("subscribe %s refused.", topic);
+            result = -RT_ERROR;
+        }
+    }
+    at_delete_resp(resp);
+
+    return result;
+}
+
+/* remember a topic so it can be subscribed again after a reconnect */
+static void session_track(const char *topic, rt_bool_t add)
+{
+    int i = 0, empty = -1;
+
+    for (i = 0; i < BC28_SUB_MAX; i++)
+    {
+        if (session.topic[i][0] == '\0')
+        {
+            empty = (empty < 0) ? i : empty;
+        }
+        else if (strncmp(session.topic[i], topic, BC28_TOPIC_LEN) == 0)
+        {
+            break;
+        }
+    }
+
+    if (!add)
+    {
+        if (i < BC28_SUB_MAX)
+        {
+            session.topic[i][0] = '\0';
+        }
+    }
+    else if (i == BC28_SUB_MAX)
+    {
+        if (empty < 0 || strlen(topic) >= BC28_TOPIC_LEN)
+        {
+            LOG_E("%s will not be subscribed again after a reconnect.", topic);
+            return;
+        }
+        rt_strncpy(session.topic[empty], topic, BC28_TOPIC_LEN);
+    }
+}
+
+/**
+ * Subscribe MQTT topic. Up to PKG_USING_BC28_MQTT_SUB_MAX topics are
+ * subscribed again when the link is rebuilt.
+ *
+ * @param  topic : mqtt topic
+ * 
+ * @return 0 : exec at cmd success
+ *        <0 : exec at cmd failed
+ */
+int bc28_mqtt_subscribe(const char *topic)
+{
+    int result = mqtt_subscribe(topic);
+
+    if (result == RT_EOK)
+    {
+        session_track(topic, RT_TRUE);
+    }
+
+    return result;
+}
+
+/**
+ * Unsubscribe MQTT topic.
+ *
+ * @param  topic : mqtt topic
+ * 
+ * @return 0 : exec at cmd success
+ *        <0 : exec at cmd failed
+ */
+int bc28_mqtt_unsubscribe(const char *topic)
+{
+    int result = 0;
+
+    if (transport)
+    {
+        result = transport->unsubscribe(topic);
+    }
+    else
+    {
+        result = check_send_cmd(AT_MQTT_UNSUB, AT_OK, 0, AT_DEFAULT_TIMEOUT, topic);
+    }
+
+    /* still subscribed on the broker otherwise, keep it for the resume */
+    if (result == RT_EOK)
+    {
+        session_track(topic, RT_FALSE);
+    }
+
+    return result;
+}
+
+/* message after the '>' prompt, in pieces of the command buffer */
+struct pub_body
+{
+    const char *msg;
+    rt_size_t   left;
+};
+
+static rt_size_t pub_body_fill(char *buf, rt_size_t size, void *arg)
+{
+    struct pub_body *body = arg;
+    rt_size_t n = body->left < size ? body->left : size;
+
+    rt_memcpy(buf, body->msg, n);
+    body->msg  += n;
+    body->left -= n;
+
+    return n;
+}
+
+/**
+ * Publish MQTT message to topic.
+ *
+ * @param  topic : mqtt topic
+ * @param  msg   : message, at most bc28_mqtt_payload_max() bytes
+ * 
+ * @return 0 : exec at cmd success
+ *        <0 : exec at cmd failed, -RT_EFULL if the message is too long
+ */
+int bc28_mqtt_publish(const char *topic, const char *msg)
+{
+    if (transport)
+    {
+        return transport->publish(topic, msg);
+    }
+
+    struct pub_body body = { msg, strlen(msg) };
+    at_response_t resp = RT_NULL;
+    int result = 0;
+    rt_int32_t timeout = AT_DEFAULT_TIMEOUT;
+
+    if (body.left > AT_MQTT_PUB_MAX)
+    {
+        LOG_E("message of %d bytes exceeds %d.", body.left, AT_MQTT_PUB_MAX);
+        return -RT_EFULL;
+    }
+
+    /* fail fast while the link is being rebuilt */
+    if (bc28.stat == BC28_STAT_DISCONNECTED && recovery.pending)
+    {
+        return -RT_ERROR;
+    }
+
+#ifdef PKG_USING_BC28_MQTT_LINK_MONITOR
+    struct bc28_link_info info;
+    rt_tick_t prev = 0;
+    rt_int32_t wait = 0;
+
+    bc28_link_get(&info);
+    timeout = info.timeout;
+
+    /* slow down in bad coverage instead of piling up timeouts, before
+     * taking the command lock so nothing else waits behind the pause */
+    rt_enter_critical();
+    prev = last_publish;
+    rt_exit_critical();
+
+    wait = (rt_int32_t)(prev + rt_tick_from_millisecond(info.pace) - rt_tick_get());
+    if (prev && wait > 0)
+    {
+        rt_thread_delay(wait);
+    }
+#endif
+
+    /* the prompt changes the client end sign, keep other commands out
+     * until the payload is through (cmd_lock is recursive) */
+    rt_mutex_take(&cmd_lock, RT_WAITING_FOREVER);
+
+    /* set AT client end sign to deal with '>' sign.*/
+    at_set_end_sign('>');
+
+    /* only the '>' ends the response, a line count would also be reached by
+     * stray lines; the client overwrites the '>', so an ERROR or a timeout
+     * in place of the prompt shows in the result alone */
+    result = check_send_cmd(AT_MQTT_PUB, RT_NULL, 0, AT_DEFAULT_TIMEOUT, topic, (int)body.left);
+    LOG_D("publish...");
+
+    /* reset the end sign for data conflict */
+    at_set_end_sign(0);
+
+    if (result != RT_EOK)
+    {
+        /* no prompt, the module would take the body for a command */
+        LOG_E("no prompt for %s.", topic);
+    }
+    else if ((resp = at_create_resp(AT_CLIENT_RECV_BUFF_LEN, 4, rt_tick_from_millisecond(timeout))) == RT_NULL)
+    {
+        LOG_E("No memory for response structure!");
+        result = -RT_ENOMEM;
+    }
+    else
+    {
+        /* the message is longer than the command buffer, stream it */
+        result = bc28_exec_long(resp, pub_body_fill, &body, "%s", "");
+        if (result == RT_EOK && !resp_match(resp, AT_MQTT_PUB_SUCC))
+        {
+            result = -RT_ERROR;
+        }
+        at_delete_resp(resp);
+    }
+
+#ifdef PKG_USING_BC28_MQTT_LINK_MONITOR
+    rt_enter_critical();
+    last_publish = rt_tick_get();
+    rt_exit_critical();
+#endif
+    rt_mutex_release(&cmd_lock);
+
+    return result;
+}
+
+/**
+ * Wait for URC events until the deadline.
+ *
+ * @param set       events to wait for, any of them satisfies the wait
+ * @param deadline  absolute tick
+ *
+ * @return  RT_EOK       event received
+ *         -RT_ETIMEOUT  deadline passed
+ */
+static int bc28_wait_event(rt_uint32_t set, rt_tick_t deadline)
+{
+    rt_uint32_t recved = 0;
+    rt_int32_t  left = (rt_int32_t)(deadline - rt_tick_get());
+
+    if (left < 0)
+    {
+        left = 0;
+    }
+
+    if (rt_event_recv(bc28.event, set, RT_EVENT_FLAG_OR, left, &recved) != RT_EOK)
+    {
+        return -RT_ETIMEOUT;
+    }
+
+    return RT_EOK;
+}
+
+static void bc28_clear_event(rt_uint32_t set)
+{
+    rt_uint32_t recved = 0;
+
+    rt_event_recv(bc28.event, set, RT_EVENT_FLAG_OR | RT_EVENT_FLAG_CLEAR, RT_WAITING_NO, &recved);
+}
+
+/* time left for one attach command, at most AT_DEFAULT_TIMEOUT (ms) */
+static rt_int32_t attach_timeout(rt_tick_t deadline)
+{
+    rt_int32_t left = (rt_int32_t)(deadline - rt_tick_get());
+
+    if (left <= 0)
+    {
+        return 0;
+    }
+
+    left = left * 1000 / RT_TICK_PER_SECOND;
+    return left < AT_DEFAULT_TIMEOUT ? left : AT_DEFAULT_TIMEOUT;
+}
+
+/* send one attach step, bounded by the overall attach deadline */
+static int attach_cmd(const char *cmd, const char *resp_expr, rt_tick_t deadline)
+{
+    rt_int32_t timeout = attach_timeout(deadline);
+
+    if (timeout == 0)
+    {
+        LOG_E("attach timeout before \"%s\".", cmd);
+        return -RT_ETIMEOUT;
+    }
+
+    return check_send_cmd(cmd, resp_expr, 0, timeout);
+}
+
+/**
+ * Attach BC28 device to network.
+ *
+ * @return 0 : attach success
+ *        <0 : attach failed
  */
 int bc28_client_attach(void)
 {
     int result = 0;
-    char cmd[AT_CMD_MAX_LEN] = {0};
+    rt_tick_t start = rt_tick_get();
+    rt_tick_t deadline = start + rt_tick_from_millisecond(BC28_ATTACH_TIMEOUT);
 
     /* close echo */
-    check_send_cmd(AT_ECHO_OFF, AT_OK, 0, AT_DEFAULT_TIMEOUT);
+    attach_cmd(AT_ECHO_OFF, AT_OK, deadline);
 
     /* 关闭电信自动注册功能 */
-    result = check_send_cmd(AT_QREGSWT_2, AT_OK, 0, AT_DEFAULT_TIMEOUT);
+    result = attach_cmd(AT_QREGSWT_2, AT_OK, deadline);
     if (result != RT_EOK) return result;
 
     /* 禁用自动连接网络 */
-    result = check_send_cmd(AT_AUTOCONNECT_DISABLE, AT_OK, 0, AT_DEFAULT_TIMEOUT);
+    result = attach_cmd(AT_AUTOCONNECT_DISABLE, AT_OK, deadline);
     if (result != RT_EOK) return result;
 
-    /* 重启模块 */
-    check_send_cmd(AT_REBOOT, AT_OK, 0, 10000);
+    /* 重启模块，等待开机信息 */
+    bc28_clear_event(BC28_EVENT_READY | BC28_EVENT_REG);
+    recovery.boot_expected = RT_TRUE;
+    at_obj_exec_cmd(bc28.client, RT_NULL, AT_REBOOT);
 
-    while(RT_EOK != check_send_cmd(AT_TEST, AT_OK, 0, AT_DEFAULT_TIMEOUT))
+    if (bc28_wait_event(BC28_EVENT_READY, deadline) != RT_EOK)
     {
-        rt_thread_mdelay(1000);
+        LOG_E("BC28 reboot timeout.");
+        return -RT_ETIMEOUT;
     }
 
     /* 查询IMEI号 */
-    result = check_send_cmd(AT_QUERY_IMEI, AT_OK, 0, AT_DEFAULT_TIMEOUT);
+    result = attach_cmd(AT_QUERY_IMEI, AT_OK, deadline);
     if (result != RT_EOK) return result;
 
-    if (RT_NULL == bc28_get_imei(&bc28))
+    if (RT_NULL == bc28_get_imei(&bc28, attach_timeout(deadline)))
     {
         LOG_E("Get IMEI code failed.");
         return -RT_ERROR;
     }
 
     /* 指定要搜索的频段 */
-    rt_sprintf(cmd, AT_NBAND, BC28_OP_BAND);
-    result = check_send_cmd(cmd, AT_OK, 0, AT_DEFAULT_TIMEOUT);
+    result = attach_cmd(AT_NBAND, AT_OK, deadline);
     if (result != RT_EOK) return result;
 
     /* 打开模块的调试灯 */
-    //result = check_send_cmd(AT_LED_ON, AT_OK, 0, AT_DEFAULT_TIMEOUT);
+    //result = attach_cmd(AT_LED_ON, AT_OK, deadline);
     //if (result != RT_EOK) return result;
 
     /* 将模块设置为全功能模式(开启射频功能) */
-    result = check_send_cmd(AT_FUN_ON, AT_OK, 0, AT_DEFAULT_TIMEOUT);
+    result = attach_cmd(AT_FUN_ON, AT_OK, deadline);
     if (result != RT_EOK) return result;
 
     /* 接收到TCP数据时，自动上报 */
-    result = check_send_cmd(AT_RECV_AUTO, AT_OK, 0, AT_DEFAULT_TIMEOUT);
+    result = attach_cmd(AT_RECV_AUTO, AT_OK, deadline);
     if (result != RT_EOK) return result;
 
     /* 关闭eDRX */
-    result = check_send_cmd(AT_EDRX_OFF, AT_OK, 0, AT_DEFAULT_TIMEOUT);
+    result = attach_cmd(AT_EDRX_OFF, AT_OK, deadline);
     if (result != RT_EOK) return result;
 
     /* 关闭PSM */
-    result = check_send_cmd(AT_PSM_OFF, AT_OK, 0, AT_DEFAULT_TIMEOUT);
+    result = attach_cmd(AT_PSM_OFF, AT_OK, deadline);
     if (result != RT_EOK) return result;
 
     /* 查询卡的国际识别码(IMSI号)，用于确认SIM卡插入正常 */
-    result = check_send_cmd(AT_QUERY_IMSI, AT_OK, 0, AT_DEFAULT_TIMEOUT);
+    result = attach_cmd(AT_QUERY_IMSI, AT_OK, deadline);
+    if (result != RT_EOK) return result;
+
+    /* 开启网络注册状态主动上报（带小区信息） */
+    result = attach_cmd(AT_REG_REPORT_CELL, AT_OK, deadline);
     if (result != RT_EOK) return result;
 
     /* 触发网络连接 */
-    result = check_send_cmd(AT_UE_ATTACH, AT_OK, 0, AT_DEFAULT_TIMEOUT);
+    result = attach_cmd(AT_UE_ATTACH, AT_OK, deadline);
     if (result != RT_EOK) return result;
 
     /* 查询模块状态 */
     //at_exec_cmd(resp, "AT+NUESTATS");
 
-    /* 查询网络注册状态 */
-    //at_exec_cmd(resp, "AT+CEREG?");
-
     /* 查看信号强度 */
     //at_exec_cmd(resp, "AT+CSQ");
 
-    /* 查询网络是否被激活，通常需要等待30s */
-    int count = 60;
-    while(count > 0 && RT_EOK != check_send_cmd(AT_QUERY_ATTACH, AT_UE_ATTACH_SUCC, 0, AT_DEFAULT_TIMEOUT))
+    /* 补查一次注册状态，防止开启上报前已经注册成功；之后等待 +CEREG 上报，通常需要30s */
+    attach_cmd(AT_QUERY_REG, RT_NULL, deadline);
+    if (bc28_wait_event(BC28_EVENT_REG, deadline) != RT_EOK)
     {
-        rt_thread_mdelay(1000);
-        count--;
+        LOG_E("BC28 register timeout.");
+        return -RT_ETIMEOUT;
     }
 
-    /* 查询模块的 IP 地址 */
-    //at_exec_cmd(resp, "AT+CGPADDR");
-    bc28_get_ipaddr(&bc28);
+    /* 注册成功后确认网络已被激活 */
+    result = attach_cmd(AT_QUERY_ATTACH, AT_UE_ATTACH_SUCC, deadline);
+    if (result != RT_EOK) return result;
 
-    if (count > 0) 
-    {
-        bc28.stat = BC28_STAT_ATTACH;
-        return RT_EOK;
-    }
-    else 
-    {
-        return -RT_ETIMEOUT;
-    }
+    /* 查询模块的 IP 地址 */
+    //at_exec_cmd(resp, "AT+CGPADDR");
+    bc28_get_ipaddr(&bc28, attach_timeout(deadline));
+
+#ifdef PKG_USING_BC28_MQTT_ADAPTIVE_KEEPALIVE
+    keepalive_update_cell(&bc28);
+#endif
+    LOG_I("attach done in %u ms", (rt_tick_get() - start) * 1000 / RT_TICK_PER_SECOND);
+
+    bc28.stat = BC28_STAT_ATTACH;
+    return RT_EOK;
 }
 
 /**
@@ -552,37 +1488,68 @@ static int at_client_dev_init(void)
     rt_device_control(serial, RT_DEVICE_CTRL_CONFIG, &config);
     rt_device_close(serial);
 
+#ifdef PKG_USING_BC28_MQTT_TAP
+    result = bc28_tap_init(AT_CLIENT_DEV_NAME);
+    if (result != RT_EOK)
+    {
+        return result;
+    }
+#endif
+
     /* initialize AT client */
-    result = at_client_init(AT_CLIENT_DEV_NAME, AT_CLIENT_RECV_BUFF_LEN);
+    result = at_client_init(AT_CLIENT_PORT_NAME, AT_CLIENT_RECV_BUFF_LEN);
     if (result < 0)
     {
-        LOG_E("at client (%s) init failed.", AT_CLIENT_DEV_NAME);
+        LOG_E("at client (%s) init failed.", AT_CLIENT_PORT_NAME);
         return result;
     }
 
-    bc28.client = at_client_get(AT_CLIENT_DEV_NAME);
+    bc28.client = at_client_get(AT_CLIENT_PORT_NAME);
     if (bc28.client == RT_NULL)
     {
-        LOG_E("get AT client (%s) failed.", AT_CLIENT_DEV_NAME);
+        LOG_E("get AT client (%s) failed.", AT_CLIENT_PORT_NAME);
         return -RT_ERROR;
     }
 
     return RT_EOK;
 }
 
-static void bc28_reset(void)
+static int bc28_reset(void)
 {
+    rt_tick_t deadline = 0;
+
+    bc28_clear_event(BC28_EVENT_READY | BC28_EVENT_REG);
+    recovery.boot_expected = RT_TRUE;
+
     rt_pin_mode(BC28_RESET_N_PIN, PIN_MODE_OUTPUT);
     rt_pin_write(BC28_RESET_N_PIN, PIN_HIGH);
 
+    /* reset pulse width */
     rt_thread_mdelay(300);
 
     rt_pin_write(BC28_RESET_N_PIN, PIN_LOW);
 
-    rt_thread_mdelay(1000);
+    deadline = rt_tick_get() + rt_tick_from_millisecond(BC28_BOOT_TIMEOUT);
+    if (bc28_wait_event(BC28_EVENT_READY, deadline) != RT_EOK)
+    {
+        LOG_E("BC28 boot timeout.");
+        return -RT_ETIMEOUT;
+    }
+
+    return RT_EOK;
 }
 
 int at_client_port_init(void);
+static int recovery_start(void);
+
+/* before anything can send a command, whatever thread gets there first */
+static int bc28_cmd_lock_init(void)
+{
+    rt_mutex_init(&cmd_lock, "bc28cmd", RT_IPC_FLAG_PRIO);
+
+    return RT_EOK;
+}
+INIT_PREV_EXPORT(bc28_cmd_lock_init);
 
 /**
  * BC28 device initialize.
@@ -592,14 +1559,36 @@ int at_client_port_init(void);
  */
 int bc28_init(void)
 {
+    if (bc28.event == RT_NULL)
+    {
+        bc28.event = rt_event_create("bc28", RT_IPC_FLAG_FIFO);
+        if (bc28.event == RT_NULL)
+        {
+            LOG_E("No memory for bc28 event!");
+            return -RT_ENOMEM;
+        }
+    }
+
     LOG_D("Init at client device.");
     at_client_dev_init();
     at_client_port_init();
 
     LOG_D("Reset BC28 device.");
-    bc28_reset();
+    if (bc28_reset() != RT_EOK)
+    {
+        return -RT_ERROR;
+    }
 
     bc28.stat = BC28_STAT_INIT;
+
+    if (recovery_start() != RT_EOK)
+    {
+        return -RT_ERROR;
+    }
+
+#ifdef PKG_USING_BC28_MQTT_LINK_MONITOR
+    link_monitor_start();
+#endif
     return RT_EOK;
 }
 
@@ -608,49 +1597,219 @@ void bc28_bind_parser(void (*callback)(const char *json))
     bc28.parser = callback;
 }
 
-int bc28_build_mqtt_network(void)
+bc28_device_t bc28_get_device(void)
 {
-    int result = 0;
+    return &bc28;
+}
 
-    bc28_mqtt_set_alive(KEEP_ALIVE_TIME);
+/**
+ * Hand a received message to the bound parser, whatever the transport.
+ *
+ * @param topic     topic name, not NUL terminated
+ * @param topic_len topic name length
+ * @param payload   NUL terminated payload
+ * @param len       payload length
+ *
+ * @return void
+ */
+void bc28_recv_dispatch(const char *topic, rt_size_t topic_len, const char *payload, rt_size_t len)
+{
+    LOG_D("recv %d bytes on %.*s", len, (int)topic_len, topic);
 
-    if((result = bc28_mqtt_auth()) < 0) {
-        return result;
+#ifdef PKG_USING_BC28_MQTT_OTA
+    if (bc28_ota_recv(topic, topic_len, payload, len))
+    {
+        return;
     }
+#endif
 
-    if((result = bc28_mqtt_open()) < 0) {
-        return result;
+    if (bc28.parser)
+    {
+        bc28.parser(payload);
     }
+}
 
-    if((result = bc28_mqtt_connect()) < 0) {
-        return result;
+/**
+ * Longest message bc28_mqtt_publish() takes on the selected transport.
+ *
+ * @return payload limit in bytes
+ */
+rt_size_t bc28_mqtt_payload_max(void)
+{
+    return transport ? transport->payload_max : AT_MQTT_PUB_MAX;
+}
+
+/**
+ * Whether the selected transport hands payloads over as they are. The
+ * firmware transport delivers them inside a text URC line.
+ *
+ * @return RT_TRUE : binary payloads are safe
+ */
+rt_bool_t bc28_transport_binary(void)
+{
+    return transport != RT_NULL;
+}
+
+/**
+ * Select the MQTT transport used by the build/publish/subscribe API.
+ *
+ * @param  type : BC28_TRANSPORT_xxx
+ *
+ * @return 0 : success
+ *        <0 : transport not compiled in
+ */
+int bc28_mqtt_set_transport(bc28_transport_t type)
+{
+    switch (type)
+    {
+    case BC28_TRANSPORT_FIRMWARE:
+        transport = RT_NULL;
+        break;
+#ifdef PKG_USING_BC28_MQTT_SN
+    case BC28_TRANSPORT_MQTTSN:
+        transport = &bc28_mqttsn_ops;
+        break;
+#endif
+#ifdef PKG_USING_BC28_MQTT_CODEC
+    case BC28_TRANSPORT_MQTT:
+        transport = &bc28_mqttc_ops;
+        break;
+#endif
+    default:
+        LOG_E("transport %d is not enabled.", type);
+        return -RT_ENOSYS;
     }
 
     return RT_EOK;
 }
 
-int bc28_rebuild_mqtt_network(void)
+/* send only the QMTCFG settings the module does not hold, returns how many */
+static int mqtt_configure(void)
 {
-    int result = 0;
+    rt_uint32_t alive = bc28_keepalive_time();
+    int sent = 0;
 
-    bc28_mqtt_close();
-    bc28_mqtt_set_alive(KEEP_ALIVE_TIME);
+    if (!(session.held & BC28_CFG_ALIVE) || session.keepalive != alive)
+    {
+        if (bc28_mqtt_set_alive(alive) != RT_EOK)
+        {
+            LOG_E("MQTT set alive failed.");
+            return -RT_ERROR;
+        }
+        sent++;
+    }
 
-    if((result = bc28_mqtt_auth()) < 0) {
-        return result;
+    if (!(session.held & BC28_CFG_SESSION))
+    {
+        if (check_send_cmd(AT_MQTT_SESSION, AT_OK, 0, AT_DEFAULT_TIMEOUT) != RT_EOK)
+        {
+            LOG_E("MQTT set session failed.");
+            return -RT_ERROR;
+        }
+        session.held |= BC28_CFG_SESSION;
+        sent++;
     }
 
-    if((result = bc28_mqtt_open()) < 0) {
-        return result;
+    if (!(session.held & BC28_CFG_AUTH))
+    {
+        if (bc28_mqtt_auth() < 0)
+        {
+            return -RT_ERROR;
+        }
+        sent++;
+    }
+
+    return sent;
+}
+
+/* a resumed session still has its subscriptions on the broker; the module
+ * firmware does not report session present, so it always subscribes again */
+static int mqtt_resubscribe(void)
+{
+    rt_bool_t resumed = RT_FALSE;
+    int count = 0;
+
+    if (transport && transport->resumed)
+    {
+        resumed = transport->resumed();
+    }
+
+    for (int i = 0; !resumed && i < BC28_SUB_MAX; i++)
+    {
+        if (session.topic[i][0] && mqtt_subscribe(session.topic[i]) == RT_EOK)
+        {
+            count++;
+        }
+    }
+
+    return count;
+}
+
+static rt_uint32_t tick_ms(rt_tick_t from, rt_tick_t to)
+{
+    return (to - from) * 1000 / RT_TICK_PER_SECOND;
+}
+
+static int mqtt_link_up(void)
+{
+    struct bc28_recovery_info *info = &recovery.info;
+    rt_tick_t start = rt_tick_get(), cfg = start, open = start, conn = start;
+    int result = 0;
+
+    if (transport)
+    {
+        result = transport->connect();
+        open = conn = rt_tick_get();
+    }
+    else if ((result = mqtt_configure()) >= 0)
+    {
+        info->cfg_cmds = result;
+        cfg = rt_tick_get();
+
+        if ((result = bc28_mqtt_open()) >= 0)
+        {
+            open = rt_tick_get();
+            result = bc28_mqtt_connect();
+            conn = rt_tick_get();
+        }
+
+        /* a reboot we did not see would leave the cache wrong, start over next time */
+        if (result < 0)
+        {
+            session.held = 0;
+        }
     }
 
-    if((result = bc28_mqtt_connect()) < 0) {
+    if (result < 0)
+    {
         return result;
     }
 
+    info->resub_topics = mqtt_resubscribe();
+    info->cfg_ms   = tick_ms(start, cfg);
+    info->open_ms  = tick_ms(cfg, open);
+    info->conn_ms  = tick_ms(open, conn);
+    info->resub_ms = tick_ms(conn, rt_tick_get());
+
+    LOG_I("MQTT up in %u ms: cfg %u ms (%u cmds), open %u ms, conn %u ms, resubscribe %u ms (%u topics)",
+          tick_ms(start, rt_tick_get()), info->cfg_ms, info->cfg_cmds, info->open_ms, info->conn_ms,
+          info->resub_ms, info->resub_topics);
+
     return RT_EOK;
 }
 
+int bc28_build_mqtt_network(void)
+{
+    return mqtt_link_up();
+}
+
+int bc28_rebuild_mqtt_network(void)
+{
+    bc28_mqtt_close();
+
+    return mqtt_link_up();
+}
+
 static int bc28_deactivate_pdp(void)
 {
     /* AT+CGACT=<state>,<cid> */
@@ -658,6 +1817,174 @@ static int bc28_deactivate_pdp(void)
     return RT_EOK;
 }
 
+/**
+ * Ask the recovery worker to bring the link back. Requests arriving while
+ * one is pending are merged into it; during a rebuild, the same work is
+ * taken as served by it and anything more gets another pass.
+ *
+ * @param what : BC28_RECOVER_xxx
+ *
+ * @return void
+ */
+void bc28_recover(rt_uint8_t what)
+{
+    rt_bool_t wake = RT_FALSE;
+
+    rt_enter_critical();
+    wake = (recovery.pending == 0);
+    if (recovery.since == 0)
+    {
+        recovery.since = rt_tick_get();
+    }
+    recovery.pending |= what;
+    rt_exit_critical();
+
+    bc28.stat = BC28_STAT_DISCONNECTED;
+
+    if (wake && recovery.sem)
+    {
+        rt_sem_release(recovery.sem);
+    }
+}
+
+static int bc28_recover_once(rt_uint8_t what)
+{
+    rt_tick_t deadline = rt_tick_get() + rt_tick_from_millisecond(BC28_ATTACH_TIMEOUT);
+    int result = 0;
+
+    if (what & BC28_RECOVER_ATTACH)
+    {
+        if ((result = bc28_client_attach()) != RT_EOK)
+        {
+            return result;
+        }
+
+        rt_enter_critical();
+        recovery.pending &= ~BC28_RECOVER_ATTACH;
+        rt_exit_critical();
+    }
+    else if (bc28_wait_event(BC28_EVENT_REG, rt_tick_get()) != RT_EOK)
+    {
+        /* deregistered: ask for the network again and wait for +CEREG */
+        check_send_cmd(AT_UE_ATTACH, AT_OK, 0, AT_DEFAULT_TIMEOUT);
+        if (bc28_wait_event(BC28_EVENT_REG, deadline) != RT_EOK)
+        {
+            rt_enter_critical();
+            recovery.pending |= BC28_RECOVER_ATTACH;
+            rt_exit_critical();
+            return -RT_ETIMEOUT;
+        }
+    }
+
+    if (what & BC28_RECOVER_PDP)
+    {
+        bc28_deactivate_pdp();
+    }
+
+    return bc28_rebuild_mqtt_network();
+}
+
+static void recovery_entry(void *parameter)
+{
+    rt_uint32_t backoff = 0, attempts = 0, ttr = 0;
+    rt_uint8_t what = 0, handled = 0;
+
+    while (1)
+    {
+        rt_sem_take(recovery.sem, RT_WAITING_FOREVER);
+
+        backoff  = BC28_RECOVERY_BACKOFF_MIN;
+        attempts = 0;
+        handled  = 0;
+
+        while ((what = recovery.pending) != 0)
+        {
+#ifdef PKG_USING_BC28_MQTT_ADAPTIVE_KEEPALIVE
+            /* once per request, not on every retry of it */
+            if (what & BC28_RECOVER_BACKOFF)
+            {
+                rt_enter_critical();
+                recovery.pending &= ~BC28_RECOVER_BACKOFF;
+                rt_exit_critical();
+                what &= ~BC28_RECOVER_BACKOFF;
+                keepalive_backoff();
+            }
+#endif
+            attempts++;
+            recovery.info.attempts++;
+
+            if (bc28_recover_once(what) == RT_EOK)
+            {
+                /* clear only what this pass rebuilt, a different request
+                 * that came in meanwhile stays pending for another pass */
+                rt_enter_critical();
+                recovery.pending &= ~what;
+                if (recovery.pending == 0)
+                {
+                    ttr = (rt_tick_get() - recovery.since) * 1000 / RT_TICK_PER_SECOND;
+                    recovery.since = 0;
+                }
+                rt_exit_critical();
+                handled |= what;
+                continue;
+            }
+
+            LOG_E("recovery attempt %u failed, retry in %u ms.", attempts, backoff);
+            rt_thread_mdelay(backoff);
+            backoff = (backoff * 2 < BC28_RECOVERY_BACKOFF_MAX) ? backoff * 2 : BC28_RECOVERY_BACKOFF_MAX;
+        }
+
+        /* woken for a request an earlier pass already served */
+        if (handled == 0)
+        {
+            continue;
+        }
+
+        /* a keepalive probe is a planned reconnect, not a recovery */
+        if (handled == BC28_RECOVER_PROBE)
+        {
+            LOG_I("reconnected in %u ms to probe a longer keepalive", ttr);
+            continue;
+        }
+
+        recovery.info.recoveries++;
+        recovery.info.last_ttr = ttr;
+        LOG_I("link recovered in %u ms after %u attempts", ttr, attempts);
+    }
+}
+
+static int recovery_start(void)
+{
+    if (recovery.tid)
+    {
+        return RT_EOK;
+    }
+
+    recovery.sem = rt_sem_create("bc28rcv", 0, RT_IPC_FLAG_FIFO);
+    if (recovery.sem == RT_NULL)
+    {
+        LOG_E("No memory for recovery semaphore!");
+        return -RT_ENOMEM;
+    }
+
+    recovery.tid = rt_thread_create("bc28rcv", recovery_entry, RT_NULL,
+                                    BC28_RECOVERY_THREAD_STACK, BC28_RECOVERY_THREAD_PRIORITY, 10);
+    if (recovery.tid == RT_NULL)
+    {
+        LOG_E("create recovery thread failed.");
+        return -RT_ENOMEM;
+    }
+    recovery.info.tid = recovery.tid;
+
+    return rt_thread_startup(recovery.tid);
+}
+
+void bc28_recovery_get(struct bc28_recovery_info *info)
+{
+    *info = recovery.info;
+    info->pending = (recovery.pending != 0);
+}
+
 static void urc_mqtt_stat(struct at_client *client, const char *data, rt_size_t size)
 {
     /* MQTT链路层的状态发生变化 */
@@ -680,13 +2007,21 @@ static void urc_mqtt_stat(struct at_client *client, const char *data, rt_size_t
 
     /* send package failure and disconnect by client */
     case AT_QMTSTAT_WORNG_CLOSE:
-        bc28_rebuild_mqtt_network();
+        bc28_recover(BC28_RECOVER_LINK);
         break;
 
     /* send PINGREQ package timeout or failure */
     case AT_QMTSTAT_PINGREQ_TIMEOUT:
-        bc28_deactivate_pdp();
-        bc28_rebuild_mqtt_network();
+#ifdef PKG_USING_BC28_MQTT_ADAPTIVE_KEEPALIVE
+        /* a storm of these is one NAT timeout, back off once; the worker
+         * does it, it owns the keepalive state and the store callback */
+        if (!(recovery.pending & BC28_RECOVER_PDP))
+        {
+            bc28_recover(BC28_RECOVER_LINK | BC28_RECOVER_PDP | BC28_RECOVER_BACKOFF);
+            break;
+        }
+#endif
+        bc28_recover(BC28_RECOVER_LINK | BC28_RECOVER_PDP);
         break;
 
     /* disconnect by client */
@@ -697,6 +2032,7 @@ static void urc_mqtt_stat(struct at_client *client, const char *data, rt_size_t
     /* network inactivated or server unavailable */
     case AT_QMTSTAT_INACTIVATED:
         LOG_D("please check network");
+        bc28_recover(BC28_RECOVER_LINK);
         break;
     default:
         break;
@@ -705,18 +2041,117 @@ static void urc_mqtt_stat(struct at_client *client, const char *data, rt_size_t
 
 static void urc_mqtt_recv(struct at_client *client, const char *data, rt_size_t size)
 {
+    const char *p = RT_NULL, *q = RT_NULL;
+    rt_size_t len = 0;
+
     /* 读取已从MQTT服务器接收的MQTT包数据 */
     LOG_D("AT client receive %d bytes data from server", size);
     LOG_D("%s", data);
 
-    sscanf(data, "+QMTRECV: %*d,%*d,\"%*[^\"]\",%s", buf);
-    bc28.parser(buf);
+    /* +QMTRECV: <id>,<msgid>,"<topic>",<payload>, the payload may hold spaces */
+    p = strchr(data, '"');
+    q = p ? strchr(p + 1, '"') : RT_NULL;
+
+    /* a garbled line must not hand the previous message over again */
+    if (q == RT_NULL || q[1] != ',')
+    {
+        LOG_E("malformed %s", data);
+        return;
+    }
+
+    len = size - (q + 2 - data);
+    while (len && (q[len + 1] == '\r' || q[len + 1] == '\n'))
+    {
+        len--;
+    }
+
+    /* the line buffer belongs to the AT client, the parser wants a C string */
+    rt_memcpy(recv_msg, q + 2, len);
+    recv_msg[len] = '\0';
+
+    bc28_recv_dispatch(p + 1, q - p - 1, recv_msg, len);
+}
+
+static void urc_boot_cause(struct at_client *client, const char *data, rt_size_t size)
+{
+    /* 模块重启，等待开机信息结束 */
+    LOG_D("%s", data);
+
+    bc28_clear_event(BC28_EVENT_READY | BC28_EVENT_REG);
+
+    /* QMTCFG settings do not survive a reboot */
+    session.held = 0;
+
+    /* an unexpected reboot loses the network and the MQTT session */
+    if (!recovery.boot_expected && (bc28.stat == BC28_STAT_CONNECTED || bc28.stat == BC28_STAT_DISCONNECTED))
+    {
+        LOG_E("BC28 rebooted unexpectedly.");
+        bc28_recover(BC28_RECOVER_ATTACH | BC28_RECOVER_LINK);
+    }
+}
+
+static void urc_boot_done(struct at_client *client, const char *data, rt_size_t size)
+{
+    char ok[4] = {0};
+
+    /* 开机信息以 "Neul \r\nOK\r\n" 结束，读掉 OK 以免被当作下一条命令的响应 */
+    at_client_obj_recv(client, ok, sizeof(ok), rt_tick_from_millisecond(100));
+
+    LOG_D("BC28 is ready");
+    recovery.boot_expected = RT_FALSE;
+    rt_event_send(bc28.event, BC28_EVENT_READY);
+}
+
+static void urc_reg_stat(struct at_client *client, const char *data, rt_size_t size)
+{
+    /* 主动上报 "+CEREG:<stat>[,<tac>,<ci>,<AcT>]"，查询结果 "+CEREG:<n>,<stat>[,<tac>,<ci>,<AcT>]" */
+    const char *p = data + strlen(AT_URC_REG);
+    char tac[sizeof(bc28.tac)] = {0}, ci[sizeof(bc28.ci)] = {0};
+    int stat = 0;
+
+    LOG_D("%s", data);
+
+    stat = atoi(p);
+    p = strchr(p, ',');
+    if (p && p[1] >= '0' && p[1] <= '9')
+    {
+        stat = atoi(p + 1);
+        p = strchr(p + 1, ',');
+    }
+
+    if (p && sscanf(p, ",\"%7[^\"]\",\"%11[^\"]\"", tac, ci) == 2)
+    {
+        rt_strncpy(bc28.tac, tac, sizeof(bc28.tac) - 1);
+        rt_strncpy(bc28.ci, ci, sizeof(bc28.ci) - 1);
+    }
+
+    /* 1: registered, home network; 5: registered, roaming */
+    if (stat == 1 || stat == 5)
+    {
+        rt_event_send(bc28.event, BC28_EVENT_REG);
+    }
+    else
+    {
+        bc28_clear_event(BC28_EVENT_REG);
+
+        if (bc28.stat == BC28_STAT_CONNECTED)
+        {
+            bc28_recover(BC28_RECOVER_LINK);
+        }
+    }
 }
 
 static const struct at_urc urc_table[] = {
 
-    { "+QMTSTAT:", "\r\n", urc_mqtt_stat },
-    { "+QMTRECV:", "\r\n", urc_mqtt_recv },
+    { "+QMTSTAT:",        "\r\n", urc_mqtt_stat  },
+    { "+QMTRECV:",        "\r\n", urc_mqtt_recv  },
+    { AT_URC_BOOT_CAUSE,  "\r\n", urc_boot_cause },
+    { AT_URC_BOOT_DONE,   "\r\n", urc_boot_done  },
+    { AT_URC_REG,         "\r\n", urc_reg_stat   },
+#ifdef BC28_USING_SOCKET
+    { "+NSONMI:",         "\r\n", bc28_socket_urc_recv  },
+    { "+NSOCLI:",         "\r\n", bc28_socket_urc_close },
+#endif
 };
 
 int at_client_port_init(void)
@@ -739,5 +2174,11 @@ MSH_CMD_EXPORT(bc28_mqtt_unsubscribe, AT client MQTT unsubscribe);
 MSH_CMD_EXPORT(bc28_mqtt_publish,     AT client MQTT publish);
 
 MSH_CMD_EXPORT(bc28_client_attach, AT client attach to access network);
+#ifdef PKG_USING_BC28_MQTT_ADAPTIVE_KEEPALIVE
+MSH_CMD_EXPORT(bc28_keepalive_info, show adaptive keepalive state);
+#endif
+#ifdef PKG_USING_BC28_MQTT_LINK_MONITOR
+MSH_CMD_EXPORT(bc28_link_info, show cached link quality);
+#endif
 MSH_CMD_EXPORT_ALIAS(at_client_dev_init, at_client_init, initialize AT client);
 #endif
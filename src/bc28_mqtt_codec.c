@@ -0,0 +1,275 @@
+/*
+ * Copyright (c) 2023, RudyLo <luhuadong@163.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     agent        the first version
+ */
+
+#include <string.h>
+
+#include <rtthread.h>
+
+#include "bc28_mqtt_internal.h"
+
+#ifdef PKG_USING_BC28_MQTT_CODEC
+
+/*
+ * MQTT 3.1.1 packet encoder and decoder. Encoders write into a caller
+ * buffer and return the length, 0 if it does not fit. PUBLISH encodes the
+ * header only so the payload can be sent from where it lives. The decoder
+ * points into the input buffer and copies nothing.
+ */
+
+static rt_uint8_t *put_u16(rt_uint8_t *p, rt_uint16_t v)
+{
+    p[0] = v >> 8;
+    p[1] = v & 0xFF;
+    return p + 2;
+}
+
+static rt_uint8_t *put_str(rt_uint8_t *p, const char *s, rt_size_t len)
+{
+    p = put_u16(p, len);
+    rt_memcpy(p, s, len);
+    return p + len;
+}
+
+static rt_size_t varint_len(rt_size_t value)
+{
+    return value < 128 ? 1 : (value < 16384 ? 2 : (value < 2097152 ? 3 : 4));
+}
+
+/**
+ * Write the fixed header.
+ *
+ * @return bytes written, 0 if the whole packet does not fit
+ */
+static rt_size_t put_header(rt_uint8_t *buf, rt_size_t size, rt_uint8_t first, rt_size_t remaining)
+{
+    rt_size_t n = 1;
+
+    if (remaining > BC28_MQTT_REMAINING_MAX || 1 + varint_len(remaining) + remaining > size)
+    {
+        return 0;
+    }
+
+    buf[0] = first;
+    do
+    {
+        rt_uint8_t byte = remaining % 128;
+        remaining /= 128;
+        buf[n++] = remaining ? (byte | 0x80) : byte;
+    } while (remaining);
+
+    return n;
+}
+
+rt_size_t bc28_mqtt_encode_connect(rt_uint8_t *buf, rt_size_t size, const struct bc28_mqtt_connect *opt)
+{
+    rt_size_t id_len = strlen(opt->client_id);
+    rt_size_t user_len = opt->username ? strlen(opt->username) : 0;
+    rt_size_t pass_len = opt->password ? strlen(opt->password) : 0;
+    rt_size_t remaining = 10 + 2 + id_len;
+    rt_uint8_t flags = opt->clean_session ? 0x02 : 0x00;
+    rt_uint8_t *p = buf;
+    rt_size_t n = 0;
+
+    if (opt->username)
+    {
+        flags |= 0x80;
+        remaining += 2 + user_len;
+    }
+    if (opt->password)
+    {
+        flags |= 0x40;
+        remaining += 2 + pass_len;
+    }
+
+    if ((n = put_header(buf, size, BC28_MQTT_CONNECT << 4, remaining)) == 0)
+    {
+        return 0;
+    }
+    p += n;
+
+    p = put_str(p, "MQTT", 4);
+    *p++ = 4;                       /* protocol level 3.1.1 */
+    *p++ = flags;
+    p = put_u16(p, opt->keepalive);
+    p = put_str(p, opt->client_id, id_len);
+    if (opt->username) p = put_str(p, opt->username, user_len);
+    if (opt->password) p = put_str(p, opt->password, pass_len);
+
+    return p - buf;
+}
+
+rt_size_t bc28_mqtt_encode_publish(rt_uint8_t *buf, rt_size_t size, const char *topic, rt_uint16_t id,
+                                   int qos, int retain, rt_size_t payload_len)
+{
+    rt_size_t topic_len = strlen(topic);
+    rt_size_t remaining = 2 + topic_len + (qos ? 2 : 0) + payload_len;
+    rt_uint8_t first = BC28_MQTT_PUBLISH << 4 | (qos & 0x03) << 1 | (retain ? 1 : 0);
+    rt_uint8_t *p = buf;
+    rt_size_t n = 0;
+
+    /* only the header has to fit, the payload is not copied */
+    if ((n = put_header(buf, size + payload_len, first, remaining)) == 0)
+    {
+        return 0;
+    }
+    p = put_str(p + n, topic, topic_len);
+    if (qos)
+    {
+        p = put_u16(p, id);
+    }
+
+    return p - buf;
+}
+
+rt_size_t bc28_mqtt_encode_ack(rt_uint8_t *buf, rt_uint8_t type, rt_uint16_t id)
+{
+    /* PUBREL carries the reserved flags 0b0010 */
+    buf[0] = type << 4 | (type == BC28_MQTT_PUBREL ? 0x02 : 0x00);
+    buf[1] = 2;
+    put_u16(buf + 2, id);
+
+    return 4;
+}
+
+rt_size_t bc28_mqtt_encode_subscribe(rt_uint8_t *buf, rt_size_t size, rt_uint8_t type, rt_uint16_t id,
+                                     const char *topic, int qos)
+{
+    rt_size_t topic_len = strlen(topic);
+    rt_size_t remaining = 2 + 2 + topic_len + (type == BC28_MQTT_SUBSCRIBE ? 1 : 0);
+    rt_uint8_t *p = buf;
+    rt_size_t n = 0;
+
+    if ((n = put_header(buf, size, type << 4 | 0x02, remaining)) == 0)
+    {
+        return 0;
+    }
+    p = put_u16(p + n, id);
+    p = put_str(p, topic, topic_len);
+    if (type == BC28_MQTT_SUBSCRIBE)
+    {
+        *p++ = qos & 0x03;
+    }
+
+    return p - buf;
+}
+
+rt_size_t bc28_mqtt_encode_simple(rt_uint8_t *buf, rt_uint8_t type)
+{
+    buf[0] = type << 4;
+    buf[1] = 0;
+
+    return 2;
+}
+
+/**
+ * Decode one packet from the head of a stream buffer.
+ *
+ * @param buf  received bytes
+ * @param len  number of bytes available
+ * @param pkt  decoded packet, topic and payload point into buf
+ *
+ * @return >0 : bytes consumed by the packet
+ *          0 : packet incomplete, wait for more bytes
+ *         <0 : malformed packet
+ */
+int bc28_mqtt_decode(const rt_uint8_t *buf, rt_size_t len, struct bc28_mqtt_packet *pkt)
+{
+    rt_size_t remaining = 0, n = 1, multiplier = 1;
+    const rt_uint8_t *p = RT_NULL, *end = RT_NULL;
+
+    if (len < 2)
+    {
+        return 0;
+    }
+
+    do
+    {
+        /* at most 4 length bytes, a fifth is malformed even if not received yet */
+        if (n > 4)
+        {
+            return -RT_ERROR;
+        }
+        if (n >= len)
+        {
+            return 0;
+        }
+        remaining += (buf[n] & 0x7F) * multiplier;
+        multiplier *= 128;
+    } while (buf[n++] & 0x80);
+
+    if (n + remaining > len)
+    {
+        return 0;
+    }
+
+    rt_memset(pkt, 0, sizeof(*pkt));
+    pkt->type  = buf[0] >> 4;
+    pkt->flags = buf[0] & 0x0F;
+    p   = buf + n;
+    end = p + remaining;
+
+    /* reserved flags: 0b0010 for PUBREL, 0 for everything else but PUBLISH */
+    if (pkt->type == BC28_MQTT_PUBLISH ? ((pkt->flags >> 1) & 0x03) == 3
+                                       : pkt->flags != (pkt->type == BC28_MQTT_PUBREL ? 0x02 : 0x00))
+    {
+        return -RT_ERROR;
+    }
+
+    switch (pkt->type)
+    {
+    case BC28_MQTT_CONNACK:
+        if (remaining < 2) return -RT_ERROR;
+        pkt->session = p[0] & 0x01;
+        pkt->rc      = p[1];
+        break;
+
+    case BC28_MQTT_PUBLISH:
+        if (remaining < 2) return -RT_ERROR;
+        pkt->topic_len = p[0] << 8 | p[1];
+        pkt->topic     = (const char *)p + 2;
+        if (2 + (rt_size_t)pkt->topic_len > remaining) return -RT_ERROR;
+        p += 2 + pkt->topic_len;
+        if ((pkt->flags >> 1) & 0x03)
+        {
+            if (p + 2 > end) return -RT_ERROR;
+            pkt->id = p[0] << 8 | p[1];
+            p += 2;
+        }
+        if (p > end) return -RT_ERROR;
+        pkt->payload     = p;
+        pkt->payload_len = end - p;
+        break;
+
+    case BC28_MQTT_PUBACK:
+    case BC28_MQTT_PUBREC:
+    case BC28_MQTT_PUBREL:
+    case BC28_MQTT_PUBCOMP:
+    case BC28_MQTT_UNSUBACK:
+        if (remaining < 2) return -RT_ERROR;
+        pkt->id = p[0] << 8 | p[1];
+        break;
+
+    case BC28_MQTT_SUBACK:
+        if (remaining < 3) return -RT_ERROR;
+        pkt->id = p[0] << 8 | p[1];
+        pkt->rc = p[2];
+        break;
+
+    case BC28_MQTT_PINGRESP:
+        break;
+
+    default:
+        return -RT_ERROR;
+    }
+
+    return n + remaining;
+}
+
+#endif /* PKG_USING_BC28_MQTT_CODEC */
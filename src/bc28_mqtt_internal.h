@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2023, RudyLo <luhuadong@163.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     agent        the first version
+ */
+
+#ifndef __BC28_MQTT_INTERNAL_H__
+#define __BC28_MQTT_INTERNAL_H__
+
+#include "bc28_mqtt.h"
+
+#if defined(PKG_USING_BC28_MQTT_SN) || defined(PKG_USING_BC28_MQTT_CODEC)
+#define BC28_USING_SOCKET
+#endif
+
+/* AT client line buffer, a longer line or URC is dropped by the client */
+#ifdef PKG_USING_BC28_MQTT_RECV_BUFF_LEN
+#define AT_CLIENT_RECV_BUFF_LEN       PKG_USING_BC28_MQTT_RECV_BUFF_LEN
+#else
+#define AT_CLIENT_RECV_BUFF_LEN       256
+#endif
+
+/* MQTT transport selected by bc28_mqtt_set_transport() */
+struct bc28_transport_ops
+{
+    int  (*connect)(void);
+    int  (*close)(void);
+    int  (*subscribe)(const char *topic);
+    int  (*unsubscribe)(const char *topic);
+    int  (*publish)(const char *topic, const char *msg);
+    rt_bool_t (*resumed)(void);     /* broker kept the session, RT_NULL if never */
+    rt_size_t payload_max;          /* longest payload publish() takes */
+};
+
+/* what the recovery worker has to redo, see bc28_recover() */
+#define BC28_RECOVER_LINK             (1 << 0)   /* rebuild the MQTT connection */
+#define BC28_RECOVER_PDP              (1 << 1)   /* deactivate the PDP context first */
+#define BC28_RECOVER_ATTACH           (1 << 2)   /* module rebooted or lost the network, attach again */
+#define BC28_RECOVER_PROBE            (1 << 3)   /* reconnect to try a longer keepalive */
+#define BC28_RECOVER_BACKOFF          (1 << 4)   /* PINGREQ timed out, shorten the keepalive first */
+
+/* link recovery counters */
+struct bc28_recovery_info
+{
+    rt_thread_t  tid;               /* recovery worker */
+    rt_bool_t    pending;           /* recovery requested or running */
+    rt_uint32_t  recoveries;        /* completed recoveries */
+    rt_uint32_t  attempts;          /* rebuild attempts, failed ones included */
+    rt_uint32_t  last_ttr;          /* first failure to link up, ms */
+
+    /* last link build, ms per phase */
+    rt_uint32_t  cfg_ms;
+    rt_uint32_t  open_ms;
+    rt_uint32_t  conn_ms;
+    rt_uint32_t  resub_ms;
+    rt_uint8_t   cfg_cmds;          /* QMTCFG commands sent, 0 on the fast path */
+    rt_uint8_t   resub_topics;      /* topics subscribed again */
+};
+
+/* fills buf with the next piece of a long command line, returns 0 at the end */
+typedef rt_size_t (*bc28_cmd_body_t)(char *buf, rt_size_t size, void *arg);
+
+bc28_device_t bc28_get_device(void);
+int  bc28_exec_cmd(at_response_t resp, const char *cmd_expr, ...);
+int  bc28_exec_vcmd(at_response_t resp, const char *cmd_expr, va_list args);
+int  bc28_exec_long(at_response_t resp, bc28_cmd_body_t body, void *arg, const char *head_expr, ...);
+void bc28_recv_dispatch(const char *topic, rt_size_t topic_len, const char *payload, rt_size_t len);
+void bc28_recover(rt_uint8_t what);
+void bc28_recovery_get(struct bc28_recovery_info *info);
+rt_bool_t bc28_transport_binary(void);
+rt_size_t bc28_mqtt_payload_max(void);
+
+#ifdef BC28_USING_SOCKET
+#define BC28_SOCKET_MAX               7
+/* AT+NSOST and AT+NSOSD carry at most 512 bytes per command */
+#define BC28_SOCKET_PAYLOAD_MAX       512
+
+typedef enum bc28_socket_type
+{
+    BC28_SOCKET_UDP = 0,
+    BC28_SOCKET_TCP
+
+} bc28_socket_type_t;
+
+/* called from the AT parser thread, data is RT_NULL when the peer closed */
+typedef void (*bc28_socket_recv_t)(int socket, const rt_uint8_t *data, rt_size_t len);
+
+struct bc28_iovec
+{
+    const void *base;
+    rt_size_t   len;
+};
+
+int  bc28_socket_create(bc28_socket_type_t type, rt_uint16_t port, bc28_socket_recv_t recv);
+int  bc28_socket_connect(int socket, const char *ip, rt_uint16_t port);
+int  bc28_socket_sendto(int socket, const char *ip, rt_uint16_t port, const void *data, rt_size_t len);
+int  bc28_socket_send(int socket, const void *data, rt_size_t len);
+int  bc28_socket_sendv(int socket, const struct bc28_iovec *iov, int count);
+int  bc28_socket_close(int socket);
+
+void bc28_socket_urc_recv(struct at_client *client, const char *data, rt_size_t size);
+void bc28_socket_urc_close(struct at_client *client, const char *data, rt_size_t size);
+#endif
+
+#ifdef PKG_USING_BC28_MQTT_TAP
+#define BC28_TAP_DEV_NAME             "bc28tap"
+
+/* tap state and the counters of the last record or replay */
+struct bc28_tap_info
+{
+    rt_bool_t    recording;
+    rt_bool_t    replaying;
+    rt_uint32_t  recorded;          /* bytes written to the capture */
+    rt_uint32_t  dropped;           /* bytes lost to a full record buffer */
+    rt_uint32_t  records;           /* records replayed */
+    rt_uint32_t  replay_ms;         /* duration of the last finished replay */
+    rt_uint32_t  mismatch;          /* commands that differ from the capture */
+    rt_uint32_t  stalled;           /* commands the AT client never sent */
+};
+
+int  bc28_tap_init(const char *uart_name);
+int  bc28_tap_filter(rt_sem_t notify);
+rt_size_t bc28_tap_uart_read(void *buffer, rt_size_t size);
+void bc28_tap_feed(const void *data, rt_size_t len);
+void bc28_tap_info_get(struct bc28_tap_info *info);
+#endif
+
+#ifdef PKG_USING_BC28_MQTT_OTA
+rt_bool_t bc28_ota_recv(const char *topic, rt_size_t topic_len, const char *payload, rt_size_t len);
+#endif
+
+#ifdef PKG_USING_BC28_MQTT_SN
+extern const struct bc28_transport_ops bc28_mqttsn_ops;
+#endif
+
+#ifdef PKG_USING_BC28_MQTT_CODEC
+/* MQTT 3.1.1 control packet types */
+#define BC28_MQTT_CONNECT             1
+#define BC28_MQTT_CONNACK             2
+#define BC28_MQTT_PUBLISH             3
+#define BC28_MQTT_PUBACK              4
+#define BC28_MQTT_PUBREC              5
+#define BC28_MQTT_PUBREL              6
+#define BC28_MQTT_PUBCOMP             7
+#define BC28_MQTT_SUBSCRIBE           8
+#define BC28_MQTT_SUBACK              9
+#define BC28_MQTT_UNSUBSCRIBE         10
+#define BC28_MQTT_UNSUBACK            11
+#define BC28_MQTT_PINGREQ             12
+#define BC28_MQTT_PINGRESP            13
+#define BC28_MQTT_DISCONNECT          14
+
+#define BC28_MQTT_REMAINING_MAX       268435455
+
+struct bc28_mqtt_connect
+{
+    const char  *client_id;
+    const char  *username;          /* RT_NULL if not used */
+    const char  *password;          /* RT_NULL if not used */
+    rt_uint16_t  keepalive;
+    rt_uint8_t   clean_session;
+};
+
+/* decoded packet, topic and payload point into the decode buffer */
+struct bc28_mqtt_packet
+{
+    rt_uint8_t        type;
+    rt_uint8_t        flags;
+    rt_uint8_t        rc;           /* CONNACK return code, SUBACK granted QoS */
+    rt_uint8_t        session;      /* CONNACK session present */
+    rt_uint16_t       id;
+    rt_uint16_t       topic_len;
+    const char       *topic;
+    const rt_uint8_t *payload;
+    rt_size_t         payload_len;
+};
+
+rt_size_t bc28_mqtt_encode_connect(rt_uint8_t *buf, rt_size_t size, const struct bc28_mqtt_connect *opt);
+rt_size_t bc28_mqtt_encode_publish(rt_uint8_t *buf, rt_size_t size, const char *topic, rt_uint16_t id,
+                                   int qos, int retain, rt_size_t payload_len);
+rt_size_t bc28_mqtt_encode_ack(rt_uint8_t *buf, rt_uint8_t type, rt_uint16_t id);
+rt_size_t bc28_mqtt_encode_subscribe(rt_uint8_t *buf, rt_size_t size, rt_uint8_t type, rt_uint16_t id,
+                                     const char *topic, int qos);
+rt_size_t bc28_mqtt_encode_simple(rt_uint8_t *buf, rt_uint8_t type);
+int       bc28_mqtt_decode(const rt_uint8_t *buf, rt_size_t len, struct bc28_mqtt_packet *pkt);
+
+extern const struct bc28_transport_ops bc28_mqttc_ops;
+#endif
+
+#endif /* __BC28_MQTT_INTERNAL_H__ */
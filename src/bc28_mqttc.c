@@ -0,0 +1,859 @@
+/*
+ * Copyright (c) 2023, RudyLo <luhuadong@163.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     agent        the first version
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <rtthread.h>
+#include <rtdevice.h>
+#include <at.h>
+
+#define DBG_TAG                       "pkg.bc28_mqttc"
+#ifdef PKG_USING_BC28_MQTT_DEBUG
+#define DBG_LVL                       DBG_LOG
+#else
+#define DBG_LVL                       DBG_ERROR
+#endif
+#include <rtdbg.h>
+
+#include "bc28_mqtt_internal.h"
+
+#ifdef PKG_USING_BC28_MQTT_CODEC
+
+#ifndef PKG_USING_BC28_MQTT_CODEC_BROKER_ADDR
+#define PKG_USING_BC28_MQTT_CODEC_BROKER_ADDR    "127.0.0.1"
+#endif
+#ifndef PKG_USING_BC28_MQTT_CODEC_BROKER_PORT
+#define PKG_USING_BC28_MQTT_CODEC_BROKER_PORT    1883
+#endif
+#ifndef PKG_USING_BC28_MQTT_CODEC_QOS
+#define PKG_USING_BC28_MQTT_CODEC_QOS            1
+#endif
+#ifndef PKG_USING_BC28_MQTT_CODEC_WINDOW
+#define PKG_USING_BC28_MQTT_CODEC_WINDOW         4
+#endif
+#ifndef PKG_USING_BC28_MQTT_CODEC_RX_LEN
+#define PKG_USING_BC28_MQTT_CODEC_RX_LEN         1024
+#endif
+#ifdef PKG_USING_BC28_MQTT_CODEC_PERSISTENT
+#define MC_CLEAN_SESSION              0
+#else
+#define MC_CLEAN_SESSION              1
+#endif
+
+#define MC_BROKER_ADDR                PKG_USING_BC28_MQTT_CODEC_BROKER_ADDR
+#define MC_BROKER_PORT                PKG_USING_BC28_MQTT_CODEC_BROKER_PORT
+#define MC_DEFAULT_QOS                PKG_USING_BC28_MQTT_CODEC_QOS
+#define MC_WINDOW                     PKG_USING_BC28_MQTT_CODEC_WINDOW
+#define MC_RX_LEN                     PKG_USING_BC28_MQTT_CODEC_RX_LEN
+#define MC_KEEP_ALIVE                 PKG_USING_BC28_MQTT_KEEP_ALIVE
+
+#define MC_TOPIC_MAX                  128
+#define MC_PUB_HEADER_LEN             9          /* fixed header, topic length and packet id */
+/* what the generic interface takes: a message echoed back on any topic
+ * still fits the receive stream */
+#define MC_PAYLOAD_MAX                (MC_RX_LEN - MC_PUB_HEADER_LEN - MC_TOPIC_MAX)
+#if MC_RX_LEN <= MC_PUB_HEADER_LEN + MC_TOPIC_MAX
+#error "PKG_USING_BC28_MQTT_CODEC_RX_LEN leaves no room for a payload"
+#endif
+#define MC_ACK_TIMEOUT                10000
+#define MC_RETRY_TIMEOUT              20000
+#define MC_RETRY_TIMES                3
+#define MC_WINDOW_TIMEOUT             30000
+#define MC_THREAD_STACK               2048
+#define MC_THREAD_PRIORITY            (RT_THREAD_PRIORITY_MAX / 2)
+
+enum mc_state
+{
+    MC_FREE = 0,
+    MC_WAIT_PUBACK,
+    MC_WAIT_PUBREC,
+    MC_WAIT_PUBCOMP
+};
+
+/* outgoing QoS 1/2 message waiting for the broker */
+struct mc_inflight
+{
+    rt_uint16_t  id;
+    rt_uint8_t   state;
+    rt_uint8_t   retries;
+    rt_tick_t    sent;
+    rt_uint8_t  *pkt;       /* encoded PUBLISH kept for retransmission */
+    rt_size_t    len;
+};
+
+struct bc28_mqttc
+{
+    int          socket;
+    rt_bool_t    connected;
+    rt_bool_t    overflow;
+    rt_uint16_t  packet_id;
+    rt_tick_t    last_tx;
+    rt_tick_t    ping_sent;
+
+    rt_mutex_t   lock;      /* inflight and incoming QoS 2 tables */
+    rt_mutex_t   tx_lock;   /* keep whole packets together on the stream */
+    rt_mutex_t   req_lock;  /* one request waiting for its ack at a time */
+    rt_sem_t     ack;
+    rt_sem_t     window;
+    rt_sem_t     rx_notify;
+    rt_thread_t  tid;
+
+    rt_uint8_t   wait_type;
+    rt_uint16_t  wait_id;
+    rt_uint8_t   reply_rc;
+    rt_uint8_t   reply_session;
+    rt_bool_t    resumed;   /* the last CONNACK had session present */
+
+    const char  *client_id;
+    const char  *username;
+    const char  *password;
+
+    struct mc_inflight inflight[MC_WINDOW];
+    rt_uint16_t  qos2_rx[MC_WINDOW];   /* QoS 2 ids waiting for PUBREL, oldest first */
+    rt_uint8_t   qos2_count;
+
+    struct rt_ringbuffer rx_ring;
+    rt_uint8_t   rx_pool[MC_RX_LEN];
+    rt_uint8_t   stream[MC_RX_LEN + 1];
+    rt_size_t    stream_len;
+};
+
+static struct bc28_mqttc mc = {
+    .socket = -1
+};
+
+static rt_uint16_t mc_next_id(void)
+{
+    if (++mc.packet_id == 0)
+    {
+        mc.packet_id = 1;
+    }
+
+    return mc.packet_id;
+}
+
+static int mc_sendv(const struct bc28_iovec *iov, int count)
+{
+    int result = 0;
+
+    rt_mutex_take(mc.tx_lock, RT_WAITING_FOREVER);
+    result = bc28_socket_sendv(mc.socket, iov, count);
+    mc.last_tx = rt_tick_get();
+    rt_mutex_release(mc.tx_lock);
+
+    return result;
+}
+
+static int mc_send(const void *data, rt_size_t len)
+{
+    struct bc28_iovec iov = { data, len };
+
+    return mc_sendv(&iov, 1);
+}
+
+static int mc_send_ack(rt_uint8_t type, rt_uint16_t id)
+{
+    rt_uint8_t pkt[4];
+
+    return mc_send(pkt, bc28_mqtt_encode_ack(pkt, type, id));
+}
+
+/**
+ * Send a request and wait for its ack, TCP retransmits for us.
+ *
+ * @return  RT_EOK       ack received, rc in mc.reply_rc
+ *         -RT_ETIMEOUT  no ack
+ */
+static int mc_request(const rt_uint8_t *pkt, rt_size_t len, rt_uint8_t type, rt_uint16_t id)
+{
+    int result = 0;
+
+    rt_mutex_take(mc.req_lock, RT_WAITING_FOREVER);
+
+    rt_sem_control(mc.ack, RT_IPC_CMD_RESET, RT_NULL);
+    mc.wait_type = type;
+    mc.wait_id   = id;
+
+    result = mc_send(pkt, len);
+    if (result == RT_EOK && rt_sem_take(mc.ack, rt_tick_from_millisecond(MC_ACK_TIMEOUT)) != RT_EOK)
+    {
+        result = -RT_ETIMEOUT;
+    }
+
+    mc.wait_type = 0;
+
+    rt_mutex_release(mc.req_lock);
+    return result;
+}
+
+static void mc_inflight_free(struct mc_inflight *slot)
+{
+    if (slot->pkt)
+    {
+        rt_free(slot->pkt);
+    }
+    rt_memset(slot, 0, sizeof(*slot));
+    rt_sem_release(mc.window);
+}
+
+static struct mc_inflight *mc_inflight_find(rt_uint16_t id, rt_uint8_t state)
+{
+    for (int i = 0; i < MC_WINDOW; i++)
+    {
+        if (mc.inflight[i].id == id && mc.inflight[i].state == state)
+        {
+            return &mc.inflight[i];
+        }
+    }
+
+    return RT_NULL;
+}
+
+/* the connection broke under us, let the recovery worker rebuild it */
+static void mc_lost(const char *reason)
+{
+    rt_bool_t connected = mc.connected;
+
+    mc.connected = RT_FALSE;
+    mc.ping_sent = 0;
+
+    if (connected)
+    {
+        LOG_E("connection lost: %s", reason);
+        bc28_recover(BC28_RECOVER_LINK);
+    }
+}
+
+static void mc_recv(int socket, const rt_uint8_t *data, rt_size_t len)
+{
+    if (data == RT_NULL)
+    {
+        mc_lost("closed by broker");
+        rt_sem_release(mc.rx_notify);
+        return;
+    }
+
+    /* runs in the AT parser thread, a lost byte breaks the stream for good */
+    rt_enter_critical();
+    if (rt_ringbuffer_space_len(&mc.rx_ring) < len)
+    {
+        mc.overflow = RT_TRUE;
+    }
+    else
+    {
+        rt_ringbuffer_put(&mc.rx_ring, data, len);
+    }
+    rt_exit_critical();
+
+    rt_sem_release(mc.rx_notify);
+}
+
+static void mc_handle_publish(struct bc28_mqtt_packet *pkt)
+{
+    int qos = (pkt->flags >> 1) & 0x03;
+    rt_uint8_t *end = (rt_uint8_t *)pkt->payload + pkt->payload_len;
+    rt_uint8_t saved = *end;
+    rt_bool_t duplicate = RT_FALSE;
+    int i = 0;
+
+    if (qos == 2)
+    {
+        /* delivered once, the broker repeats until our PUBREC gets through */
+        rt_mutex_take(mc.lock, RT_WAITING_FOREVER);
+        for (i = 0; i < mc.qos2_count && mc.qos2_rx[i] != pkt->id; i++);
+        duplicate = (i < mc.qos2_count);
+        if (!duplicate)
+        {
+            /* the oldest has waited longest for its PUBREL, a repeat of it
+             * would be delivered twice */
+            if (mc.qos2_count == MC_WINDOW)
+            {
+                LOG_W("QoS 2 table full, forget packet %d", mc.qos2_rx[0]);
+                rt_memmove(mc.qos2_rx, mc.qos2_rx + 1, (MC_WINDOW - 1) * sizeof(mc.qos2_rx[0]));
+                mc.qos2_count--;
+            }
+            mc.qos2_rx[mc.qos2_count++] = pkt->id;
+        }
+        rt_mutex_release(mc.lock);
+    }
+
+    if (!duplicate)
+    {
+        /* NUL terminate in place, the stream buffer has a spare byte at the end */
+        *end = '\0';
+        bc28_recv_dispatch((const char *)pkt->topic, pkt->topic_len, (const char *)pkt->payload, pkt->payload_len);
+        *end = saved;
+    }
+
+    if (qos == 1)
+    {
+        mc_send_ack(BC28_MQTT_PUBACK, pkt->id);
+    }
+    else if (qos == 2)
+    {
+        mc_send_ack(BC28_MQTT_PUBREC, pkt->id);
+    }
+}
+
+static void mc_handle(struct bc28_mqtt_packet *pkt)
+{
+    struct mc_inflight *slot = RT_NULL;
+
+    switch (pkt->type)
+    {
+    case BC28_MQTT_PUBLISH:
+        mc_handle_publish(pkt);
+        return;
+
+    case BC28_MQTT_PUBACK:
+    case BC28_MQTT_PUBCOMP:
+        rt_mutex_take(mc.lock, RT_WAITING_FOREVER);
+        slot = mc_inflight_find(pkt->id, pkt->type == BC28_MQTT_PUBACK ? MC_WAIT_PUBACK : MC_WAIT_PUBCOMP);
+        if (slot)
+        {
+            mc_inflight_free(slot);
+        }
+        rt_mutex_release(mc.lock);
+        return;
+
+    case BC28_MQTT_PUBREC:
+        rt_mutex_take(mc.lock, RT_WAITING_FOREVER);
+        slot = mc_inflight_find(pkt->id, MC_WAIT_PUBREC);
+        if (slot)
+        {
+            /* the message is stored by the broker, only PUBREL is left to repeat */
+            rt_free(slot->pkt);
+            slot->pkt     = RT_NULL;
+            slot->state   = MC_WAIT_PUBCOMP;
+            slot->retries = 0;
+            slot->sent    = rt_tick_get();
+        }
+        rt_mutex_release(mc.lock);
+        mc_send_ack(BC28_MQTT_PUBREL, pkt->id);
+        return;
+
+    case BC28_MQTT_PUBREL:
+        rt_mutex_take(mc.lock, RT_WAITING_FOREVER);
+        for (int i = 0; i < mc.qos2_count; i++)
+        {
+            if (mc.qos2_rx[i] == pkt->id)
+            {
+                rt_memmove(mc.qos2_rx + i, mc.qos2_rx + i + 1, (mc.qos2_count - i - 1) * sizeof(mc.qos2_rx[0]));
+                mc.qos2_count--;
+                break;
+            }
+        }
+        rt_mutex_release(mc.lock);
+        mc_send_ack(BC28_MQTT_PUBCOMP, pkt->id);
+        return;
+
+    case BC28_MQTT_PINGRESP:
+        mc.ping_sent = 0;
+        break;
+
+    default:
+        break;
+    }
+
+    if (mc.wait_type == pkt->type && (mc.wait_id == 0 || mc.wait_id == pkt->id))
+    {
+        mc.reply_rc      = pkt->rc;
+        mc.reply_session = pkt->session;
+        mc.wait_type     = 0;
+        rt_sem_release(mc.ack);
+    }
+}
+
+/**
+ * Move received bytes into the stream buffer and decode every complete
+ * packet in place.
+ *
+ * @return void
+ */
+static void mc_drain(void)
+{
+    struct bc28_mqtt_packet pkt;
+    rt_size_t off = 0;
+    int used = 0;
+
+    rt_enter_critical();
+    mc.stream_len += rt_ringbuffer_get(&mc.rx_ring, mc.stream + mc.stream_len, MC_RX_LEN - mc.stream_len);
+    rt_exit_critical();
+
+    if (mc.overflow)
+    {
+        mc.overflow = RT_FALSE;
+        mc.stream_len = 0;
+        mc_lost("receive overflow");
+        return;
+    }
+
+    while (off < mc.stream_len && (used = bc28_mqtt_decode(mc.stream + off, mc.stream_len - off, &pkt)) > 0)
+    {
+        mc_handle(&pkt);
+        off += used;
+    }
+
+    if (used < 0 || (off == 0 && mc.stream_len == MC_RX_LEN))
+    {
+        mc.stream_len = 0;
+        mc_lost(used < 0 ? "malformed packet" : "packet exceeds PKG_USING_BC28_MQTT_CODEC_RX_LEN");
+        return;
+    }
+
+    rt_memmove(mc.stream, mc.stream + off, mc.stream_len - off);
+    mc.stream_len -= off;
+}
+
+static void mc_retransmit(rt_bool_t all)
+{
+    rt_tick_t now = rt_tick_get();
+    rt_bool_t lost = RT_FALSE;
+
+    rt_mutex_take(mc.lock, RT_WAITING_FOREVER);
+    for (int i = 0; i < MC_WINDOW; i++)
+    {
+        struct mc_inflight *slot = &mc.inflight[i];
+
+        if (slot->id == 0 || (!all && now - slot->sent < (rt_tick_t)rt_tick_from_millisecond(MC_RETRY_TIMEOUT)))
+        {
+            continue;
+        }
+
+        if (++slot->retries > MC_RETRY_TIMES)
+        {
+            lost = RT_TRUE;
+            break;
+        }
+
+        if (slot->state == MC_WAIT_PUBCOMP)
+        {
+            mc_send_ack(BC28_MQTT_PUBREL, slot->id);
+        }
+        else
+        {
+            slot->pkt[0] |= 0x08;   /* DUP */
+            mc_send(slot->pkt, slot->len);
+        }
+        slot->sent = now;
+    }
+    rt_mutex_release(mc.lock);
+
+    if (lost)
+    {
+        mc_lost("no ack from broker");
+    }
+}
+
+static void mc_thread_entry(void *parameter)
+{
+    rt_int32_t keepalive = rt_tick_from_millisecond(MC_KEEP_ALIVE * 1000);
+    rt_int32_t timeout = 0;
+    rt_uint8_t ping[2];
+
+    while (1)
+    {
+        timeout = mc.connected ? (rt_int32_t)rt_tick_from_millisecond(MC_RETRY_TIMEOUT / 2) : RT_WAITING_FOREVER;
+        rt_sem_take(mc.rx_notify, timeout);
+
+        mc_drain();
+
+        if (!mc.connected)
+        {
+            continue;
+        }
+
+        mc_retransmit(RT_FALSE);
+
+        if (mc.ping_sent && (rt_int32_t)(rt_tick_get() - mc.ping_sent) > keepalive / 2)
+        {
+            mc_lost("no PINGRESP");
+        }
+        else if (!mc.ping_sent && (rt_int32_t)(rt_tick_get() - mc.last_tx) >= keepalive - timeout)
+        {
+            mc.ping_sent = rt_tick_get();
+            mc_send(ping, bc28_mqtt_encode_simple(ping, BC28_MQTT_PINGREQ));
+        }
+    }
+}
+
+static int mc_open(void)
+{
+    if (mc.lock == RT_NULL)
+    {
+        mc.lock      = rt_mutex_create("bc28mc", RT_IPC_FLAG_PRIO);
+        mc.tx_lock   = rt_mutex_create("bc28mct", RT_IPC_FLAG_PRIO);
+        mc.req_lock  = rt_mutex_create("bc28mcr", RT_IPC_FLAG_PRIO);
+        mc.ack       = rt_sem_create("bc28mc", 0, RT_IPC_FLAG_FIFO);
+        mc.window    = rt_sem_create("bc28mcw", MC_WINDOW, RT_IPC_FLAG_FIFO);
+        mc.rx_notify = rt_sem_create("bc28mcx", 0, RT_IPC_FLAG_FIFO);
+        if (!mc.lock || !mc.tx_lock || !mc.req_lock || !mc.ack || !mc.window || !mc.rx_notify)
+        {
+            LOG_E("No memory for MQTT client!");
+            return -RT_ENOMEM;
+        }
+        rt_ringbuffer_init(&mc.rx_ring, mc.rx_pool, sizeof(mc.rx_pool));
+    }
+
+    if (mc.tid == RT_NULL)
+    {
+        mc.tid = rt_thread_create("bc28mc", mc_thread_entry, RT_NULL,
+                                  MC_THREAD_STACK, MC_THREAD_PRIORITY, 10);
+        if (mc.tid == RT_NULL)
+        {
+            LOG_E("create MQTT client thread failed.");
+            return -RT_ENOMEM;
+        }
+        rt_thread_startup(mc.tid);
+    }
+
+    return RT_EOK;
+}
+
+/**
+ * Set the credentials sent in CONNECT, the strings must stay valid.
+ *
+ * @param client_id : client identifier, RT_NULL for the IMEI
+ * @param username  : user name, RT_NULL if not used
+ * @param password  : password, RT_NULL if not used
+ *
+ * @return void
+ */
+void bc28_mqttc_set_auth(const char *client_id, const char *username, const char *password)
+{
+    mc.client_id = client_id;
+    mc.username  = username;
+    mc.password  = password;
+}
+
+/**
+ * Open a TCP socket to the broker and connect.
+ *
+ * @return 0 : connect success
+ *        <0 : connect failed
+ */
+int bc28_mqttc_connect(void)
+{
+    bc28_device_t device = bc28_get_device();
+    struct bc28_mqtt_connect opt = {0};
+    rt_uint8_t *buf = RT_NULL;
+    rt_size_t size = 0, len = 0;
+    int result = 0;
+
+    if ((result = mc_open()) != RT_EOK)
+    {
+        return result;
+    }
+
+    if (mc.socket >= 0)
+    {
+        bc28_socket_close(mc.socket);
+    }
+
+    rt_enter_critical();
+    rt_ringbuffer_reset(&mc.rx_ring);
+    mc.stream_len = 0;
+    mc.overflow   = RT_FALSE;
+    rt_exit_critical();
+
+    mc.socket = bc28_socket_create(BC28_SOCKET_TCP, 0, mc_recv);
+    if (mc.socket < 0)
+    {
+        return -RT_ERROR;
+    }
+
+    if (bc28_socket_connect(mc.socket, MC_BROKER_ADDR, MC_BROKER_PORT) != RT_EOK)
+    {
+        LOG_E("TCP connect to %s:%d failed.", MC_BROKER_ADDR, MC_BROKER_PORT);
+        return -RT_ERROR;
+    }
+
+    opt.client_id     = mc.client_id ? mc.client_id : device->imei;
+    opt.username      = mc.username;
+    opt.password      = mc.password;
+    opt.keepalive     = MC_KEEP_ALIVE;
+    opt.clean_session = MC_CLEAN_SESSION;
+
+    size = 32 + strlen(opt.client_id) + (opt.username ? strlen(opt.username) : 0)
+              + (opt.password ? strlen(opt.password) : 0);
+    buf = rt_malloc(size);
+    if (buf == RT_NULL)
+    {
+        return -RT_ENOMEM;
+    }
+
+    len = bc28_mqtt_encode_connect(buf, size, &opt);
+    result = mc_request(buf, len, BC28_MQTT_CONNACK, 0);
+    rt_free(buf);
+
+    if (result != RT_EOK || mc.reply_rc != 0)
+    {
+        LOG_E("MQTT connect failed (%d, rc %d).", result, mc.reply_rc);
+        return -RT_ERROR;
+    }
+
+    mc.ping_sent = 0;
+    mc.connected = RT_TRUE;
+    mc.resumed   = mc.reply_session;
+    device->stat = BC28_STAT_CONNECTED;
+
+    rt_mutex_take(mc.lock, RT_WAITING_FOREVER);
+    for (int i = 0; i < MC_WINDOW; i++)
+    {
+        if (mc.inflight[i].id == 0)
+        {
+            continue;
+        }
+
+        /* a new session forgets everything in flight, a resumed one gets
+         * MC_RETRY_TIMES fresh retries on this connection */
+        if (!mc.reply_session)
+        {
+            mc_inflight_free(&mc.inflight[i]);
+        }
+        else
+        {
+            mc.inflight[i].retries = 0;
+            mc.inflight[i].sent    = rt_tick_get();
+        }
+    }
+    if (!mc.reply_session)
+    {
+        mc.qos2_count = 0;
+    }
+    rt_mutex_release(mc.lock);
+
+    /* a resumed session completes what was in flight before the drop */
+    if (mc.reply_session)
+    {
+        mc_retransmit(RT_TRUE);
+    }
+
+    return RT_EOK;
+}
+
+/**
+ * Disconnect from the broker and close the socket.
+ *
+ * @return 0 : success
+ */
+int bc28_mqttc_close(void)
+{
+    rt_uint8_t pkt[2];
+
+    if (mc.socket < 0)
+    {
+        return RT_EOK;
+    }
+
+    if (mc.connected)
+    {
+        mc_send(pkt, bc28_mqtt_encode_simple(pkt, BC28_MQTT_DISCONNECT));
+    }
+
+    /* asked for, not a loss to recover from */
+    mc.connected = RT_FALSE;
+    mc.ping_sent = 0;
+    bc28_get_device()->stat = BC28_STAT_DISCONNECTED;
+
+    bc28_socket_close(mc.socket);
+    mc.socket = -1;
+
+    return RT_EOK;
+}
+
+/**
+ * Publish a message. QoS 1/2 messages are pipelined: this returns once the
+ * message is sent, up to PKG_USING_BC28_MQTT_CODEC_WINDOW wait for their
+ * acks at a time and a full window blocks the caller.
+ *
+ * @param  topic   : topic name
+ * @param  payload : payload
+ * @param  len     : payload length
+ * @param  qos     : 0, 1 or 2
+ * @param  retain  : retain flag
+ *
+ * @return 0 : sent
+ *        <0 : failed, -RT_EBUSY if the window stayed full,
+ *             -RT_EFULL if the packet exceeds the MQTT remaining length
+ */
+int bc28_mqttc_publish(const char *topic, const void *payload, rt_size_t len, int qos, int retain)
+{
+    rt_size_t topic_len = strlen(topic), n = 0;
+    struct mc_inflight *slot = RT_NULL;
+    int result = 0;
+
+    if (!mc.connected)
+    {
+        return -RT_ERROR;
+    }
+    if (qos < 0 || qos > 2 || topic_len > MC_TOPIC_MAX)
+    {
+        return -RT_EINVAL;
+    }
+
+    if (qos == 0)
+    {
+        rt_uint8_t header[MC_PUB_HEADER_LEN + MC_TOPIC_MAX];
+        struct bc28_iovec iov[2];
+
+        n = bc28_mqtt_encode_publish(header, sizeof(header), topic, 0, 0, retain, len);
+        if (n == 0)
+        {
+            return -RT_EFULL;
+        }
+        iov[0].base = header;
+        iov[0].len  = n;
+        iov[1].base = payload;
+        iov[1].len  = len;
+
+        return mc_sendv(iov, 2);
+    }
+
+    if (rt_sem_take(mc.window, rt_tick_from_millisecond(MC_WINDOW_TIMEOUT)) != RT_EOK)
+    {
+        return -RT_EBUSY;
+    }
+
+    rt_mutex_take(mc.lock, RT_WAITING_FOREVER);
+    for (int i = 0; i < MC_WINDOW && slot == RT_NULL; i++)
+    {
+        if (mc.inflight[i].id == 0)
+        {
+            slot = &mc.inflight[i];
+        }
+    }
+
+    /* the broker may need it again, so QoS 1/2 keeps one copy of the packet */
+    slot->pkt = rt_malloc(MC_PUB_HEADER_LEN + topic_len + len);
+    if (slot->pkt == RT_NULL)
+    {
+        rt_mutex_release(mc.lock);
+        rt_sem_release(mc.window);
+        return -RT_ENOMEM;
+    }
+
+    slot->id    = mc_next_id();
+    slot->state = (qos == 1) ? MC_WAIT_PUBACK : MC_WAIT_PUBREC;
+    slot->sent  = rt_tick_get();
+    n = bc28_mqtt_encode_publish(slot->pkt, MC_PUB_HEADER_LEN + topic_len, topic, slot->id, qos, retain, len);
+    if (n == 0)
+    {
+        rt_free(slot->pkt);
+        slot->pkt = RT_NULL;
+        slot->id  = 0;
+        rt_mutex_release(mc.lock);
+        rt_sem_release(mc.window);
+        return -RT_EFULL;
+    }
+    rt_memcpy(slot->pkt + n, payload, len);
+    slot->len = n + len;
+
+    result = mc_send(slot->pkt, slot->len);
+    rt_mutex_release(mc.lock);
+
+    return result;
+}
+
+/**
+ * Wait until every QoS 1/2 message in flight has been acknowledged.
+ *
+ * @param  timeout : waiting time in ms
+ *
+ * @return 0 : window empty
+ *        <0 : timeout
+ */
+int bc28_mqttc_flush(rt_int32_t timeout)
+{
+    rt_tick_t deadline = rt_tick_get() + rt_tick_from_millisecond(timeout);
+    int taken = 0, result = RT_EOK;
+
+    for (; taken < MC_WINDOW; taken++)
+    {
+        rt_int32_t left = (rt_int32_t)(deadline - rt_tick_get());
+        if (rt_sem_take(mc.window, left > 0 ? left : 0) != RT_EOK)
+        {
+            result = -RT_ETIMEOUT;
+            break;
+        }
+    }
+
+    while (taken--)
+    {
+        rt_sem_release(mc.window);
+    }
+
+    return result;
+}
+
+static int mc_subscribe(rt_uint8_t type, const char *topic, int qos)
+{
+    rt_size_t size = 8 + strlen(topic), len = 0;
+    rt_uint16_t id = mc_next_id();
+    rt_uint8_t *buf = RT_NULL;
+    int result = 0;
+
+    if (!mc.connected)
+    {
+        return -RT_ERROR;
+    }
+
+    buf = rt_malloc(size);
+    if (buf == RT_NULL)
+    {
+        return -RT_ENOMEM;
+    }
+
+    len = bc28_mqtt_encode_subscribe(buf, size, type, id, topic, qos);
+    result = mc_request(buf, len, type == BC28_MQTT_SUBSCRIBE ? BC28_MQTT_SUBACK : BC28_MQTT_UNSUBACK, id);
+    rt_free(buf);
+
+    /* 0x80 in SUBACK: subscription refused */
+    if (result == RT_EOK && type == BC28_MQTT_SUBSCRIBE && mc.reply_rc == 0x80)
+    {
+        result = -RT_ERROR;
+    }
+
+    return result;
+}
+
+static int mc_ops_subscribe(const char *topic)
+{
+    return mc_subscribe(BC28_MQTT_SUBSCRIBE, topic, MC_DEFAULT_QOS);
+}
+
+static int mc_ops_unsubscribe(const char *topic)
+{
+    return mc_subscribe(BC28_MQTT_UNSUBSCRIBE, topic, 0);
+}
+
+static int mc_ops_publish(const char *topic, const char *msg)
+{
+    return bc28_mqttc_publish(topic, msg, strlen(msg), MC_DEFAULT_QOS, 0);
+}
+
+static rt_bool_t mc_ops_resumed(void)
+{
+    return mc.resumed;
+}
+
+const struct bc28_transport_ops bc28_mqttc_ops = {
+    .connect     = bc28_mqttc_connect,
+    .close       = bc28_mqttc_close,
+    .subscribe   = mc_ops_subscribe,
+    .unsubscribe = mc_ops_unsubscribe,
+    .publish     = mc_ops_publish,
+    .resumed     = mc_ops_resumed,
+    .payload_max = MC_PAYLOAD_MAX,
+};
+
+#endif /* PKG_USING_BC28_MQTT_CODEC */
@@ -0,0 +1,973 @@
+/*
+ * Copyright (c) 2023, RudyLo <luhuadong@163.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     agent        the first version
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <rtthread.h>
+#include <at.h>
+
+#define DBG_TAG                       "pkg.bc28_mqttsn"
+#ifdef PKG_USING_BC28_MQTT_DEBUG
+#define DBG_LVL                       DBG_LOG
+#else
+#define DBG_LVL                       DBG_ERROR
+#endif
+#include <rtdbg.h>
+
+#include "bc28_mqtt_internal.h"
+
+#ifdef PKG_USING_BC28_MQTT_SN
+
+#ifndef PKG_USING_BC28_MQTT_SN_GATEWAY_ADDR
+#error "MQTT-SN needs the gateway address, set PKG_USING_BC28_MQTT_SN_GATEWAY_ADDR"
+#endif
+#ifndef PKG_USING_BC28_MQTT_SN_GATEWAY_PORT
+#define PKG_USING_BC28_MQTT_SN_GATEWAY_PORT      1884
+#endif
+#ifndef PKG_USING_BC28_MQTT_SN_QOS
+#define PKG_USING_BC28_MQTT_SN_QOS               0
+#endif
+#ifndef PKG_USING_BC28_MQTT_SN_TOPIC_MAX
+#define PKG_USING_BC28_MQTT_SN_TOPIC_MAX         8
+#endif
+
+#define SN_GATEWAY_ADDR               PKG_USING_BC28_MQTT_SN_GATEWAY_ADDR
+#define SN_GATEWAY_PORT               PKG_USING_BC28_MQTT_SN_GATEWAY_PORT
+#define SN_DEFAULT_QOS                PKG_USING_BC28_MQTT_SN_QOS
+#define SN_TOPIC_MAX                  PKG_USING_BC28_MQTT_SN_TOPIC_MAX
+#define SN_KEEP_ALIVE                 PKG_USING_BC28_MQTT_KEEP_ALIVE
+
+#define SN_PACKET_LEN                 BC28_SOCKET_PAYLOAD_MAX         /* one module datagram */
+#define SN_PUBLISH_MAX                (BC28_SOCKET_PAYLOAD_MAX - 9)   /* 3 byte length, PUBLISH header */
+#define SN_REPLY_LEN                  8
+#define SN_RX_QUEUE_LEN               4
+#define SN_RETRY_TIMES                3
+#define SN_RETRY_TIMEOUT              10000
+#define SN_PING_LOST_MAX              3
+#define SN_THREAD_STACK               2048
+#define SN_THREAD_PRIORITY            (RT_THREAD_PRIORITY_MAX / 2)
+
+/* message types */
+#define SN_CONNECT                    0x04
+#define SN_CONNACK                    0x05
+#define SN_REGISTER                   0x0A
+#define SN_REGACK                     0x0B
+#define SN_PUBLISH                    0x0C
+#define SN_PUBACK                     0x0D
+#define SN_SUBSCRIBE                  0x12
+#define SN_SUBACK                     0x13
+#define SN_UNSUBSCRIBE                0x14
+#define SN_UNSUBACK                   0x15
+#define SN_PINGREQ                    0x16
+#define SN_PINGRESP                   0x17
+#define SN_DISCONNECT                 0x18
+
+/* flags */
+#define SN_FLAG_QOS_0                 0x00
+#define SN_FLAG_QOS_1                 0x20
+#define SN_FLAG_QOS_N1                0x60
+#define SN_FLAG_QOS_MASK              0x60
+#define SN_FLAG_CLEAN_SESSION         0x04
+#define SN_FLAG_TOPIC_MASK            0x03
+
+#define SN_PROTOCOL_ID                0x01
+#define SN_RC_ACCEPTED                0x00
+
+enum sn_state
+{
+    SN_STATE_DISCONNECTED = 0,
+    SN_STATE_ACTIVE,
+    SN_STATE_ASLEEP,
+    SN_STATE_AWAKE
+};
+
+struct sn_topic
+{
+    const char *name;
+    rt_uint16_t id;
+    rt_uint8_t  type;       /* BC28_MQTTSN_TOPIC_xxx */
+};
+
+struct sn_packet
+{
+    rt_uint16_t len;
+    rt_uint8_t  data[SN_PACKET_LEN + 1];
+};
+
+struct bc28_mqttsn
+{
+    int          socket;
+    int          state;
+    rt_uint16_t  msg_id;
+    rt_uint8_t   ping_lost;
+    rt_tick_t    last_tx;
+
+    rt_mutex_t   lock;      /* one request waiting for its reply at a time */
+    rt_sem_t     ack;
+    rt_mq_t      rx;
+    rt_thread_t  tid;
+
+    rt_uint8_t   wait_type;
+    rt_uint16_t  wait_id;
+    rt_uint8_t  *reply;
+
+    struct sn_topic topics[SN_TOPIC_MAX];
+};
+
+static struct bc28_mqttsn sn = {
+    .socket = -1
+};
+
+static rt_uint16_t get_u16(const rt_uint8_t *p)
+{
+    return (rt_uint16_t)(p[0] << 8 | p[1]);
+}
+
+static rt_uint8_t *put_u16(rt_uint8_t *p, rt_uint16_t v)
+{
+    p[0] = v >> 8;
+    p[1] = v & 0xFF;
+    return p + 2;
+}
+
+/**
+ * Prepend the length field, the body has been built at pkt + 3.
+ *
+ * @return packet start, *len is updated to the whole packet length
+ */
+static rt_uint8_t *sn_finish(rt_uint8_t *pkt, rt_size_t *len)
+{
+    if (*len + 1 <= 0xFF)
+    {
+        pkt += 2;
+        pkt[0] = *len + 1;
+        *len += 1;
+    }
+    else
+    {
+        pkt[0] = 0x01;
+        put_u16(pkt + 1, *len + 3);
+        *len += 3;
+    }
+
+    return pkt;
+}
+
+static rt_uint16_t sn_next_id(void)
+{
+    if (++sn.msg_id == 0)
+    {
+        sn.msg_id = 1;
+    }
+
+    return sn.msg_id;
+}
+
+static int sn_send(const rt_uint8_t *pkt, rt_size_t len)
+{
+    sn.last_tx = rt_tick_get();
+    return bc28_socket_sendto(sn.socket, SN_GATEWAY_ADDR, SN_GATEWAY_PORT, pkt, len);
+}
+
+static rt_int32_t sn_retry_timeout(void)
+{
+#ifdef PKG_USING_BC28_MQTT_LINK_MONITOR
+    struct bc28_link_info info;
+
+    /* give a datagram round trip twice the publish timeout of the coverage class */
+    bc28_link_get(&info);
+    return rt_tick_from_millisecond(info.timeout * 2);
+#else
+    return rt_tick_from_millisecond(SN_RETRY_TIMEOUT);
+#endif
+}
+
+/**
+ * Send a request and wait for its reply, retransmitting on timeout.
+ *
+ * @param pkt    request packet
+ * @param len    request length
+ * @param type   expected reply type
+ * @param id     expected message id, 0 if the reply carries none
+ * @param reply  first SN_REPLY_LEN bytes of the reply body, after the length field
+ *
+ * @return  RT_EOK       reply received
+ *         -RT_ETIMEOUT  no reply after SN_RETRY_TIMES
+ */
+static int sn_request(const rt_uint8_t *pkt, rt_size_t len, rt_uint8_t type, rt_uint16_t id, rt_uint8_t *reply)
+{
+    int result = -RT_ETIMEOUT;
+
+    rt_mutex_take(sn.lock, RT_WAITING_FOREVER);
+
+    rt_sem_control(sn.ack, RT_IPC_CMD_RESET, RT_NULL);
+    sn.wait_type = type;
+    sn.wait_id   = id;
+    sn.reply     = reply;
+
+    for (int i = 0; i < SN_RETRY_TIMES; i++)
+    {
+        if (sn_send(pkt, len) != RT_EOK)
+        {
+            result = -RT_ERROR;
+            break;
+        }
+
+        if (rt_sem_take(sn.ack, sn_retry_timeout()) == RT_EOK)
+        {
+            result = RT_EOK;
+            break;
+        }
+        LOG_D("retransmit message type 0x%02x", pkt[pkt[0] == 0x01 ? 3 : 1]);
+    }
+
+    sn.wait_type = 0;
+    sn.reply     = RT_NULL;
+
+    rt_mutex_release(sn.lock);
+    return result;
+}
+
+static struct sn_topic *sn_topic_by_name(const char *name)
+{
+    for (int i = 0; i < SN_TOPIC_MAX; i++)
+    {
+        if (sn.topics[i].name && rt_strcmp(sn.topics[i].name, name) == 0)
+        {
+            return &sn.topics[i];
+        }
+    }
+
+    return RT_NULL;
+}
+
+static struct sn_topic *sn_topic_by_id(rt_uint16_t id, rt_uint8_t type)
+{
+    for (int i = 0; i < SN_TOPIC_MAX; i++)
+    {
+        if (sn.topics[i].name && sn.topics[i].id == id && sn.topics[i].type == type)
+        {
+            return &sn.topics[i];
+        }
+    }
+
+    return RT_NULL;
+}
+
+static int sn_topic_add(const char *name, rt_uint16_t id, rt_uint8_t type)
+{
+    struct sn_topic *topic = sn_topic_by_name(name);
+
+    for (int i = 0; topic == RT_NULL && i < SN_TOPIC_MAX; i++)
+    {
+        if (sn.topics[i].name == RT_NULL)
+        {
+            topic = &sn.topics[i];
+        }
+    }
+    if (topic == RT_NULL)
+    {
+        LOG_E("topic table full, increase PKG_USING_BC28_MQTT_SN_TOPIC_MAX.");
+        return -RT_EFULL;
+    }
+
+    /* a predefined id always wins over a registered one */
+    if (topic->name && topic->type == BC28_MQTTSN_TOPIC_PREDEFINED && type != BC28_MQTTSN_TOPIC_PREDEFINED)
+    {
+        return RT_EOK;
+    }
+    if (topic->name && topic->type != BC28_MQTTSN_TOPIC_PREDEFINED && type == BC28_MQTTSN_TOPIC_PREDEFINED)
+    {
+        rt_free((void *)topic->name);
+        topic->name = RT_NULL;
+    }
+
+    /* predefined names belong to the caller, registered ones are ours */
+    if (topic->name == RT_NULL)
+    {
+        topic->name = (type == BC28_MQTTSN_TOPIC_PREDEFINED) ? name : rt_strdup(name);
+        if (topic->name == RT_NULL)
+        {
+            return -RT_ENOMEM;
+        }
+    }
+    topic->id   = id;
+    topic->type = type;
+
+    return RT_EOK;
+}
+
+/* registrations do not survive a new session */
+static void sn_topic_reset(void)
+{
+    for (int i = 0; i < SN_TOPIC_MAX; i++)
+    {
+        if (sn.topics[i].name && sn.topics[i].type == BC28_MQTTSN_TOPIC_NORMAL)
+        {
+            rt_free((void *)sn.topics[i].name);
+            sn.topics[i].name = RT_NULL;
+        }
+    }
+}
+
+/* the session broke under us, let the recovery worker rebuild it */
+static void sn_lost(const char *reason)
+{
+    if (sn.state == SN_STATE_DISCONNECTED)
+    {
+        return;
+    }
+
+    LOG_E("connection lost: %s", reason);
+    sn.state = SN_STATE_DISCONNECTED;
+    bc28_recover(BC28_RECOVER_LINK);
+}
+
+static void sn_recv(int socket, const rt_uint8_t *data, rt_size_t len)
+{
+    /* only the AT parser thread gets here, keep the datagram off its stack */
+    static struct sn_packet pkt;
+
+    if (data == RT_NULL)
+    {
+        sn_lost("socket closed by module");
+        return;
+    }
+
+    if (len < 2 || len > SN_PACKET_LEN)
+    {
+        LOG_W("drop datagram of %d bytes", len);
+        return;
+    }
+
+    pkt.len = len;
+    rt_memcpy(pkt.data, data, len);
+
+    /* the AT parser thread must not block, drop if the worker lags behind */
+    if (rt_mq_send(sn.rx, &pkt, sizeof(pkt)) != RT_EOK)
+    {
+        LOG_W("rx queue full, drop %d bytes", len);
+    }
+}
+
+static void sn_handle_publish(rt_uint8_t *body, rt_size_t len)
+{
+    rt_uint8_t  flags = 0, type = 0;
+    rt_uint16_t id = 0, msg_id = 0;
+    struct sn_topic *topic = RT_NULL;
+    char short_name[3] = {0};
+    const char *name = short_name;
+    rt_uint8_t  ack[7];
+
+    /* type, flags, topic id and message id */
+    if (len < 6)
+    {
+        return;
+    }
+    flags  = body[1];
+    type   = flags & SN_FLAG_TOPIC_MASK;
+    id     = get_u16(body + 2);
+    msg_id = get_u16(body + 4);
+
+    if (type == BC28_MQTTSN_TOPIC_SHORT)
+    {
+        short_name[0] = body[2];
+        short_name[1] = body[3];
+    }
+    else if ((topic = sn_topic_by_id(id, type)) != RT_NULL)
+    {
+        name = topic->name;
+    }
+
+    /* payload is NUL terminated in place, struct sn_packet has room for it */
+    body[len] = '\0';
+    bc28_recv_dispatch(name, strlen(name), (const char *)body + 6, len - 6);
+
+    if ((flags & SN_FLAG_QOS_MASK) == SN_FLAG_QOS_1)
+    {
+        ack[0] = sizeof(ack);
+        ack[1] = SN_PUBACK;
+        put_u16(ack + 2, id);
+        put_u16(ack + 4, msg_id);
+        ack[6] = SN_RC_ACCEPTED;
+        sn_send(ack, sizeof(ack));
+    }
+}
+
+static void sn_handle_register(rt_uint8_t *body, rt_size_t len)
+{
+    rt_uint8_t ack[7];
+
+    if (len < 6)
+    {
+        return;
+    }
+
+    /* the gateway names a topic before publishing a wildcard match on it */
+    body[len] = '\0';
+    sn_topic_add((const char *)body + 5, get_u16(body + 1), BC28_MQTTSN_TOPIC_NORMAL);
+
+    ack[0] = sizeof(ack);
+    ack[1] = SN_REGACK;
+    rt_memcpy(ack + 2, body + 1, 4);
+    ack[6] = SN_RC_ACCEPTED;
+    sn_send(ack, sizeof(ack));
+}
+
+static void sn_handle(struct sn_packet *pkt)
+{
+    rt_uint8_t *body = pkt->data;
+    rt_size_t   len = pkt->len;
+    rt_uint8_t  type = 0;
+    rt_uint16_t id = 0;
+
+    /* skip the length field, it must cover the whole datagram */
+    if (body[0] == 0x01)
+    {
+        if (len < 3 || get_u16(body + 1) != len)
+        {
+            LOG_W("drop datagram of %d bytes, bad length field", len);
+            return;
+        }
+        body += 3;
+        len  -= 3;
+    }
+    else
+    {
+        if (body[0] != len)
+        {
+            LOG_W("drop datagram of %d bytes, bad length field", len);
+            return;
+        }
+        body += 1;
+        len  -= 1;
+    }
+    if (len < 1)
+    {
+        return;
+    }
+    type = body[0];
+
+    switch (type)
+    {
+    case SN_REGACK:
+    case SN_PUBACK:
+        id = len >= 5 ? get_u16(body + 3) : 0;
+        break;
+    case SN_SUBACK:
+        id = len >= 6 ? get_u16(body + 4) : 0;
+        break;
+    case SN_UNSUBACK:
+        id = len >= 3 ? get_u16(body + 1) : 0;
+        break;
+    case SN_PINGRESP:
+        sn.ping_lost = 0;
+        break;
+    default:
+        break;
+    }
+
+    if (sn.wait_type == type && (sn.wait_id == 0 || sn.wait_id == id))
+    {
+        if (sn.reply)
+        {
+            rt_memcpy(sn.reply, body, len < SN_REPLY_LEN ? len : SN_REPLY_LEN);
+        }
+        sn.wait_type = 0;
+        rt_sem_release(sn.ack);
+        return;
+    }
+
+    switch (type)
+    {
+    case SN_PUBLISH:
+        sn_handle_publish(body, len);
+        break;
+    case SN_REGISTER:
+        sn_handle_register(body, len);
+        break;
+    case SN_PINGREQ:
+    {
+        rt_uint8_t resp[2] = { 2, SN_PINGRESP };
+        sn_send(resp, sizeof(resp));
+        break;
+    }
+    case SN_DISCONNECT:
+        sn_lost("disconnected by gateway");
+        break;
+    default:
+        break;
+    }
+}
+
+static void sn_thread_entry(void *parameter)
+{
+    static struct sn_packet pkt;
+    rt_uint8_t ping[2] = { 2, SN_PINGREQ };
+    rt_int32_t keepalive = rt_tick_from_millisecond(SN_KEEP_ALIVE * 1000);
+    rt_int32_t timeout = 0;
+
+    while (1)
+    {
+        timeout = (sn.state == SN_STATE_ACTIVE) ? keepalive : RT_WAITING_FOREVER;
+
+        if (rt_mq_recv(sn.rx, &pkt, sizeof(pkt), timeout) >= 0)
+        {
+            sn_handle(&pkt);
+            continue;
+        }
+
+        if (sn.state != SN_STATE_ACTIVE || (rt_int32_t)(rt_tick_get() - sn.last_tx) < keepalive)
+        {
+            continue;
+        }
+
+        if (++sn.ping_lost > SN_PING_LOST_MAX)
+        {
+            sn_lost("no PINGRESP");
+            continue;
+        }
+        sn_send(ping, sizeof(ping));
+    }
+}
+
+static int sn_open(void)
+{
+    if (sn.lock == RT_NULL)
+    {
+        sn.lock = rt_mutex_create("bc28sn", RT_IPC_FLAG_PRIO);
+        sn.ack  = rt_sem_create("bc28sn", 0, RT_IPC_FLAG_FIFO);
+        sn.rx   = rt_mq_create("bc28sn", sizeof(struct sn_packet), SN_RX_QUEUE_LEN, RT_IPC_FLAG_FIFO);
+        if (sn.lock == RT_NULL || sn.ack == RT_NULL || sn.rx == RT_NULL)
+        {
+            LOG_E("No memory for MQTT-SN client!");
+            return -RT_ENOMEM;
+        }
+    }
+
+    if (sn.tid == RT_NULL)
+    {
+        sn.tid = rt_thread_create("bc28sn", sn_thread_entry, RT_NULL,
+                                  SN_THREAD_STACK, SN_THREAD_PRIORITY, 10);
+        if (sn.tid == RT_NULL)
+        {
+            LOG_E("create MQTT-SN thread failed.");
+            return -RT_ENOMEM;
+        }
+        rt_thread_startup(sn.tid);
+    }
+
+    if (sn.socket < 0)
+    {
+        sn.socket = bc28_socket_create(BC28_SOCKET_UDP, 0, sn_recv);
+        if (sn.socket < 0)
+        {
+            return -RT_ERROR;
+        }
+    }
+
+    return RT_EOK;
+}
+
+/**
+ * Bind a topic name to a topic id predefined on the gateway.
+ *
+ * @param  topic : topic name, must stay valid while the client runs
+ * @param  id    : predefined topic id
+ *
+ * @return 0 : success
+ *        <0 : topic table full
+ */
+int bc28_mqttsn_predefine(const char *topic, rt_uint16_t id)
+{
+    return sn_topic_add(topic, id, BC28_MQTTSN_TOPIC_PREDEFINED);
+}
+
+/**
+ * Connect to the MQTT-SN gateway with a clean session.
+ *
+ * @return 0 : connect success
+ *        <0 : connect failed
+ */
+int bc28_mqttsn_connect(void)
+{
+    bc28_device_t device = bc28_get_device();
+    rt_uint8_t buf[3 + 6 + sizeof(device->imei)];
+    rt_uint8_t reply[SN_REPLY_LEN] = {0};
+    rt_uint8_t *p = buf + 3, *pkt = RT_NULL;
+    rt_size_t len = 0;
+    int result = 0;
+
+    if ((result = sn_open()) != RT_EOK)
+    {
+        return result;
+    }
+
+    sn_topic_reset();
+
+    *p++ = SN_CONNECT;
+    *p++ = SN_FLAG_CLEAN_SESSION;
+    *p++ = SN_PROTOCOL_ID;
+    p = put_u16(p, SN_KEEP_ALIVE);
+    len = strlen(device->imei);
+    rt_memcpy(p, device->imei, len);
+    p += len;
+
+    len = p - (buf + 3);
+    pkt = sn_finish(buf, &len);
+
+    result = sn_request(pkt, len, SN_CONNACK, 0, reply);
+    if (result != RT_EOK || reply[1] != SN_RC_ACCEPTED)
+    {
+        LOG_E("MQTT-SN connect failed (%d, rc %d).", result, reply[1]);
+        return -RT_ERROR;
+    }
+
+    sn.ping_lost = 0;
+    sn.state = SN_STATE_ACTIVE;
+    device->stat = BC28_STAT_CONNECTED;
+
+    return RT_EOK;
+}
+
+static int sn_disconnect(rt_uint16_t duration)
+{
+    rt_uint8_t pkt[4] = { 2, SN_DISCONNECT };
+    rt_size_t len = 2;
+
+    if (duration)
+    {
+        pkt[0] = len = 4;
+        put_u16(pkt + 2, duration);
+    }
+
+    return sn_request(pkt, len, SN_DISCONNECT, 0, RT_NULL);
+}
+
+/**
+ * Disconnect from the gateway and close the socket.
+ *
+ * @return 0 : success
+ *        <0 : failed
+ */
+int bc28_mqttsn_close(void)
+{
+    if (sn.socket < 0)
+    {
+        return RT_EOK;
+    }
+
+    if (sn.state != SN_STATE_DISCONNECTED)
+    {
+        sn_disconnect(0);
+    }
+
+    sn.state = SN_STATE_DISCONNECTED;
+    bc28_get_device()->stat = BC28_STAT_DISCONNECTED;
+
+    bc28_socket_close(sn.socket);
+    sn.socket = -1;
+
+    return RT_EOK;
+}
+
+/**
+ * Go to sleep, the gateway buffers messages for up to duration seconds.
+ *
+ * @param  duration : sleep duration in seconds
+ *
+ * @return 0 : asleep
+ *        <0 : failed
+ */
+int bc28_mqttsn_sleep(rt_uint16_t duration)
+{
+    if (sn.state != SN_STATE_ACTIVE && sn.state != SN_STATE_ASLEEP)
+    {
+        return -RT_ERROR;
+    }
+
+    if (sn_disconnect(duration) != RT_EOK)
+    {
+        return -RT_ETIMEOUT;
+    }
+
+    sn.state = SN_STATE_ASLEEP;
+    return RT_EOK;
+}
+
+/**
+ * Wake up briefly to collect the messages buffered by the gateway, they
+ * are delivered to the bound parser before this returns.
+ *
+ * @return 0 : buffered messages collected, still asleep
+ *        <0 : failed
+ */
+int bc28_mqttsn_wake(void)
+{
+    bc28_device_t device = bc28_get_device();
+    rt_uint8_t buf[2 + sizeof(device->imei)];
+    rt_size_t len = strlen(device->imei);
+    int result = 0;
+
+    if (sn.state != SN_STATE_ASLEEP)
+    {
+        return -RT_ERROR;
+    }
+
+    buf[0] = len + 2;
+    buf[1] = SN_PINGREQ;
+    rt_memcpy(buf + 2, device->imei, len);
+
+    sn.state = SN_STATE_AWAKE;
+    result = sn_request(buf, len + 2, SN_PINGRESP, 0, RT_NULL);
+    sn.state = SN_STATE_ASLEEP;
+
+    return result;
+}
+
+static int sn_register(const char *topic, rt_uint16_t *id)
+{
+    rt_uint8_t *buf = RT_NULL, *pkt = RT_NULL;
+    rt_uint8_t reply[SN_REPLY_LEN] = {0};
+    rt_size_t len = strlen(topic);
+    rt_uint16_t msg_id = sn_next_id();
+    int result = 0;
+
+    buf = rt_malloc(3 + 5 + len);
+    if (buf == RT_NULL)
+    {
+        return -RT_ENOMEM;
+    }
+
+    buf[3] = SN_REGISTER;
+    put_u16(buf + 4, 0);
+    put_u16(buf + 6, msg_id);
+    rt_memcpy(buf + 8, topic, len);
+    len += 5;
+    pkt = sn_finish(buf, &len);
+
+    /* REGACK: type, topic id, msg id, rc */
+    result = sn_request(pkt, len, SN_REGACK, msg_id, reply);
+    rt_free(buf);
+
+    if (result != RT_EOK || reply[5] != SN_RC_ACCEPTED)
+    {
+        LOG_E("register topic %s failed.", topic);
+        return -RT_ERROR;
+    }
+
+    *id = get_u16(reply + 1);
+    return sn_topic_add(topic, *id, BC28_MQTTSN_TOPIC_NORMAL);
+}
+
+/**
+ * Resolve a topic name to the id and id type used on the wire.
+ *
+ * @return 0 : resolved
+ *        <0 : unknown and could not be registered
+ */
+static int sn_resolve(const char *topic, int qos, rt_uint16_t *id, rt_uint8_t *type)
+{
+    struct sn_topic *t = sn_topic_by_name(topic);
+
+    if (t)
+    {
+        *id   = t->id;
+        *type = t->type;
+        return RT_EOK;
+    }
+
+    if (strlen(topic) == 2)
+    {
+        *id   = get_u16((const rt_uint8_t *)topic);
+        *type = BC28_MQTTSN_TOPIC_SHORT;
+        return RT_EOK;
+    }
+
+    /* QoS -1 has no session to register in */
+    if (qos < 0 || sn.state != SN_STATE_ACTIVE)
+    {
+        return -RT_EINVAL;
+    }
+
+    *type = BC28_MQTTSN_TOPIC_NORMAL;
+    return sn_register(topic, id);
+}
+
+/**
+ * Publish a message over MQTT-SN.
+ *
+ * @param  topic : topic name, predefined, short (2 chars) or registered on demand
+ * @param  data  : payload
+ * @param  len   : payload length
+ * @param  qos   : -1, 0 or 1, QoS -1 needs no connection but a predefined or short topic
+ *
+ * @return 0 : publish success
+ *        <0 : publish failed, -RT_EFULL if it does not fit one module datagram
+ */
+int bc28_mqttsn_publish(const char *topic, const void *data, rt_size_t len, int qos)
+{
+    rt_uint8_t *buf = RT_NULL, *pkt = RT_NULL;
+    rt_uint8_t reply[SN_REPLY_LEN] = {0};
+    rt_uint16_t id = 0, msg_id = 0;
+    rt_uint8_t type = 0;
+    int result = 0;
+
+    if (qos < -1 || qos > 1)
+    {
+        return -RT_EINVAL;
+    }
+    if (len > SN_PUBLISH_MAX)
+    {
+        LOG_E("message of %d bytes exceeds %d.", len, SN_PUBLISH_MAX);
+        return -RT_EFULL;
+    }
+
+    if (qos < 0 && (result = sn_open()) != RT_EOK)
+    {
+        return result;
+    }
+
+    if (qos >= 0 && sn.state != SN_STATE_ACTIVE)
+    {
+        return -RT_ERROR;
+    }
+
+    if (sn_resolve(topic, qos, &id, &type) != RT_EOK)
+    {
+        LOG_E("can not resolve topic %s.", topic);
+        return -RT_EINVAL;
+    }
+
+    buf = rt_malloc(3 + 6 + len);
+    if (buf == RT_NULL)
+    {
+        return -RT_ENOMEM;
+    }
+
+    msg_id = (qos == 1) ? sn_next_id() : 0;
+
+    buf[3] = SN_PUBLISH;
+    buf[4] = type | (qos < 0 ? SN_FLAG_QOS_N1 : (qos == 1 ? SN_FLAG_QOS_1 : SN_FLAG_QOS_0));
+    put_u16(buf + 5, id);
+    put_u16(buf + 7, msg_id);
+    rt_memcpy(buf + 9, data, len);
+    len += 6;
+    pkt = sn_finish(buf, &len);
+
+    if (qos == 1)
+    {
+        /* PUBACK: type, topic id, msg id, rc */
+        result = sn_request(pkt, len, SN_PUBACK, msg_id, reply);
+        if (result == RT_EOK && reply[5] != SN_RC_ACCEPTED)
+        {
+            result = -RT_ERROR;
+        }
+    }
+    else
+    {
+        result = sn_send(pkt, len);
+    }
+
+    rt_free(buf);
+    return result;
+}
+
+static int sn_subscribe(rt_uint8_t msg_type, const char *topic)
+{
+    rt_uint8_t *buf = RT_NULL, *pkt = RT_NULL;
+    rt_uint8_t reply[SN_REPLY_LEN] = {0};
+    struct sn_topic *t = sn_topic_by_name(topic);
+    rt_uint8_t type = BC28_MQTTSN_TOPIC_NORMAL;
+    rt_size_t len = strlen(topic);
+    rt_uint16_t msg_id = sn_next_id();
+    int result = 0;
+
+    if (sn.state != SN_STATE_ACTIVE)
+    {
+        return -RT_ERROR;
+    }
+
+    /* room for a topic name or a 2 byte topic id */
+    buf = rt_malloc(3 + 4 + (len > 2 ? len : 2));
+    if (buf == RT_NULL)
+    {
+        return -RT_ENOMEM;
+    }
+
+    buf[3] = msg_type;
+    put_u16(buf + 5, msg_id);
+
+    if (t && t->type == BC28_MQTTSN_TOPIC_PREDEFINED)
+    {
+        type = t->type;
+        put_u16(buf + 7, t->id);
+        len = 2;
+    }
+    else
+    {
+        type = (len == 2) ? BC28_MQTTSN_TOPIC_SHORT : BC28_MQTTSN_TOPIC_NORMAL;
+        rt_memcpy(buf + 7, topic, len);
+    }
+    buf[4] = SN_FLAG_QOS_1 | type;
+    len += 4;
+    pkt = sn_finish(buf, &len);
+
+    if (msg_type == SN_SUBSCRIBE)
+    {
+        /* SUBACK: type, flags, topic id, msg id, rc */
+        result = sn_request(pkt, len, SN_SUBACK, msg_id, reply);
+        if (result == RT_EOK && reply[6] != SN_RC_ACCEPTED)
+        {
+            result = -RT_ERROR;
+        }
+
+        /* remember the id for incoming publishes, wildcards get theirs by REGISTER */
+        if (result == RT_EOK && type == BC28_MQTTSN_TOPIC_NORMAL && get_u16(reply + 2) != 0)
+        {
+            sn_topic_add(topic, get_u16(reply + 2), BC28_MQTTSN_TOPIC_NORMAL);
+        }
+    }
+    else
+    {
+        result = sn_request(pkt, len, SN_UNSUBACK, msg_id, RT_NULL);
+    }
+
+    rt_free(buf);
+    return result;
+}
+
+static int sn_ops_subscribe(const char *topic)
+{
+    return sn_subscribe(SN_SUBSCRIBE, topic);
+}
+
+static int sn_ops_unsubscribe(const char *topic)
+{
+    return sn_subscribe(SN_UNSUBSCRIBE, topic);
+}
+
+static int sn_ops_publish(const char *topic, const char *msg)
+{
+    return bc28_mqttsn_publish(topic, msg, strlen(msg), SN_DEFAULT_QOS);
+}
+
+const struct bc28_transport_ops bc28_mqttsn_ops = {
+    .connect     = bc28_mqttsn_connect,
+    .close       = bc28_mqttsn_close,
+    .subscribe   = sn_ops_subscribe,
+    .unsubscribe = sn_ops_unsubscribe,
+    .publish     = sn_ops_publish,
+    .payload_max = SN_PUBLISH_MAX,
+};
+
+#endif /* PKG_USING_BC28_MQTT_SN */
@@ -0,0 +1,896 @@
+/*
+ * Copyright (c) 2023, RudyLo <luhuadong@163.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     agent        the first version
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <rtthread.h>
+
+#define DBG_TAG                       "pkg.bc28_ota"
+#ifdef PKG_USING_BC28_MQTT_DEBUG
+#define DBG_LVL                       DBG_LOG
+#else
+#define DBG_LVL                       DBG_ERROR
+#endif
+#include <rtdbg.h>
+
+#include "bc28_mqtt_internal.h"
+
+#ifdef PKG_USING_BC28_MQTT_OTA
+
+#include <fal.h>
+#include <tinycrypt.h>
+
+/*
+ * Alink OTA with the package downloaded over MQTT. After an upgrade notice
+ * the image is pulled in blocks from thing/file/download, keeping up to
+ * PKG_USING_BC28_MQTT_OTA_WINDOW requests in flight. A reply carries
+ *
+ *   | JSON length (2, MSB first) | JSON header | block | CRC16/IBM (2, MSB first) |
+ *
+ * and the block is programmed into the partition straight from the receive
+ * buffer, there is no copy of the image in RAM. Blocks may come back out of
+ * order; the digest follows the contiguous written prefix and is computed
+ * by reading the partition back, so what gets verified is what was flashed.
+ *
+ * Download state lives in RAM: when the link drops the outstanding requests
+ * time out and are sent again, the download goes on from where it was.
+ */
+
+#ifndef PKG_USING_BC28_MQTT_OTA_PARTITION
+#define PKG_USING_BC28_MQTT_OTA_PARTITION        "download"
+#endif
+#ifndef PKG_USING_BC28_MQTT_OTA_BLOCK
+#define PKG_USING_BC28_MQTT_OTA_BLOCK            512
+#endif
+#ifndef PKG_USING_BC28_MQTT_OTA_WINDOW
+#define PKG_USING_BC28_MQTT_OTA_WINDOW           4
+#endif
+#ifndef PKG_USING_BC28_MQTT_OTA_TIMEOUT
+#define PKG_USING_BC28_MQTT_OTA_TIMEOUT          10000
+#endif
+#ifndef PKG_USING_BC28_MQTT_OTA_ABORT
+#define PKG_USING_BC28_MQTT_OTA_ABORT            600000
+#endif
+
+#define OTA_PARTITION                 PKG_USING_BC28_MQTT_OTA_PARTITION
+#define OTA_BLOCK                     PKG_USING_BC28_MQTT_OTA_BLOCK
+#define OTA_WINDOW                    PKG_USING_BC28_MQTT_OTA_WINDOW
+#define OTA_TIMEOUT                   PKG_USING_BC28_MQTT_OTA_TIMEOUT
+#define OTA_ABORT                     PKG_USING_BC28_MQTT_OTA_ABORT
+#define OTA_POLL                      1000
+#define OTA_REPORT_STEP               10
+#define OTA_READ_LEN                  128
+#define OTA_HEADER_MAX                192
+#define OTA_REPLY_OVERHEAD            (2 + OTA_HEADER_MAX + 2)      /* JSON length, header and CRC */
+#define OTA_URC_OVERHEAD              40         /* "+NSONMI:<socket>,<addr>,<port>,<len>," and CRLF */
+#define OTA_MSG_LEN                   256
+#define OTA_THREAD_STACK              2048
+#define OTA_THREAD_PRIORITY           (RT_THREAD_PRIORITY_MAX - 4)
+
+#define OTA_PREFIX                    PKG_USING_BC28_MQTT_PRODUCT_KEY "/" PKG_USING_BC28_MQTT_DEVICE_NAME
+#define OTA_TOPIC_UPGRADE             "/ota/device/upgrade/" OTA_PREFIX
+#define OTA_TOPIC_INFORM              "/ota/device/inform/" OTA_PREFIX
+#define OTA_TOPIC_PROGRESS            "/ota/device/progress/" OTA_PREFIX
+#define OTA_TOPIC_REQUEST             "/sys/" OTA_PREFIX "/thing/file/download"
+#define OTA_TOPIC_REPLY               "/sys/" OTA_PREFIX "/thing/file/download_reply"
+
+/* Alink progress steps */
+#define OTA_STEP_DOWNLOAD_FAILED      -2
+#define OTA_STEP_VERIFY_FAILED        -3
+#define OTA_STEP_FLASH_FAILED         -4
+
+enum ota_state
+{
+    OTA_IDLE = 0,                   /* waiting for an upgrade notice */
+    OTA_NOTICE,                     /* notice received, download not started */
+    OTA_DOWNLOAD,
+    OTA_DONE,
+    OTA_FAILED
+};
+
+enum ota_method
+{
+    OTA_MD5 = 0,
+    OTA_SHA256
+};
+
+enum ota_req_state
+{
+    OTA_REQ_FREE = 0,
+    OTA_REQ_UNSENT,                 /* assigned, or to be sent again */
+    OTA_REQ_WAIT,                   /* sent, waiting for the block */
+    OTA_REQ_DONE                    /* written, not yet part of the prefix */
+};
+
+struct ota_req
+{
+    rt_uint32_t  offset;
+    rt_uint16_t  len;
+    rt_uint8_t   state;
+    rt_tick_t    sent;
+};
+
+static struct
+{
+    rt_thread_t  tid;
+    rt_sem_t     wake;
+    rt_mutex_t   lock;
+    const struct fal_partition *part;
+    void       (*callback)(int result, const char *version);
+
+    rt_uint8_t   state;
+    rt_uint8_t   method;
+    rt_int8_t    step;              /* last reported progress */
+    char         version[24];       /* running firmware */
+    char         target[24];        /* firmware being downloaded */
+    char         sign[65];
+    rt_uint32_t  size;
+    rt_uint32_t  stream_id;
+    rt_uint32_t  file_id;
+
+    rt_uint16_t  block;             /* block size requested, see ota_block_fit() */
+    rt_uint32_t  next;              /* next offset to request */
+    rt_uint32_t  done;              /* contiguous bytes written */
+    rt_uint32_t  hashed;
+    union
+    {
+#ifdef TINY_CRYPT_MD5
+        tiny_md5_context  md5;
+#endif
+#ifdef TINY_CRYPT_SHA256
+        tiny_sha2_context sha256;
+#endif
+        rt_uint8_t        none;
+    } hash;
+    struct ota_req req[OTA_WINDOW];
+
+    rt_uint32_t  id;
+    rt_tick_t    start;
+    rt_tick_t    progress;          /* tick of the last block written */
+    rt_uint32_t  received;          /* block bytes received, duplicates included */
+    rt_uint32_t  resends;
+    rt_uint32_t  stalls;
+    rt_uint32_t  errors;            /* CRC, header or code errors */
+} ota;
+
+static rt_uint16_t ota_crc16(const rt_uint8_t *data, rt_size_t len)
+{
+    rt_uint16_t crc = 0;
+
+    while (len--)
+    {
+        crc ^= *data++;
+        for (int i = 0; i < 8; i++)
+        {
+            crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+        }
+    }
+
+    return crc;
+}
+
+/* flat JSON lookups, enough for the Alink messages handled here */
+static const char *ota_json_find(const char *json, const char *key)
+{
+    char pattern[24];
+    const char *p = RT_NULL;
+
+    rt_snprintf(pattern, sizeof(pattern), "\"%s\"", key);
+    if ((p = strstr(json, pattern)) == RT_NULL)
+    {
+        return RT_NULL;
+    }
+    p += strlen(pattern);
+    while (*p == ' ' || *p == ':')
+    {
+        p++;
+    }
+
+    return p;
+}
+
+static int ota_json_int(const char *json, const char *key, rt_uint32_t *value)
+{
+    const char *p = ota_json_find(json, key);
+
+    if (p == RT_NULL)
+    {
+        return -RT_ERROR;
+    }
+    if (*p == '"')
+    {
+        p++;
+    }
+    if (*p < '0' || *p > '9')
+    {
+        return -RT_ERROR;
+    }
+    *value = strtoul(p, RT_NULL, 10);
+
+    return RT_EOK;
+}
+
+static int ota_json_str(const char *json, const char *key, char *value, rt_size_t size)
+{
+    const char *p = ota_json_find(json, key);
+    rt_size_t n = 0;
+
+    if (p == RT_NULL || *p++ != '"')
+    {
+        return -RT_ERROR;
+    }
+    while (p[n] && p[n] != '"' && n < size - 1)
+    {
+        value[n] = p[n];
+        n++;
+    }
+    value[n] = '\0';
+
+    return RT_EOK;
+}
+
+static int ota_report(int step, const char *desc)
+{
+    char msg[OTA_MSG_LEN];
+
+    rt_snprintf(msg, sizeof(msg), "{\"id\":\"%u\",\"params\":{\"step\":\"%d\",\"desc\":\"%s\"}}",
+                ++ota.id, step, desc);
+
+    return bc28_mqtt_publish(OTA_TOPIC_PROGRESS, msg);
+}
+
+static int ota_request(struct ota_req *req)
+{
+    char msg[OTA_MSG_LEN];
+
+    rt_snprintf(msg, sizeof(msg), "{\"id\":\"%u\",\"version\":\"1.0\",\"params\":{\"fileToken\":\"%08x\","
+                "\"fileInfo\":{\"streamId\":%u,\"fileId\":%u},\"fileBlock\":{\"size\":%u,\"offset\":%u}}}",
+                ++ota.id, ota.stream_id, ota.stream_id, ota.file_id, req->len, req->offset);
+
+    return bc28_mqtt_publish(OTA_TOPIC_REQUEST, msg);
+}
+
+static rt_bool_t ota_hash_supported(void)
+{
+#ifdef TINY_CRYPT_MD5
+    if (ota.method == OTA_MD5)
+    {
+        return RT_TRUE;
+    }
+#endif
+#ifdef TINY_CRYPT_SHA256
+    if (ota.method == OTA_SHA256)
+    {
+        return RT_TRUE;
+    }
+#endif
+    return RT_FALSE;
+}
+
+static void ota_hash_start(void)
+{
+#ifdef TINY_CRYPT_MD5
+    if (ota.method == OTA_MD5)
+    {
+        tiny_md5_starts(&ota.hash.md5);
+    }
+#endif
+#ifdef TINY_CRYPT_SHA256
+    if (ota.method == OTA_SHA256)
+    {
+        tiny_sha2_starts(&ota.hash.sha256, 0);
+    }
+#endif
+}
+
+static void ota_hash_update(rt_uint8_t *data, rt_size_t len)
+{
+#ifdef TINY_CRYPT_MD5
+    if (ota.method == OTA_MD5)
+    {
+        tiny_md5_update(&ota.hash.md5, data, len);
+    }
+#endif
+#ifdef TINY_CRYPT_SHA256
+    if (ota.method == OTA_SHA256)
+    {
+        tiny_sha2_update(&ota.hash.sha256, data, len);
+    }
+#endif
+}
+
+static rt_bool_t ota_hash_match(void)
+{
+    rt_uint8_t digest[32];
+    rt_size_t  len = 0;
+    char       hex[3];
+
+#ifdef TINY_CRYPT_MD5
+    if (ota.method == OTA_MD5)
+    {
+        tiny_md5_finish(&ota.hash.md5, digest);
+        len = 16;
+    }
+#endif
+#ifdef TINY_CRYPT_SHA256
+    if (ota.method == OTA_SHA256)
+    {
+        tiny_sha2_finish(&ota.hash.sha256, digest);
+        len = 32;
+    }
+#endif
+
+    if (len == 0 || strlen(ota.sign) != len * 2)
+    {
+        return RT_FALSE;
+    }
+    for (rt_size_t i = 0; i < len; i++)
+    {
+        rt_snprintf(hex, sizeof(hex), "%02x", digest[i]);
+        if (strncasecmp(hex, ota.sign + i * 2, 2) != 0)
+        {
+            return RT_FALSE;
+        }
+    }
+
+    return RT_TRUE;
+}
+
+static void ota_finish(int result)
+{
+    rt_uint32_t ms = (rt_tick_get() - ota.start) * 1000 / RT_TICK_PER_SECOND;
+
+    ota.state = (result == RT_EOK) ? OTA_DONE : OTA_FAILED;
+    if (result == RT_EOK)
+    {
+        LOG_I("OTA %s downloaded, %u bytes in %u ms, %u B/s, %u resends, %u stalls.", ota.target, ota.size,
+              ms, ms ? (rt_uint32_t)((rt_uint64_t)ota.size * 1000 / ms) : 0, ota.resends, ota.stalls);
+    }
+    else
+    {
+        LOG_E("OTA %s failed (%d) at %u/%u bytes.", ota.target, result, ota.done, ota.size);
+    }
+
+    if (ota.callback)
+    {
+        ota.callback(result, ota.target);
+    }
+}
+
+static void ota_begin(void)
+{
+    LOG_D("OTA %s, %u bytes, stream %u.", ota.target, ota.size, ota.stream_id);
+
+    if (ota.size == 0 || ota.size > ota.part->len)
+    {
+        LOG_E("image of %u bytes does not fit partition %s.", ota.size, ota.part->name);
+        ota_report(OTA_STEP_DOWNLOAD_FAILED, "image too large");
+        ota_finish(-RT_EFULL);
+        return;
+    }
+
+    if (!ota_hash_supported())
+    {
+        LOG_E("enable %s in tinycrypt.", ota.method == OTA_MD5 ? "TINY_CRYPT_MD5" : "TINY_CRYPT_SHA256");
+        ota_report(OTA_STEP_VERIFY_FAILED, "sign method not supported");
+        ota_finish(-RT_ENOSYS);
+        return;
+    }
+
+    /* erase up front, only programming is left for the receive path */
+    if (fal_partition_erase(ota.part, 0, ota.size) < 0)
+    {
+        ota_report(OTA_STEP_FLASH_FAILED, "erase failed");
+        ota_finish(-RT_EIO);
+        return;
+    }
+
+    rt_mutex_take(ota.lock, RT_WAITING_FOREVER);
+    rt_memset(ota.req, 0, sizeof(ota.req));
+    ota.next = ota.done = ota.hashed = 0;
+    ota.received = ota.resends = ota.stalls = ota.errors = 0;
+    ota.step  = 0;
+    ota.start = ota.progress = rt_tick_get();
+    ota.state = OTA_DOWNLOAD;
+    rt_mutex_release(ota.lock);
+
+    ota_hash_start();
+    ota_report(0, "download");
+}
+
+/* extend the written prefix and fold it into the digest */
+static int ota_advance(void)
+{
+    rt_uint8_t data[OTA_READ_LEN];
+    rt_bool_t  more = RT_TRUE;
+    rt_size_t  n = 0;
+
+    rt_mutex_take(ota.lock, RT_WAITING_FOREVER);
+    while (more)
+    {
+        more = RT_FALSE;
+        for (int i = 0; i < OTA_WINDOW; i++)
+        {
+            if (ota.req[i].state == OTA_REQ_DONE && ota.req[i].offset == ota.done)
+            {
+                ota.done += ota.req[i].len;
+                ota.req[i].state = OTA_REQ_FREE;
+                more = RT_TRUE;
+            }
+        }
+    }
+    rt_mutex_release(ota.lock);
+
+    while (ota.hashed < ota.done)
+    {
+        n = ota.done - ota.hashed;
+        n = n > sizeof(data) ? sizeof(data) : n;
+        if (fal_partition_read(ota.part, ota.hashed, data, n) < 0)
+        {
+            return -RT_EIO;
+        }
+        ota_hash_update(data, n);
+        ota.hashed += n;
+    }
+
+    return RT_EOK;
+}
+
+/* hand out free slots, resend lost requests */
+static int ota_pump(void)
+{
+    rt_tick_t now = rt_tick_get();
+    rt_tick_t timeout = rt_tick_from_millisecond(OTA_TIMEOUT);
+    rt_bool_t stalled = RT_TRUE;
+    int waiting = 0;
+
+    rt_mutex_take(ota.lock, RT_WAITING_FOREVER);
+    for (int i = 0; i < OTA_WINDOW; i++)
+    {
+        struct ota_req *req = &ota.req[i];
+
+        if (req->state == OTA_REQ_FREE && ota.next < ota.size)
+        {
+            req->offset = ota.next;
+            req->len    = (ota.size - ota.next) > ota.block ? ota.block : ota.size - ota.next;
+            req->sent   = 0;
+            req->state  = OTA_REQ_UNSENT;
+            ota.next   += req->len;
+        }
+        if (req->state == OTA_REQ_WAIT)
+        {
+            waiting++;
+            if (now - req->sent < timeout)
+            {
+                stalled = RT_FALSE;
+            }
+        }
+    }
+
+    /* every request timed out, most likely the link was rebuilt in between */
+    if (waiting && stalled)
+    {
+        ota.stalls++;
+        for (int i = 0; i < OTA_WINDOW; i++)
+        {
+            if (ota.req[i].state == OTA_REQ_WAIT)
+            {
+                ota.req[i].state = OTA_REQ_UNSENT;
+            }
+        }
+    }
+
+    for (int i = 0; i < OTA_WINDOW; i++)
+    {
+        if (ota.req[i].state == OTA_REQ_WAIT && now - ota.req[i].sent >= timeout)
+        {
+            ota.req[i].state = OTA_REQ_UNSENT;
+        }
+    }
+    rt_mutex_release(ota.lock);
+
+    /* a block resent many times over a bad link is still progress, only
+     * a download that stopped moving is given up */
+    if (now - ota.progress > rt_tick_from_millisecond(OTA_ABORT))
+    {
+        return -RT_ETIMEOUT;
+    }
+    if (waiting && stalled)
+    {
+        LOG_D("OTA stalled at %u, subscribe again.", ota.done);
+        bc28_mqtt_subscribe(OTA_TOPIC_REPLY);
+    }
+
+    for (int i = 0; i < OTA_WINDOW; i++)
+    {
+        struct ota_req *req = &ota.req[i];
+
+        if (req->state != OTA_REQ_UNSENT)
+        {
+            continue;
+        }
+        /* link down, try again on the next round */
+        if (ota_request(req) != RT_EOK)
+        {
+            break;
+        }
+        if (req->sent)
+        {
+            ota.resends++;
+        }
+
+        /* the block may already be in when the publish returns */
+        rt_mutex_take(ota.lock, RT_WAITING_FOREVER);
+        if (req->state == OTA_REQ_UNSENT)
+        {
+            req->sent  = rt_tick_get();
+            req->state = OTA_REQ_WAIT;
+        }
+        rt_mutex_release(ota.lock);
+    }
+
+    return RT_EOK;
+}
+
+static void ota_download(void)
+{
+    int result = 0;
+    int step = 0;
+
+    if ((result = ota_advance()) != RT_EOK)
+    {
+        ota_report(OTA_STEP_FLASH_FAILED, "read back failed");
+        ota_finish(result);
+        return;
+    }
+
+    if (ota.done == ota.size)
+    {
+        if (!ota_hash_match())
+        {
+            ota_report(OTA_STEP_VERIFY_FAILED, "digest mismatch");
+            ota_finish(-RT_ERROR);
+            return;
+        }
+        ota_report(100, "verified");
+        ota_finish(RT_EOK);
+        return;
+    }
+
+    step = (rt_uint64_t)ota.done * 100 / ota.size;
+    if (step >= ota.step + OTA_REPORT_STEP)
+    {
+        ota.step = step - step % OTA_REPORT_STEP;
+        ota_report(ota.step, "download");
+    }
+
+    if ((result = ota_pump()) != RT_EOK)
+    {
+        ota_report(OTA_STEP_DOWNLOAD_FAILED, "timeout");
+        ota_finish(result);
+    }
+}
+
+static void ota_thread_entry(void *param)
+{
+    while (1)
+    {
+        rt_sem_take(ota.wake, rt_tick_from_millisecond(OTA_POLL));
+
+        switch (ota.state)
+        {
+        case OTA_NOTICE:
+            ota_begin();
+            /* fall through */
+        case OTA_DOWNLOAD:
+            if (ota.state == OTA_DOWNLOAD)
+            {
+                ota_download();
+            }
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+static void ota_recv_notice(const char *json)
+{
+    char method[12] = {0};
+    char version[sizeof(ota.target)] = {0};
+    char sign[sizeof(ota.sign)] = {0};
+    rt_uint32_t size = 0, stream_id = 0, file_id = 1;
+
+    if (ota_json_int(json, "size", &size) != RT_EOK ||
+        ota_json_int(json, "streamId", &stream_id) != RT_EOK ||
+        ota_json_str(json, "version", version, sizeof(version)) != RT_EOK)
+    {
+        LOG_E("OTA notice without an MQTT stream: %s", json);
+        return;
+    }
+    ota_json_int(json, "streamFileId", &file_id);
+    if (ota_json_str(json, "sign", sign, sizeof(sign)) != RT_EOK)
+    {
+        ota_json_str(json, "md5", sign, sizeof(sign));
+    }
+    ota_json_str(json, "signMethod", method, sizeof(method));
+
+    rt_mutex_take(ota.lock, RT_WAITING_FOREVER);
+    if ((ota.state == OTA_NOTICE || ota.state == OTA_DOWNLOAD) && ota.stream_id == stream_id)
+    {
+        /* pushed again, keep going */
+        rt_mutex_release(ota.lock);
+        return;
+    }
+    ota.state     = OTA_NOTICE;
+    ota.method    = (strncasecmp(method, "SHA256", 6) == 0) ? OTA_SHA256 : OTA_MD5;
+    ota.size      = size;
+    ota.stream_id = stream_id;
+    ota.file_id   = file_id;
+    rt_strncpy(ota.target, version, sizeof(ota.target) - 1);
+    rt_strncpy(ota.sign, sign, sizeof(ota.sign) - 1);
+    rt_mutex_release(ota.lock);
+
+    rt_sem_release(ota.wake);
+}
+
+static void ota_recv_block(const rt_uint8_t *data, rt_size_t len)
+{
+    char header[OTA_HEADER_MAX];
+    rt_uint32_t code = 0, offset = 0, size = 0;
+    rt_size_t hlen = 0;
+    const rt_uint8_t *block = RT_NULL;
+
+    if (len < 4 || (hlen = (data[0] << 8) | data[1]) >= sizeof(header) || hlen + 4 > len)
+    {
+        ota.errors++;
+        return;
+    }
+    rt_memcpy(header, data + 2, hlen);
+    header[hlen] = '\0';
+
+    block = data + 2 + hlen;
+    len  -= hlen + 4;
+    if (ota_json_int(header, "code", &code) != RT_EOK || code != 200 ||
+        ota_json_int(header, "bOffset", &offset) != RT_EOK ||
+        ota_json_int(header, "bSize", &size) != RT_EOK || size != len ||
+        ota_crc16(block, len) != ((block[len] << 8) | block[len + 1]))
+    {
+        LOG_D("bad block: %s", header);
+        ota.errors++;
+        return;
+    }
+
+    rt_mutex_take(ota.lock, RT_WAITING_FOREVER);
+    ota.received += len;
+    for (int i = 0; ota.state == OTA_DOWNLOAD && i < OTA_WINDOW; i++)
+    {
+        struct ota_req *req = &ota.req[i];
+
+        /* a late copy of a block already written is dropped here */
+        if (req->offset == offset && req->len == len &&
+            (req->state == OTA_REQ_WAIT || req->state == OTA_REQ_UNSENT))
+        {
+            if (fal_partition_write(ota.part, offset, block, len) < 0)
+            {
+                LOG_E("write %u bytes at %u failed.", len, offset);
+                req->state = OTA_REQ_UNSENT;
+                break;
+            }
+            req->state   = OTA_REQ_DONE;
+            ota.progress = rt_tick_get();
+            break;
+        }
+    }
+    rt_mutex_release(ota.lock);
+
+    rt_sem_release(ota.wake);
+}
+
+/**
+ * Take OTA messages off the receive path, called from the transport's
+ * receive context.
+ *
+ * @return RT_TRUE : the message was an OTA message
+ */
+rt_bool_t bc28_ota_recv(const char *topic, rt_size_t topic_len, const char *payload, rt_size_t len)
+{
+    if (ota.tid == RT_NULL)
+    {
+        return RT_FALSE;
+    }
+
+    if (topic_len == sizeof(OTA_TOPIC_REPLY) - 1 && rt_memcmp(topic, OTA_TOPIC_REPLY, topic_len) == 0)
+    {
+        ota_recv_block((const rt_uint8_t *)payload, len);
+        return RT_TRUE;
+    }
+    if (topic_len == sizeof(OTA_TOPIC_UPGRADE) - 1 && rt_memcmp(topic, OTA_TOPIC_UPGRADE, topic_len) == 0)
+    {
+        ota_recv_notice(payload);
+        return RT_TRUE;
+    }
+
+    return RT_FALSE;
+}
+
+/**
+ * The largest block a reply can bring in: the transport has to take the
+ * whole reply, and the AT client drops a +NSONMI line longer than its
+ * buffer, which has to hold the reply in one piece unless it fits a full
+ * module datagram.
+ *
+ * @return block size, 0 if not even one byte fits
+ */
+static rt_size_t ota_block_fit(void)
+{
+    rt_size_t payload = bc28_mqtt_payload_max();
+    rt_size_t block = OTA_BLOCK;
+
+    if (payload <= OTA_REPLY_OVERHEAD)
+    {
+        return 0;
+    }
+    block = (payload - OTA_REPLY_OVERHEAD) < block ? payload - OTA_REPLY_OVERHEAD : block;
+
+#ifdef BC28_USING_SOCKET
+    rt_size_t urc = AT_CLIENT_RECV_BUFF_LEN > OTA_URC_OVERHEAD ? (AT_CLIENT_RECV_BUFF_LEN - OTA_URC_OVERHEAD) / 2 : 0;
+    rt_size_t head = 0;
+
+    if (urc < BC28_SOCKET_PAYLOAD_MAX)
+    {
+        /* PUBLISH fixed header, topic name and packet id around the payload */
+        head = 7 + sizeof(OTA_TOPIC_REPLY) - 1 + OTA_REPLY_OVERHEAD;
+        block = urc <= head ? 0 : ((urc - head) < block ? urc - head : block);
+    }
+#endif
+
+    return block;
+}
+
+/**
+ * Report the running version and wait for upgrade notices. Call it once
+ * MQTT is connected. Replies carry binary blocks, so the firmware transport
+ * cannot be used.
+ *
+ * @param  version : running firmware version
+ *
+ * @return 0 : success
+ *        <0 : failed, -RT_ENOSYS on the firmware transport, -RT_EFULL
+ *             if a reply cannot fit PKG_USING_BC28_MQTT_RECV_BUFF_LEN
+ */
+int bc28_ota_start(const char *version)
+{
+    char msg[OTA_MSG_LEN];
+
+    if (!bc28_transport_binary())
+    {
+        LOG_E("OTA needs a binary safe transport.");
+        return -RT_ENOSYS;
+    }
+
+    ota.block = ota_block_fit();
+    if (ota.block == 0)
+    {
+        LOG_E("a reply does not fit the AT client line, raise PKG_USING_BC28_MQTT_RECV_BUFF_LEN.");
+        return -RT_EFULL;
+    }
+    if (ota.block < OTA_BLOCK)
+    {
+        LOG_W("blocks of %d bytes, %d does not fit the AT client line.", ota.block, OTA_BLOCK);
+    }
+
+    if (ota.tid == RT_NULL)
+    {
+        if ((ota.part = fal_partition_find(OTA_PARTITION)) == RT_NULL)
+        {
+            LOG_E("partition %s not found.", OTA_PARTITION);
+            return -RT_ERROR;
+        }
+
+        ota.wake = rt_sem_create("bc28ota", 0, RT_IPC_FLAG_FIFO);
+        ota.lock = rt_mutex_create("bc28ota", RT_IPC_FLAG_PRIO);
+        if (ota.wake == RT_NULL || ota.lock == RT_NULL)
+        {
+            return -RT_ENOMEM;
+        }
+
+        ota.tid = rt_thread_create("bc28ota", ota_thread_entry, RT_NULL,
+                                   OTA_THREAD_STACK, OTA_THREAD_PRIORITY, 10);
+        if (ota.tid == RT_NULL)
+        {
+            LOG_E("create OTA thread failed.");
+            return -RT_ENOMEM;
+        }
+        rt_thread_startup(ota.tid);
+    }
+
+    rt_strncpy(ota.version, version, sizeof(ota.version) - 1);
+
+    if (bc28_mqtt_subscribe(OTA_TOPIC_UPGRADE) != RT_EOK ||
+        bc28_mqtt_subscribe(OTA_TOPIC_REPLY) != RT_EOK)
+    {
+        return -RT_ERROR;
+    }
+
+    rt_snprintf(msg, sizeof(msg), "{\"id\":\"%u\",\"params\":{\"version\":\"%s\"}}", ++ota.id, ota.version);
+
+    return bc28_mqtt_publish(OTA_TOPIC_INFORM, msg);
+}
+
+/**
+ * Abandon the current download, a new notice starts over.
+ *
+ * @return 0 : success
+ */
+int bc28_ota_stop(void)
+{
+    if (ota.lock)
+    {
+        rt_mutex_take(ota.lock, RT_WAITING_FOREVER);
+        ota.state = OTA_IDLE;
+        ota.stream_id = 0;
+        rt_mutex_release(ota.lock);
+    }
+
+    return RT_EOK;
+}
+
+/**
+ * Bind a callback run in the OTA thread when a download ends.
+ *
+ * @param callback : result is 0 when the image in the partition is verified
+ *
+ * @return void
+ */
+void bc28_ota_bind(void (*callback)(int result, const char *version))
+{
+    ota.callback = callback;
+}
+
+#ifdef FINSH_USING_MSH
+static void bc28_ota(int argc, char *argv[])
+{
+    static const char *state[] = { "idle", "notice", "download", "done", "failed" };
+    rt_uint32_t ms = 0;
+
+    if (argc >= 3 && !rt_strcmp(argv[1], "start"))
+    {
+        rt_kprintf("%d\n", bc28_ota_start(argv[2]));
+        return;
+    }
+    if (argc >= 2 && !rt_strcmp(argv[1], "stop"))
+    {
+        bc28_ota_stop();
+        return;
+    }
+    if (argc >= 2)
+    {
+        rt_kprintf("Usage: bc28_ota [start <version> | stop]\n");
+        return;
+    }
+
+    ms = (rt_tick_get() - ota.start) * 1000 / RT_TICK_PER_SECOND;
+    rt_kprintf("state     : %s\n", state[ota.state]);
+    rt_kprintf("version   : %s -> %s\n", ota.version, ota.target[0] ? ota.target : "-");
+    if (ota.state >= OTA_DOWNLOAD)
+    {
+        rt_kprintf("progress  : %u/%u bytes, %u B/s\n", ota.done, ota.size,
+                   ms ? (rt_uint32_t)((rt_uint64_t)ota.done * 1000 / ms) : 0);
+        rt_kprintf("received  : %u bytes, %u resends, %u stalls, %u errors\n",
+                   ota.received, ota.resends, ota.stalls, ota.errors);
+    }
+}
+MSH_CMD_EXPORT(bc28_ota, show or control the OTA download);
+#endif
+
+#endif /* PKG_USING_BC28_MQTT_OTA */
@@ -0,0 +1,379 @@
+/*
+ * Copyright (c) 2023, RudyLo <luhuadong@163.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     agent        the first version
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <rtthread.h>
+#include <at.h>
+
+#define DBG_TAG                       "pkg.bc28_socket"
+#ifdef PKG_USING_BC28_MQTT_DEBUG
+#define DBG_LVL                       DBG_LOG
+#else
+#define DBG_LVL                       DBG_ERROR
+#endif
+#include <rtdbg.h>
+
+#include "bc28_mqtt_internal.h"
+
+#ifdef BC28_USING_SOCKET
+
+#define AT_SOCKET_CREATE_UDP          "AT+NSOCR=DGRAM,17,%u,1"
+#define AT_SOCKET_CREATE_TCP          "AT+NSOCR=STREAM,6,%u,1"
+#define AT_SOCKET_CONNECT             "AT+NSOCO=%d,%s,%u"
+#define AT_SOCKET_SENDTO              "AT+NSOST=%d,%s,%u,%u,"
+#define AT_SOCKET_SEND                "AT+NSOSD=%d,%u,"
+#define AT_SOCKET_CLOSE               "AT+NSOCL=%d"
+
+#define AT_SOCKET_RESP_LEN            64
+#define AT_SOCKET_TIMEOUT             5000
+#define AT_SOCKET_CONNECT_TIMEOUT     30000
+
+/* the hex payload is streamed behind the command head, see bc28_exec_long() */
+#define AT_SOCKET_PAYLOAD_MAX         BC28_SOCKET_PAYLOAD_MAX
+
+#ifndef PKG_USING_BC28_MQTT_SOCKET_RECV_LEN
+#define PKG_USING_BC28_MQTT_SOCKET_RECV_LEN      512
+#endif
+#define AT_SOCKET_RECV_LEN            PKG_USING_BC28_MQTT_SOCKET_RECV_LEN
+
+static bc28_socket_recv_t recv_cb[BC28_SOCKET_MAX];
+
+/* only touched by the AT parser thread */
+static rt_uint8_t recv_buf[AT_SOCKET_RECV_LEN];
+
+static void hex_encode(char *hex, const rt_uint8_t *data, rt_size_t len)
+{
+    static const char digits[] = "0123456789ABCDEF";
+
+    for (rt_size_t i = 0; i < len; i++)
+    {
+        *hex++ = digits[data[i] >> 4];
+        *hex++ = digits[data[i] & 0x0F];
+    }
+    *hex = '\0';
+}
+
+/* payload of one send command, walked across the gather buffers */
+struct hex_stream
+{
+    const struct bc28_iovec *iov;
+    int        count;
+    rt_size_t  off;                 /* offset into the current buffer */
+    rt_size_t  left;                /* bytes still to encode for this command */
+};
+
+static rt_size_t hex_stream_fill(char *buf, rt_size_t size, void *arg)
+{
+    struct hex_stream *s = arg;
+    rt_size_t room = (size - 1) / 2, n = 0, take = 0;
+
+    while (n < room && s->left > 0 && s->count > 0)
+    {
+        take = s->iov->len - s->off;
+        if (take > room - n)
+        {
+            take = room - n;
+        }
+        if (take > s->left)
+        {
+            take = s->left;
+        }
+        hex_encode(buf + n * 2, (const rt_uint8_t *)s->iov->base + s->off, take);
+        n       += take;
+        s->off  += take;
+        s->left -= take;
+
+        if (s->off == s->iov->len)
+        {
+            s->iov++;
+            s->count--;
+            s->off = 0;
+        }
+    }
+
+    return n * 2;
+}
+
+static int hex_value(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+static rt_size_t hex_decode(rt_uint8_t *data, rt_size_t size, const char *hex, rt_size_t len)
+{
+    rt_size_t n = 0;
+
+    for (; n < size && len >= 2; n++, hex += 2, len -= 2)
+    {
+        int hi = hex_value(hex[0]), lo = hex_value(hex[1]);
+        if (hi < 0 || lo < 0)
+        {
+            break;
+        }
+        data[n] = (rt_uint8_t)(hi << 4 | lo);
+    }
+
+    return n;
+}
+
+/**
+ * Create a module socket.
+ *
+ * @param type : BC28_SOCKET_UDP or BC28_SOCKET_TCP
+ * @param port : local port, 0 to let the module choose
+ * @param recv : called for every datagram or stream chunk received
+ *
+ * @return >=0 : socket id
+ *          <0 : create failed
+ */
+int bc28_socket_create(bc28_socket_type_t type, rt_uint16_t port, bc28_socket_recv_t recv)
+{
+    at_response_t resp = RT_NULL;
+    const char *line = RT_NULL;
+    int socket = -1;
+
+    resp = at_create_resp(AT_SOCKET_RESP_LEN, 0, rt_tick_from_millisecond(AT_SOCKET_TIMEOUT));
+    if (resp == RT_NULL)
+    {
+        LOG_E("No memory for response structure!");
+        return -RT_ENOMEM;
+    }
+
+    if (bc28_exec_cmd(resp, type == BC28_SOCKET_TCP ? AT_SOCKET_CREATE_TCP : AT_SOCKET_CREATE_UDP, port) != RT_EOK)
+    {
+        LOG_E("create socket failed.");
+        at_delete_resp(resp);
+        return -RT_ERROR;
+    }
+
+    /* the socket id is answered on a line of its own */
+    for (rt_size_t i = 1; i <= resp->line_counts; i++)
+    {
+        line = at_resp_get_line(resp, i);
+        if (line && line[0] >= '0' && line[0] <= '9')
+        {
+            socket = atoi(line);
+            break;
+        }
+    }
+    at_delete_resp(resp);
+
+    if (socket < 0 || socket >= BC28_SOCKET_MAX)
+    {
+        LOG_E("invalid socket id %d.", socket);
+        return -RT_ERROR;
+    }
+
+    recv_cb[socket] = recv;
+    LOG_D("socket %d created.", socket);
+
+    return socket;
+}
+
+/**
+ * Connect a TCP socket.
+ *
+ * @return 0 : connect success
+ *        <0 : connect failed
+ */
+int bc28_socket_connect(int socket, const char *ip, rt_uint16_t port)
+{
+    at_response_t resp = RT_NULL;
+    int result = 0;
+
+    resp = at_create_resp(AT_SOCKET_RESP_LEN, 0, rt_tick_from_millisecond(AT_SOCKET_CONNECT_TIMEOUT));
+    if (resp == RT_NULL)
+    {
+        LOG_E("No memory for response structure!");
+        return -RT_ENOMEM;
+    }
+
+    result = bc28_exec_cmd(resp, AT_SOCKET_CONNECT, socket, ip, port);
+    at_delete_resp(resp);
+
+    return result;
+}
+
+/**
+ * Send one UDP datagram.
+ *
+ * @return 0 : send success
+ *        <0 : send failed, -RT_EFULL if the datagram exceeds AT_SOCKET_PAYLOAD_MAX
+ */
+int bc28_socket_sendto(int socket, const char *ip, rt_uint16_t port, const void *data, rt_size_t len)
+{
+    at_response_t resp = RT_NULL;
+    struct bc28_iovec iov = { data, len };
+    struct hex_stream stream = { &iov, 1, 0, len };
+    int result = 0;
+
+    if (len > AT_SOCKET_PAYLOAD_MAX)
+    {
+        LOG_E("datagram of %d bytes exceeds %d.", len, AT_SOCKET_PAYLOAD_MAX);
+        return -RT_EFULL;
+    }
+
+    resp = at_create_resp(AT_SOCKET_RESP_LEN, 0, rt_tick_from_millisecond(AT_SOCKET_TIMEOUT));
+    if (resp == RT_NULL)
+    {
+        LOG_E("No memory for response structure!");
+        return -RT_ENOMEM;
+    }
+
+    result = bc28_exec_long(resp, hex_stream_fill, &stream, AT_SOCKET_SENDTO, socket, ip, port, len);
+    at_delete_resp(resp);
+
+    return result;
+}
+
+/**
+ * Send data on a connected TCP socket, split into AT_SOCKET_PAYLOAD_MAX chunks.
+ *
+ * @return 0 : send success
+ *        <0 : send failed
+ */
+int bc28_socket_send(int socket, const void *data, rt_size_t len)
+{
+    struct bc28_iovec iov = { data, len };
+
+    return bc28_socket_sendv(socket, &iov, 1);
+}
+
+/**
+ * Send a packet gathered from several buffers on a connected TCP socket.
+ * Buffers are hex encoded straight onto the AT device, the packet is never
+ * assembled in RAM.
+ *
+ * @param socket : socket id
+ * @param iov    : buffers in send order
+ * @param count  : number of buffers
+ *
+ * @return 0 : send success
+ *        <0 : send failed
+ */
+int bc28_socket_sendv(int socket, const struct bc28_iovec *iov, int count)
+{
+    at_response_t resp = RT_NULL;
+    struct hex_stream stream = { iov, count, 0, 0 };
+    int result = RT_EOK;
+
+    resp = at_create_resp(AT_SOCKET_RESP_LEN, 0, rt_tick_from_millisecond(AT_SOCKET_TIMEOUT));
+    if (resp == RT_NULL)
+    {
+        LOG_E("No memory for response structure!");
+        return -RT_ENOMEM;
+    }
+
+    while (result == RT_EOK)
+    {
+        /* one command worth of payload across buffer boundaries */
+        stream.left = 0;
+        for (int i = 0; i < stream.count && stream.left < AT_SOCKET_PAYLOAD_MAX; i++)
+        {
+            stream.left += stream.iov[i].len - (i == 0 ? stream.off : 0);
+        }
+        if (stream.left == 0)
+        {
+            break;
+        }
+        if (stream.left > AT_SOCKET_PAYLOAD_MAX)
+        {
+            stream.left = AT_SOCKET_PAYLOAD_MAX;
+        }
+
+        result = bc28_exec_long(resp, hex_stream_fill, &stream, AT_SOCKET_SEND, socket, stream.left);
+    }
+
+    at_delete_resp(resp);
+    return result;
+}
+
+/**
+ * Close a module socket.
+ *
+ * @return 0 : close success
+ *        <0 : close failed
+ */
+int bc28_socket_close(int socket)
+{
+    at_response_t resp = RT_NULL;
+    int result = 0;
+
+    if (socket < 0 || socket >= BC28_SOCKET_MAX)
+    {
+        return -RT_EINVAL;
+    }
+    recv_cb[socket] = RT_NULL;
+
+    resp = at_create_resp(AT_SOCKET_RESP_LEN, 0, rt_tick_from_millisecond(AT_SOCKET_TIMEOUT));
+    if (resp == RT_NULL)
+    {
+        LOG_E("No memory for response structure!");
+        return -RT_ENOMEM;
+    }
+
+    result = bc28_exec_cmd(resp, AT_SOCKET_CLOSE, socket);
+    at_delete_resp(resp);
+
+    return result;
+}
+
+void bc28_socket_urc_recv(struct at_client *client, const char *data, rt_size_t size)
+{
+    /* AT+NSONMI=2: "+NSONMI:<socket>,<remote_addr>,<remote_port>,<length>,<data>" */
+    const char *hex = RT_NULL, *field = RT_NULL;
+    rt_size_t len = 0, hex_len = 0;
+    int socket = atoi(data + strlen("+NSONMI:"));
+
+    if (socket < 0 || socket >= BC28_SOCKET_MAX || recv_cb[socket] == RT_NULL)
+    {
+        LOG_D("drop data of socket %d", socket);
+        return;
+    }
+
+    /* the data is the last field, the length the one before it */
+    hex = strrchr(data, ',');
+    if (hex == RT_NULL)
+    {
+        return;
+    }
+    for (field = hex - 1; field > data && *field != ','; field--);
+    len = atoi(field + 1);
+
+    hex++;
+    while (hex[hex_len] && hex[hex_len] != '\r' && hex[hex_len] != '\n')
+    {
+        hex_len++;
+    }
+
+    len = hex_decode(recv_buf, len < sizeof(recv_buf) ? len : sizeof(recv_buf), hex, hex_len);
+    recv_cb[socket](socket, recv_buf, len);
+}
+
+void bc28_socket_urc_close(struct at_client *client, const char *data, rt_size_t size)
+{
+    /* "+NSOCLI: <socket>" */
+    int socket = atoi(data + strlen("+NSOCLI:"));
+
+    LOG_D("socket %d closed by peer", socket);
+
+    if (socket >= 0 && socket < BC28_SOCKET_MAX && recv_cb[socket])
+    {
+        recv_cb[socket](socket, RT_NULL, 0);
+    }
+}
+
+#endif /* BC28_USING_SOCKET */
@@ -0,0 +1,797 @@
+/*
+ * Copyright (c) 2023, RudyLo <luhuadong@163.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     agent        the first version
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <rtthread.h>
+#include <rtdevice.h>
+
+#define DBG_TAG                       "pkg.bc28_tap"
+#ifdef PKG_USING_BC28_MQTT_DEBUG
+#define DBG_LVL                       DBG_LOG
+#else
+#define DBG_LVL                       DBG_ERROR
+#endif
+#include <rtdbg.h>
+
+#include "bc28_mqtt_internal.h"
+
+#ifdef PKG_USING_BC28_MQTT_TAP
+
+/*
+ * The tap is a character device stacked between the AT client and the
+ * UART. In passthrough it only forwards, in record mode every byte in both
+ * directions is also queued to a writer thread that appends it to a
+ * capture file, in replay mode the UART is cut off and the received side
+ * of a capture is fed to the AT client instead.
+ *
+ * Capture file: the 8 byte magic TAP_MAGIC, then records of
+ *
+ *   u32 time   ms since the capture started, little endian
+ *   u8  dir    BC28_TAP_RX or BC28_TAP_TX
+ *   u16 len    little endian
+ *   u8  data[len]
+ *
+ * Replay is lockstep: before the bytes received after a command are fed,
+ * the AT client has to send that command again, so responses always
+ * follow their requests whatever the speed factor.
+ *
+ * In filter mode the module is still connected, but what it sends goes to
+ * the fault injector, which passes, holds back, drops or adds bytes before
+ * they reach the AT client.
+ */
+
+#ifndef PKG_USING_BC28_MQTT_TAP_BUFF_LEN
+#define PKG_USING_BC28_MQTT_TAP_BUFF_LEN         4096
+#endif
+#ifndef PKG_USING_BC28_MQTT_TAP_FILE
+#define PKG_USING_BC28_MQTT_TAP_FILE             "/bc28.tap"
+#endif
+
+#define TAP_BUFF_LEN                  PKG_USING_BC28_MQTT_TAP_BUFF_LEN
+#define TAP_FILE                      PKG_USING_BC28_MQTT_TAP_FILE
+#define TAP_MAGIC                     "BC28TAP1"
+#define TAP_HEADER_LEN                7
+#define TAP_CHUNK_LEN                 128
+#define TAP_MERGE_MS                  10         /* bytes closer than this share a record */
+#define TAP_FLUSH_MS                  100
+#define TAP_TX_TIMEOUT                10000      /* wait for the AT client to repeat a command */
+#define TAP_TX_ITEM_LEN               62
+#define TAP_TX_ITEMS                  8
+#define TAP_REPLAY_LEN                1024
+#define TAP_THREAD_STACK              1536
+#define TAP_THREAD_PRIORITY           (RT_THREAD_PRIORITY_MAX / 2 + 1)
+
+#define BC28_TAP_RX                   '<'
+#define BC28_TAP_TX                   '>'
+
+/* RT_VERSION_CHECK() is not there before 4.1, it cannot share the #if */
+#if defined(RT_VERSION_CHECK)
+#if RTTHREAD_VERSION >= RT_VERSION_CHECK(5, 0, 0)
+#define TAP_SSIZE
+#endif
+#endif
+#ifdef TAP_SSIZE
+typedef rt_ssize_t tap_size_t;
+#else
+typedef rt_size_t tap_size_t;
+#endif
+
+enum tap_mode
+{
+    TAP_PASSTHROUGH = 0,
+    TAP_RECORD,
+    TAP_REPLAY,
+    TAP_FILTER
+};
+
+struct tap_tx_item
+{
+    rt_uint16_t  len;
+    rt_uint8_t   data[TAP_TX_ITEM_LEN];
+};
+
+struct bc28_tap
+{
+    struct rt_device parent;
+    rt_device_t  uart;
+    rt_uint8_t   mode;
+
+    /* record */
+    int          fd;
+    rt_tick_t    start;
+    rt_uint32_t  bytes;
+    rt_uint32_t  dropped;
+    rt_mutex_t   file_lock;
+    rt_sem_t     notify;
+    rt_thread_t  writer;
+    struct rt_ringbuffer ring;
+    rt_uint8_t   pool[TAP_BUFF_LEN];
+
+    rt_uint8_t   chunk_dir;
+    rt_uint32_t  chunk_ms;
+    rt_uint16_t  chunk_len;
+    rt_uint8_t   chunk[TAP_CHUNK_LEN];
+
+    /* replay */
+    rt_uint32_t  speed;
+    rt_uint32_t  records;
+    rt_uint32_t  replay_ms;
+    rt_uint32_t  mismatch;
+    rt_uint32_t  stalled;
+    rt_mq_t      tx_mq;
+    struct tap_tx_item tx_item;   /* command being matched and how far */
+    rt_size_t    tx_off;
+    rt_sem_t     filter_notify;
+    struct rt_ringbuffer replay_ring;
+    rt_uint8_t   replay_pool[TAP_REPLAY_LEN];
+};
+
+static struct bc28_tap tap = {
+    .fd = -1
+};
+
+static rt_uint32_t tap_ms(void)
+{
+    return (rt_tick_get() - tap.start) * 1000 / RT_TICK_PER_SECOND;
+}
+
+static void put_le(rt_uint8_t *p, rt_uint32_t v, int n)
+{
+    while (n--)
+    {
+        *p++ = v & 0xFF;
+        v >>= 8;
+    }
+}
+
+static rt_uint32_t get_le(const rt_uint8_t *p, int n)
+{
+    rt_uint32_t v = 0;
+
+    while (n--)
+    {
+        v = v << 8 | p[n];
+    }
+
+    return v;
+}
+
+/* call inside a critical section */
+static void tap_commit(void)
+{
+    rt_uint8_t header[TAP_HEADER_LEN];
+
+    if (tap.chunk_len == 0)
+    {
+        return;
+    }
+
+    if (rt_ringbuffer_space_len(&tap.ring) < (rt_size_t)(TAP_HEADER_LEN + tap.chunk_len))
+    {
+        tap.dropped += tap.chunk_len;
+    }
+    else
+    {
+        put_le(header, tap.chunk_ms, 4);
+        header[4] = tap.chunk_dir;
+        put_le(header + 5, tap.chunk_len, 2);
+        rt_ringbuffer_put(&tap.ring, header, TAP_HEADER_LEN);
+        rt_ringbuffer_put(&tap.ring, tap.chunk, tap.chunk_len);
+    }
+
+    tap.chunk_len = 0;
+}
+
+static void tap_record(rt_uint8_t dir, const rt_uint8_t *data, rt_size_t len)
+{
+    rt_uint32_t now = tap_ms();
+    rt_size_t take = 0;
+
+    /* the AT client reads one byte at a time, merge them into records */
+    rt_enter_critical();
+    while (len > 0)
+    {
+        if (tap.chunk_len && (tap.chunk_dir != dir || now - tap.chunk_ms > TAP_MERGE_MS ||
+                              tap.chunk_len == TAP_CHUNK_LEN))
+        {
+            tap_commit();
+        }
+        if (tap.chunk_len == 0)
+        {
+            tap.chunk_dir = dir;
+            tap.chunk_ms  = now;
+        }
+
+        take = TAP_CHUNK_LEN - tap.chunk_len;
+        take = take < len ? take : len;
+        rt_memcpy(tap.chunk + tap.chunk_len, data, take);
+        tap.chunk_len += take;
+        data += take;
+        len  -= take;
+    }
+    rt_exit_critical();
+}
+
+static void tap_flush(void)
+{
+    rt_uint8_t buf[64];
+    rt_size_t n = 0;
+
+    rt_mutex_take(tap.file_lock, RT_WAITING_FOREVER);
+
+    rt_enter_critical();
+    if (tap.chunk_len && tap_ms() - tap.chunk_ms > TAP_MERGE_MS)
+    {
+        tap_commit();
+    }
+    rt_exit_critical();
+
+    do
+    {
+        rt_enter_critical();
+        n = rt_ringbuffer_get(&tap.ring, buf, sizeof(buf));
+        rt_exit_critical();
+
+        if (n > 0 && tap.fd >= 0)
+        {
+            write(tap.fd, buf, n);
+            tap.bytes += n;
+        }
+    } while (n > 0);
+
+    rt_mutex_release(tap.file_lock);
+}
+
+static void tap_writer_entry(void *parameter)
+{
+    while (1)
+    {
+        rt_sem_take(tap.notify, rt_tick_from_millisecond(TAP_FLUSH_MS));
+        tap_flush();
+    }
+}
+
+static rt_err_t tap_rx_ind(rt_device_t dev, rt_size_t size)
+{
+    /* the modem is not listened to while a capture plays */
+    if (tap.mode == TAP_FILTER)
+    {
+        return rt_sem_release(tap.filter_notify);
+    }
+    if (tap.mode != TAP_REPLAY && tap.parent.rx_indicate)
+    {
+        return tap.parent.rx_indicate(&tap.parent, size);
+    }
+
+    return RT_EOK;
+}
+
+static rt_err_t tap_open(rt_device_t dev, rt_uint16_t oflag)
+{
+    rt_err_t result = rt_device_open(tap.uart, oflag);
+
+    if (result == RT_EOK)
+    {
+        rt_device_set_rx_indicate(tap.uart, tap_rx_ind);
+    }
+
+    return result;
+}
+
+static rt_err_t tap_close(rt_device_t dev)
+{
+    rt_device_set_rx_indicate(tap.uart, RT_NULL);
+    return rt_device_close(tap.uart);
+}
+
+static tap_size_t tap_read(rt_device_t dev, rt_off_t pos, void *buffer, rt_size_t size)
+{
+    tap_size_t n = 0;
+
+    /* fed bytes first, some may be left over from a filter that just ended */
+    rt_enter_critical();
+    n = rt_ringbuffer_get(&tap.replay_ring, buffer, size);
+    rt_exit_critical();
+
+    if (n > 0 || tap.mode == TAP_REPLAY || tap.mode == TAP_FILTER)
+    {
+        return n;
+    }
+
+    n = rt_device_read(tap.uart, pos, buffer, size);
+    if (n > 0 && tap.mode == TAP_RECORD)
+    {
+        tap_record(BC28_TAP_RX, buffer, n);
+    }
+
+    return n;
+}
+
+static tap_size_t tap_write(rt_device_t dev, rt_off_t pos, const void *buffer, rt_size_t size)
+{
+    const rt_uint8_t *data = buffer;
+    struct tap_tx_item item;
+    rt_size_t left = size;
+
+    if (tap.mode == TAP_REPLAY)
+    {
+        /* swallowed, the replay thread checks it against the capture */
+        while (left > 0)
+        {
+            item.len = left < TAP_TX_ITEM_LEN ? left : TAP_TX_ITEM_LEN;
+            rt_memcpy(item.data, data, item.len);
+            if (rt_mq_send(tap.tx_mq, &item, sizeof(item)) != RT_EOK)
+            {
+                tap.mismatch++;
+            }
+            data += item.len;
+            left -= item.len;
+        }
+        return size;
+    }
+
+    if (tap.mode == TAP_RECORD)
+    {
+        tap_record(BC28_TAP_TX, buffer, size);
+    }
+
+    return rt_device_write(tap.uart, pos, buffer, size);
+}
+
+static rt_err_t tap_control(rt_device_t dev, int cmd, void *args)
+{
+    return rt_device_control(tap.uart, cmd, args);
+}
+
+#ifdef RT_USING_DEVICE_OPS
+static const struct rt_device_ops tap_ops = {
+    RT_NULL,
+    tap_open,
+    tap_close,
+    tap_read,
+    tap_write,
+    tap_control
+};
+#endif
+
+/**
+ * Register the tap device on top of a UART, the AT client then opens
+ * BC28_TAP_DEV_NAME instead of the UART.
+ *
+ * @param uart_name : name of the UART connected to the module
+ *
+ * @return 0 : success
+ *        <0 : failed
+ */
+int bc28_tap_init(const char *uart_name)
+{
+    if (tap.uart)
+    {
+        return RT_EOK;
+    }
+
+    tap.uart = rt_device_find(uart_name);
+    if (tap.uart == RT_NULL)
+    {
+        LOG_E("tap: device %s not found.", uart_name);
+        return -RT_ERROR;
+    }
+
+    tap.parent.type = RT_Device_Class_Char;
+#ifdef RT_USING_DEVICE_OPS
+    tap.parent.ops     = &tap_ops;
+#else
+    tap.parent.init    = RT_NULL;
+    tap.parent.open    = tap_open;
+    tap.parent.close   = tap_close;
+    tap.parent.read    = tap_read;
+    tap.parent.write   = tap_write;
+    tap.parent.control = tap_control;
+#endif
+
+    return rt_device_register(&tap.parent, BC28_TAP_DEV_NAME, tap.uart->flag);
+}
+
+static int tap_prepare(void)
+{
+    if (tap.file_lock == RT_NULL)
+    {
+        tap.file_lock = rt_mutex_create("bc28tap", RT_IPC_FLAG_PRIO);
+        tap.notify    = rt_sem_create("bc28tap", 0, RT_IPC_FLAG_FIFO);
+        tap.tx_mq     = rt_mq_create("bc28tap", sizeof(struct tap_tx_item), TAP_TX_ITEMS, RT_IPC_FLAG_FIFO);
+        if (!tap.file_lock || !tap.notify || !tap.tx_mq)
+        {
+            LOG_E("No memory for tap!");
+            return -RT_ENOMEM;
+        }
+        rt_ringbuffer_init(&tap.ring, tap.pool, sizeof(tap.pool));
+        rt_ringbuffer_init(&tap.replay_ring, tap.replay_pool, sizeof(tap.replay_pool));
+    }
+
+    return RT_EOK;
+}
+
+/**
+ * Start capturing the AT traffic to a file.
+ *
+ * @param path : capture file, RT_NULL for PKG_USING_BC28_MQTT_TAP_FILE
+ *
+ * @return 0 : success
+ *        <0 : failed
+ */
+int bc28_tap_record(const char *path)
+{
+    int result = 0;
+
+    if (tap.mode != TAP_PASSTHROUGH)
+    {
+        return -RT_EBUSY;
+    }
+    if ((result = tap_prepare()) != RT_EOK)
+    {
+        return result;
+    }
+
+    path = path ? path : TAP_FILE;
+    tap.fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0);
+    if (tap.fd < 0)
+    {
+        LOG_E("tap: open %s failed.", path);
+        return -RT_EIO;
+    }
+    write(tap.fd, TAP_MAGIC, 8);
+
+    if (tap.writer == RT_NULL)
+    {
+        tap.writer = rt_thread_create("bc28tap", tap_writer_entry, RT_NULL,
+                                      TAP_THREAD_STACK, TAP_THREAD_PRIORITY, 10);
+        if (tap.writer == RT_NULL)
+        {
+            close(tap.fd);
+            tap.fd = -1;
+            return -RT_ENOMEM;
+        }
+        rt_thread_startup(tap.writer);
+    }
+
+    rt_enter_critical();
+    rt_ringbuffer_reset(&tap.ring);
+    tap.chunk_len = 0;
+    tap.bytes     = 8;
+    tap.dropped   = 0;
+    tap.start     = rt_tick_get();
+    tap.mode      = TAP_RECORD;
+    rt_exit_critical();
+
+    LOG_D("tap: recording to %s", path);
+    return RT_EOK;
+}
+
+/**
+ * Stop recording, or cut a running replay short.
+ *
+ * @return 0 : success
+ */
+int bc28_tap_stop(void)
+{
+    if (tap.mode == TAP_RECORD)
+    {
+        tap.mode = TAP_PASSTHROUGH;
+
+        rt_enter_critical();
+        tap_commit();
+        rt_exit_critical();
+        tap_flush();
+
+        rt_mutex_take(tap.file_lock, RT_WAITING_FOREVER);
+        close(tap.fd);
+        tap.fd = -1;
+        rt_mutex_release(tap.file_lock);
+
+        if (tap.dropped)
+        {
+            LOG_E("tap: %u bytes dropped, raise PKG_USING_BC28_MQTT_TAP_BUFF_LEN.", tap.dropped);
+        }
+    }
+    else if (tap.mode == TAP_REPLAY)
+    {
+        tap.mode = TAP_PASSTHROUGH;
+    }
+
+    return RT_EOK;
+}
+
+static void tap_feed(const rt_uint8_t *data, rt_size_t len, rt_uint8_t mode)
+{
+    rt_size_t put = 0;
+
+    while (put < len && tap.mode == mode)
+    {
+        rt_enter_critical();
+        put += rt_ringbuffer_put(&tap.replay_ring, data + put, len - put);
+        rt_exit_critical();
+
+        if (tap.parent.rx_indicate)
+        {
+            tap.parent.rx_indicate(&tap.parent, len);
+        }
+        if (put < len)
+        {
+            rt_thread_mdelay(1);
+        }
+    }
+}
+
+/**
+ * Wait until the AT client has sent len bytes and compare them with the
+ * command in the capture.
+ */
+static void replay_expect(const rt_uint8_t *data, rt_size_t len)
+{
+    struct tap_tx_item *item = &tap.tx_item;
+    rt_size_t take = 0;
+
+    while (len > 0 && tap.mode == TAP_REPLAY)
+    {
+        if (tap.tx_off == item->len)
+        {
+            tap.tx_off = 0;
+            item->len  = 0;
+            if (rt_mq_recv(tap.tx_mq, item, sizeof(*item), rt_tick_from_millisecond(TAP_TX_TIMEOUT)) < 0)
+            {
+                /* the client took another path, carry on with the capture */
+                tap.stalled++;
+                LOG_D("tap: AT client did not send %.*s", (int)len, data);
+                return;
+            }
+        }
+
+        take = item->len - tap.tx_off;
+        take = take < len ? take : len;
+        if (rt_memcmp(item->data + tap.tx_off, data, take) != 0)
+        {
+            tap.mismatch++;
+            LOG_D("tap: sent %.*s, capture has %.*s", (int)take, item->data + tap.tx_off, (int)take, data);
+        }
+        tap.tx_off += take;
+        data += take;
+        len  -= take;
+    }
+}
+
+static void replay_entry(void *parameter)
+{
+    int fd = (int)(rt_ubase_t)parameter;
+    rt_uint8_t header[TAP_HEADER_LEN];
+    rt_uint8_t data[TAP_CHUNK_LEN];
+    rt_uint32_t base_ms = 0, time = 0, len = 0;
+    rt_tick_t base = rt_tick_get(), begin = base;
+    rt_int32_t delay = 0;
+
+    while (tap.mode == TAP_REPLAY && read(fd, header, TAP_HEADER_LEN) == TAP_HEADER_LEN)
+    {
+        time = get_le(header, 4);
+        len  = get_le(header + 5, 2);
+        if (len > sizeof(data) || read(fd, data, len) != (int)len)
+        {
+            LOG_E("tap: capture truncated.");
+            break;
+        }
+        tap.records++;
+
+        if (header[4] == BC28_TAP_TX)
+        {
+            replay_expect(data, len);
+
+            /* what follows was timed from this command */
+            base    = rt_tick_get();
+            base_ms = time;
+            continue;
+        }
+
+        if (tap.speed)
+        {
+            delay = (rt_int32_t)(base + rt_tick_from_millisecond((time - base_ms) / tap.speed) - rt_tick_get());
+            if (delay > 0)
+            {
+                rt_thread_delay(delay);
+            }
+        }
+
+        tap_feed(data, len, TAP_REPLAY);
+    }
+
+    close(fd);
+    tap.replay_ms = (rt_tick_get() - begin) * 1000 / RT_TICK_PER_SECOND;
+    tap.mode = TAP_PASSTHROUGH;
+
+    rt_kprintf("tap: replayed %u records in %u ms, %u mismatched, %u stalled\n",
+               tap.records, tap.replay_ms, tap.mismatch, tap.stalled);
+}
+
+/**
+ * Feed a capture to the AT client in place of the module.
+ *
+ * @param path  : capture file, RT_NULL for PKG_USING_BC28_MQTT_TAP_FILE
+ * @param speed : 1 for real time, N for N times faster, 0 without delays
+ *
+ * @return 0 : replay started
+ *        <0 : failed
+ */
+int bc28_tap_replay(const char *path, rt_uint32_t speed)
+{
+    char magic[8];
+    rt_thread_t tid = RT_NULL;
+    int fd = -1, result = 0;
+
+    if (tap.mode != TAP_PASSTHROUGH)
+    {
+        return -RT_EBUSY;
+    }
+    if ((result = tap_prepare()) != RT_EOK)
+    {
+        return result;
+    }
+
+    path = path ? path : TAP_FILE;
+    fd = open(path, O_RDONLY, 0);
+    if (fd < 0 || read(fd, magic, 8) != 8 || rt_memcmp(magic, TAP_MAGIC, 8) != 0)
+    {
+        LOG_E("tap: %s is not a capture.", path);
+        if (fd >= 0) close(fd);
+        return -RT_EIO;
+    }
+
+    rt_mq_control(tap.tx_mq, RT_IPC_CMD_RESET, RT_NULL);
+    rt_enter_critical();
+    rt_ringbuffer_reset(&tap.replay_ring);
+    rt_exit_critical();
+
+    tap.tx_item.len = 0;
+    tap.tx_off   = 0;
+    tap.speed     = speed;
+    tap.records   = 0;
+    tap.replay_ms = 0;
+    tap.mismatch  = 0;
+    tap.stalled   = 0;
+    tap.mode      = TAP_REPLAY;
+
+    tid = rt_thread_create("bc28rpl", replay_entry, (void *)(rt_ubase_t)fd,
+                           TAP_THREAD_STACK, TAP_THREAD_PRIORITY, 10);
+    if (tid == RT_NULL)
+    {
+        tap.mode = TAP_PASSTHROUGH;
+        close(fd);
+        return -RT_ENOMEM;
+    }
+    rt_thread_startup(tid);
+
+    return RT_EOK;
+}
+
+/**
+ * Put the fault injector between the module and the AT client.
+ *
+ * @param notify : released whenever the module sends bytes, RT_NULL to
+ *                 connect the module to the AT client again
+ *
+ * @return 0 : success
+ *        <0 : the tap is recording or replaying
+ */
+int bc28_tap_filter(rt_sem_t notify)
+{
+    int result = 0;
+
+    if (notify == RT_NULL)
+    {
+        if (tap.mode == TAP_FILTER)
+        {
+            tap.mode = TAP_PASSTHROUGH;
+
+            /* pick up what arrived while nobody was listening */
+            if (tap.parent.rx_indicate)
+            {
+                tap.parent.rx_indicate(&tap.parent, 1);
+            }
+        }
+        return RT_EOK;
+    }
+
+    if (tap.mode != TAP_PASSTHROUGH || tap.uart == RT_NULL)
+    {
+        return -RT_EBUSY;
+    }
+    if ((result = tap_prepare()) != RT_EOK)
+    {
+        return result;
+    }
+
+    tap.filter_notify = notify;
+    tap.mode = TAP_FILTER;
+
+    return RT_EOK;
+}
+
+/**
+ * Read what the module sent, for the fault injector.
+ *
+ * @return bytes read
+ */
+rt_size_t bc28_tap_uart_read(void *buffer, rt_size_t size)
+{
+    tap_size_t n = rt_device_read(tap.uart, 0, buffer, size);
+
+    return n > 0 ? n : 0;
+}
+
+/**
+ * Hand bytes to the AT client as if the module had sent them.
+ *
+ * @return void
+ */
+void bc28_tap_feed(const void *data, rt_size_t len)
+{
+    tap_feed(data, len, TAP_FILTER);
+}
+
+/**
+ * Get the state of the tap and the counters of the last record or replay.
+ *
+ * @param info : output tap information
+ *
+ * @return void
+ */
+void bc28_tap_info_get(struct bc28_tap_info *info)
+{
+    info->recording = (tap.mode == TAP_RECORD);
+    info->replaying = (tap.mode == TAP_REPLAY);
+    info->recorded  = tap.bytes;
+    info->dropped   = tap.dropped;
+    info->records   = tap.records;
+    info->replay_ms = tap.replay_ms;
+    info->mismatch  = tap.mismatch;
+    info->stalled   = tap.stalled;
+}
+
+#ifdef FINSH_USING_MSH
+static void bc28_tap(int argc, char *argv[])
+{
+    static const char *mode[] = {"passthrough", "record", "replay", "filter"};
+
+    if (argc >= 2 && !strcmp(argv[1], "record"))
+    {
+        bc28_tap_record(argc >= 3 ? argv[2] : RT_NULL);
+    }
+    else if (argc >= 2 && !strcmp(argv[1], "replay"))
+    {
+        bc28_tap_replay(argc >= 3 ? argv[2] : RT_NULL, argc >= 4 ? atoi(argv[3]) : 1);
+    }
+    else if (argc >= 2 && !strcmp(argv[1], "stop"))
+    {
+        bc28_tap_stop();
+    }
+    else if (argc >= 2)
+    {
+        rt_kprintf("Usage: bc28_tap [record [file] | replay [file] [speed] | stop]\n");
+        return;
+    }
+
+    rt_kprintf("mode     : %s\n", mode[tap.mode]);
+    rt_kprintf("recorded : %u bytes, %u dropped\n", tap.bytes, tap.dropped);
+}
+MSH_CMD_EXPORT(bc28_tap, record or replay the AT traffic);
+#endif
+
+#endif /* PKG_USING_BC28_MQTT_TAP */
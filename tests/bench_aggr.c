@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2023, RudyLo <luhuadong@163.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     agent        the first version
+ */
+
+/*
+ * Telemetry aggregation on the host: update cost per sample with thousands
+ * of series, and every closed window published within the payload limit.
+ * Run by tests/run.sh, built without sanitizers so the numbers mean something.
+ */
+
+#include <pthread.h>
+#include <time.h>
+
+#include <rtthread.h>
+
+#include "bc28_mqtt_internal.h"
+#include "test_host.h"
+
+#define SAMPLES                       2000000
+#define FLUSH_TIMEOUT                 5000
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static rt_size_t payload_limit;
+static int published, series_seen, too_long;
+static rt_size_t longest;
+
+rt_size_t bc28_mqtt_payload_max(void)
+{
+    return payload_limit;
+}
+
+int bc28_mqtt_publish(const char *topic, const char *msg)
+{
+    const char *p = msg;
+
+    pthread_mutex_lock(&lock);
+    published++;
+    too_long += strlen(msg) > payload_limit;
+    longest = strlen(msg) > longest ? strlen(msg) : longest;
+    while ((p = strstr(p, "\":{\"n\":")) != RT_NULL)
+    {
+        series_seen++;
+        p++;
+    }
+    pthread_mutex_unlock(&lock);
+
+    return RT_EOK;
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* every series has samples, so a flush publishes all of them */
+static int flush_wait(int count)
+{
+    int seen = 0;
+
+    bc28_aggr_flush();
+    for (int i = 0; i < FLUSH_TIMEOUT / 10; i++)
+    {
+        pthread_mutex_lock(&lock);
+        seen = series_seen;
+        pthread_mutex_unlock(&lock);
+        if (seen >= count)
+        {
+            break;
+        }
+        rt_thread_delay(10);
+    }
+
+    return seen;
+}
+
+int main(void)
+{
+    static const int counts[] = { 16, 256, PKG_USING_BC28_MQTT_AGGR_SERIES };
+    /* payload limits of the firmware transport, MQTT-SN and a small one */
+    static const struct { const char *name; rt_uint32_t slide; rt_uint8_t flags; rt_size_t limit; } mode[] = {
+        { "tumbling",    60000, BC28_AGGR_BASIC,                         1024 },
+        { "sliding",     10000, BC28_AGGR_BASIC,                         503  },
+        { "p50/p90/p99", 60000, BC28_AGGR_BASIC | BC28_AGGR_PERCENTILES, 128  },
+    };
+    static int handle[PKG_USING_BC28_MQTT_AGGR_SERIES];
+    char name[16];
+    rt_uint32_t x = 1;
+    double start = 0;
+
+    for (rt_size_t m = 0; m < sizeof(mode) / sizeof(mode[0]); m++)
+    {
+        for (rt_size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++)
+        {
+            int count = counts[c];
+
+            payload_limit = mode[m].limit;
+            for (int i = 0; i < count; i++)
+            {
+                snprintf(name, sizeof(name), "s%d", i);
+                handle[i] = bc28_aggr_create(name, 60000, mode[m].slide, mode[m].flags);
+                TEST_CHECK(handle[i] >= 0);
+            }
+
+            /* the same pseudo random samples for every run */
+            start = now_ns();
+            for (rt_uint32_t i = 0; i < SAMPLES; i++)
+            {
+                x = x * 1103515245 + 12345;
+                bc28_aggr_update(handle[i % count], (float)((x >> 16) & 0x3FF) / 10);
+            }
+            printf("%-12s %5d series  update %6.1f ns/sample", mode[m].name, count, (now_ns() - start) / SAMPLES);
+
+            pthread_mutex_lock(&lock);
+            published = series_seen = too_long = 0;
+            longest = 0;
+            pthread_mutex_unlock(&lock);
+
+            start = now_ns();
+            TEST_CHECK(flush_wait(count) == count);
+            printf("  flush %7.1f us, %4d messages, longest %u of %u bytes\n",
+                   (now_ns() - start) / 1000, published, (unsigned)longest, (unsigned)payload_limit);
+            TEST_CHECK(too_long == 0);
+
+            for (int i = 0; i < count; i++)
+            {
+                bc28_aggr_delete(handle[i]);
+            }
+        }
+    }
+
+    return test_report("bench_aggr");
+}
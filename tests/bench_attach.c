@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2023, RudyLo <luhuadong@163.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     agent        the first version
+ */
+
+/*
+ * Time from reset to the first publish: bc28_init(), bc28_client_attach()
+ * and bc28_build_mqtt_network(), which wait for the boot banner and the
+ * +CEREG report, against the fixed sleeps and polling they replaced, kept
+ * here as legacy_*(). Both run against the emulated module of
+ * tests/host/uart_host.c over a few registration delays, each run in a
+ * child process with a fresh module.
+ */
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <rtthread.h>
+#include <rtdevice.h>
+#include <at.h>
+
+#include "bc28_mqtt_internal.h"
+#include "test_host.h"
+#include "uart_host.h"
+
+#define BENCH_BOOT_MS                 800        /* inside the legacy 1 s, it had no check */
+#define BENCH_REPLY_MS                5
+#define BENCH_RECV_BUFF_LEN           256
+#define BENCH_TOPIC                   "pk/dn/user/update"
+#define BENCH_MSG                     "{\"seq\":0}"
+
+static const rt_uint32_t reg_delays[] = { 500, 1700, 3300 };
+
+/* the package's check_send_cmd() before the URC rework */
+static int legacy_cmd(const char *cmd, const char *expect, rt_size_t lines, rt_int32_t timeout)
+{
+    at_response_t resp = at_create_resp(BENCH_RECV_BUFF_LEN, lines, rt_tick_from_millisecond(timeout));
+    int result = at_exec_cmd(resp, "%s", cmd);
+
+    if (result == RT_EOK && expect && at_resp_get_line_by_kw(resp, expect) == RT_NULL)
+    {
+        result = -RT_ERROR;
+    }
+    at_delete_resp(resp);
+
+    return result;
+}
+
+static int legacy_init(void)
+{
+    at_client_init(PKG_USING_BC28_AT_CLIENT_DEV_NAME, BENCH_RECV_BUFF_LEN);
+
+    rt_pin_mode(PKG_USING_BC28_RESET_PIN, PIN_MODE_OUTPUT);
+    rt_pin_write(PKG_USING_BC28_RESET_PIN, PIN_HIGH);
+    rt_thread_mdelay(300);
+    rt_pin_write(PKG_USING_BC28_RESET_PIN, PIN_LOW);
+    rt_thread_mdelay(1000);
+
+    return RT_EOK;
+}
+
+static int legacy_attach(void)
+{
+    static const char *setup[] = {
+        "AT+CGSN=1", "AT+NBAND=8", "AT+CFUN=1", "AT+NSONMI=2", "AT+CEDRXS=0,5", "AT+CPSMS=0", "AT+CIMI",
+        "AT+CGATT=1",
+    };
+    int count = 60;
+
+    legacy_cmd("ATE0", "OK", 0, 5000);
+    if (legacy_cmd("AT+QREGSWT=2", "OK", 0, 5000) != RT_EOK ||
+        legacy_cmd("AT+NCONFIG=AUTOCONNECT,FALSE", "OK", 0, 5000) != RT_EOK)
+    {
+        return -RT_ERROR;
+    }
+
+    legacy_cmd("AT+NRB", "OK", 0, 10000);
+    while (legacy_cmd("AT", "OK", 0, 5000) != RT_EOK)
+    {
+        rt_thread_mdelay(1000);
+    }
+
+    for (rt_size_t i = 0; i < sizeof(setup) / sizeof(setup[0]); i++)
+    {
+        if (legacy_cmd(setup[i], "OK", 0, 5000) != RT_EOK)
+        {
+            return -RT_ERROR;
+        }
+    }
+
+    while (count > 0 && legacy_cmd("AT+CGATT?", "+CGATT:1", 0, 5000) != RT_EOK)
+    {
+        rt_thread_mdelay(1000);
+        count--;
+    }
+    legacy_cmd("AT+CGPADDR", RT_NULL, 0, 5000);
+
+    return count > 0 ? RT_EOK : -RT_ETIMEOUT;
+}
+
+static int legacy_publish(void)
+{
+    char cmd[AT_CMD_MAX_LEN];
+
+    if (legacy_cmd("AT+QMTCFG=\"keepalive\",0,60", "OK", 0, 5000) != RT_EOK ||
+        legacy_cmd("AT+QMTCFG=\"aliauth\",0,\"pk\",\"dn\",\"ds\"", "OK", 0, 5000) != RT_EOK ||
+        legacy_cmd("AT+QMTOPEN=0,\"pk.iot-as-mqtt.cn-shanghai.aliyuncs.com\",1883", "+QMTOPEN: 0,0", 4, 75000) != RT_EOK ||
+        legacy_cmd("AT+QMTCONN=0,\"860000000000001\"", "+QMTCONN: 0,0,0", 4, 10000) != RT_EOK)
+    {
+        return -RT_ERROR;
+    }
+
+    snprintf(cmd, sizeof(cmd), "AT+QMTPUB=0,0,0,0,\"%s\",%d", BENCH_TOPIC, (int)strlen(BENCH_MSG));
+    at_set_end_sign('>');
+    legacy_cmd(cmd, RT_NULL, 2, 5000);
+    at_set_end_sign(0);
+
+    return legacy_cmd(BENCH_MSG, "+QMTPUB: 0,0,0", 4, 5000);
+}
+
+static int urc_run(void)
+{
+    if (bc28_init() != RT_EOK || bc28_client_attach() != RT_EOK || bc28_build_mqtt_network() != RT_EOK)
+    {
+        return -RT_ERROR;
+    }
+
+    return bc28_mqtt_publish(BENCH_TOPIC, BENCH_MSG);
+}
+
+static int legacy_run(void)
+{
+    if (legacy_init() != RT_EOK || legacy_attach() != RT_EOK)
+    {
+        return -RT_ERROR;
+    }
+
+    return legacy_publish();
+}
+
+/* one run in a fresh process, returns the time to first publish in ms, <0 on failure */
+static int bench_run(int (*run)(void), rt_uint32_t reg_ms)
+{
+    struct uart_host_timing timing = { BENCH_BOOT_MS, reg_ms, BENCH_REPLY_MS };
+    int fds[2], status = 0, ms = -1;
+    pid_t pid;
+
+    if (pipe(fds) != 0 || (pid = fork()) < 0)
+    {
+        return -1;
+    }
+
+    if (pid == 0)
+    {
+        rt_tick_t start = 0;
+
+        close(fds[0]);
+        uart_host_init(&timing);
+
+        start = rt_tick_get();
+        ms = (run() == RT_EOK) ? (int)(rt_tick_get() - start) : -1;
+        write(fds[1], &ms, sizeof(ms));
+        _exit(0);
+    }
+
+    close(fds[1]);
+    if (read(fds[0], &ms, sizeof(ms)) != sizeof(ms))
+    {
+        ms = -1;
+    }
+    close(fds[0]);
+    waitpid(pid, &status, 0);
+
+    return ms;
+}
+
+int main(void)
+{
+    int legacy = 0, urc = 0;
+
+    printf("boot %u ms, reply %u ms\n", BENCH_BOOT_MS, BENCH_REPLY_MS);
+    printf("%8s %12s %12s %10s\n", "reg_ms", "legacy_ms", "urc_ms", "saved_ms");
+
+    for (rt_size_t i = 0; i < sizeof(reg_delays) / sizeof(reg_delays[0]); i++)
+    {
+        legacy = bench_run(legacy_run, reg_delays[i]);
+        urc    = bench_run(urc_run, reg_delays[i]);
+        printf("%8u %12d %12d %10d\n", reg_delays[i], legacy, urc, legacy - urc);
+
+        TEST_CHECK(legacy > 0);
+        TEST_CHECK(urc > 0);
+        TEST_CHECK(urc < legacy);
+    }
+
+    return test_report("bench_attach");
+}
@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2023, RudyLo <luhuadong@163.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     agent        the first version
+ * 2026-10-19     agent        the whole AT client, see at_client_host.c
+ */
+
+/* the RT-Thread AT client API the package uses */
+
+#ifndef __AT_H__
+#define __AT_H__
+
+#include <rtthread.h>
+
+#ifndef AT_CMD_MAX_LEN
+#define AT_CMD_MAX_LEN                128
+#endif
+#define AT_CLIENT_NUM_MAX             1
+
+#define AT_RESP_END_OK                "OK"
+#define AT_RESP_END_ERROR             "ERROR"
+#define AT_RESP_END_FAIL              "FAIL"
+
+enum at_status
+{
+    AT_STATUS_UNINITIALIZED = 0,
+    AT_STATUS_INITIALIZED,
+    AT_STATUS_CLI
+};
+typedef enum at_status at_status_t;
+
+enum at_resp_status
+{
+    AT_RESP_OK = 0,
+    AT_RESP_ERROR = -1,
+    AT_RESP_TIMEOUT = -2,
+    AT_RESP_BUFF_FULL = -3
+};
+typedef enum at_resp_status at_resp_status_t;
+
+struct at_response
+{
+    char       *buf;
+    rt_size_t   buf_size;
+    rt_size_t   buf_len;
+    rt_size_t   line_num;
+    rt_size_t   line_counts;
+    rt_int32_t  timeout;
+};
+typedef struct at_response *at_response_t;
+
+struct at_client;
+
+struct at_urc
+{
+    const char *cmd_prefix;
+    const char *cmd_suffix;
+    void (*func)(struct at_client *client, const char *data, rt_size_t size);
+};
+typedef struct at_urc *at_urc_t;
+
+struct at_urc_table
+{
+    rt_size_t             urc_size;
+    const struct at_urc  *urc;
+};
+typedef struct at_urc_table *at_urc_table_t;
+
+struct at_client
+{
+    rt_device_t         device;
+    at_status_t         status;
+    char                end_sign;
+
+    char               *recv_line_buf;
+    rt_size_t           recv_line_len;
+    rt_size_t           recv_bufsz;
+    rt_sem_t            rx_notice;
+    rt_mutex_t          lock;
+
+    at_response_t       resp;
+    rt_sem_t            resp_notice;
+    at_resp_status_t    resp_status;
+
+    struct at_urc_table *urc_table;
+    rt_size_t           urc_table_size;
+
+    rt_thread_t         parser;
+};
+typedef struct at_client *at_client_t;
+
+int           at_client_init(const char *dev_name, rt_size_t recv_bufsz);
+at_client_t   at_client_get(const char *dev_name);
+at_client_t   at_client_get_first(void);
+
+int           at_obj_exec_cmd(at_client_t client, at_response_t resp, const char *cmd_expr, ...);
+rt_size_t     at_client_obj_send(at_client_t client, const char *buf, rt_size_t size);
+rt_size_t     at_client_obj_recv(at_client_t client, char *buf, rt_size_t size, rt_int32_t timeout);
+void          at_obj_set_end_sign(at_client_t client, char ch);
+int           at_obj_set_urc_table(at_client_t client, const struct at_urc *urc_table, rt_size_t table_sz);
+
+at_response_t at_create_resp(rt_size_t buf_size, rt_size_t line_num, rt_int32_t timeout);
+void          at_delete_resp(at_response_t resp);
+const char   *at_resp_get_line(at_response_t resp, rt_size_t resp_line);
+const char   *at_resp_get_line_by_kw(at_response_t resp, const char *keyword);
+int           at_resp_parse_line_args(at_response_t resp, rt_size_t resp_line, const char *resp_expr, ...);
+int           at_resp_parse_line_args_by_kw(at_response_t resp, const char *keyword, const char *resp_expr, ...);
+
+/* the single client API */
+#define at_exec_cmd(resp, ...)        at_obj_exec_cmd(at_client_get_first(), resp, __VA_ARGS__)
+#define at_client_send(buf, size)     at_client_obj_send(at_client_get_first(), buf, size)
+#define at_client_recv(buf, size, timeout) at_client_obj_recv(at_client_get_first(), buf, size, timeout)
+#define at_set_end_sign(ch)           at_obj_set_end_sign(at_client_get_first(), ch)
+#define at_set_urc_table(urc_table, table_sz) at_obj_set_urc_table(at_client_get_first(), urc_table, table_sz)
+
+#endif /* __AT_H__ */
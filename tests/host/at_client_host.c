@@ -0,0 +1,497 @@
+/*
+ * Copyright (c) 2023, RudyLo <luhuadong@163.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     agent        the first version
+ */
+
+/*
+ * The RT-Thread AT client on the host, following components/net/at/src/
+ * at_client.c: one parser thread reads the device a byte at a time, a line
+ * that matches a URC goes to its handler, any other line goes to the
+ * response being waited for. A line longer than the receive buffer is
+ * dropped, like on the target.
+ */
+
+#include <rtthread.h>
+#include <at.h>
+
+#define DBG_TAG                       "at.clnt"
+#define DBG_LVL                       DBG_WARNING
+#include <rtdbg.h>
+
+#define AT_CLIENT_THREAD_STACK        2048
+#define AT_CLIENT_THREAD_PRIORITY     (RT_THREAD_PRIORITY_MAX / 3 - 1)
+
+static struct at_client at_client_table[AT_CLIENT_NUM_MAX];
+static char send_buf[AT_CMD_MAX_LEN];
+static rt_size_t last_cmd_len;
+
+/* responses, lines are kept NUL separated */
+
+at_response_t at_create_resp(rt_size_t buf_size, rt_size_t line_num, rt_int32_t timeout)
+{
+    at_response_t resp = calloc(1, sizeof(*resp));
+
+    if (resp == RT_NULL)
+    {
+        return RT_NULL;
+    }
+
+    resp->buf = calloc(1, buf_size);
+    if (resp->buf == RT_NULL)
+    {
+        free(resp);
+        return RT_NULL;
+    }
+    resp->buf_size = buf_size;
+    resp->line_num = line_num;
+    resp->timeout = timeout;
+
+    return resp;
+}
+
+void at_delete_resp(at_response_t resp)
+{
+    if (resp)
+    {
+        free(resp->buf);
+        free(resp);
+    }
+}
+
+const char *at_resp_get_line(at_response_t resp, rt_size_t resp_line)
+{
+    char *line = resp->buf;
+
+    if (resp_line == 0 || resp_line > resp->line_counts)
+    {
+        return RT_NULL;
+    }
+    for (rt_size_t i = 1; i < resp_line; i++)
+    {
+        line += strlen(line) + 1;
+    }
+
+    return line;
+}
+
+const char *at_resp_get_line_by_kw(at_response_t resp, const char *keyword)
+{
+    for (rt_size_t i = 1; i <= resp->line_counts; i++)
+    {
+        const char *line = at_resp_get_line(resp, i);
+        if (strstr(line, keyword))
+        {
+            return line;
+        }
+    }
+
+    return RT_NULL;
+}
+
+int at_resp_parse_line_args(at_response_t resp, rt_size_t resp_line, const char *resp_expr, ...)
+{
+    const char *line = at_resp_get_line(resp, resp_line);
+    va_list args;
+    int n = -1;
+
+    if (line)
+    {
+        va_start(args, resp_expr);
+        n = vsscanf(line, resp_expr, args);
+        va_end(args);
+    }
+
+    return n;
+}
+
+int at_resp_parse_line_args_by_kw(at_response_t resp, const char *keyword, const char *resp_expr, ...)
+{
+    const char *line = at_resp_get_line_by_kw(resp, keyword);
+    va_list args;
+    int n = -1;
+
+    if (line)
+    {
+        va_start(args, resp_expr);
+        n = vsscanf(line, resp_expr, args);
+        va_end(args);
+    }
+
+    return n;
+}
+
+/* sending */
+
+static void at_vprintfln(rt_device_t device, const char *format, va_list args)
+{
+    last_cmd_len = vsnprintf(send_buf, sizeof(send_buf), format, args);
+    if (last_cmd_len > sizeof(send_buf))
+    {
+        last_cmd_len = sizeof(send_buf);
+    }
+
+    rt_device_write(device, 0, send_buf, last_cmd_len);
+    rt_device_write(device, 0, "\r\n", 2);
+}
+
+int at_obj_exec_cmd(at_client_t client, at_response_t resp, const char *cmd_expr, ...)
+{
+    va_list args;
+    rt_err_t result = RT_EOK;
+
+    if (client == RT_NULL)
+    {
+        LOG_E("input AT Client object is NULL, please create or get AT Client object!");
+        return -RT_ERROR;
+    }
+
+    rt_mutex_take(client->lock, RT_WAITING_FOREVER);
+
+    client->resp_status = AT_RESP_OK;
+    client->resp = resp;
+    if (resp != RT_NULL)
+    {
+        resp->buf_len = 0;
+        resp->line_counts = 0;
+    }
+
+    va_start(args, cmd_expr);
+    at_vprintfln(client->device, cmd_expr, args);
+    va_end(args);
+
+    if (resp != RT_NULL)
+    {
+        if (rt_sem_take(client->resp_notice, resp->timeout) != RT_EOK)
+        {
+            LOG_W("execute command (%.*s) timeout (%d ticks)!", (int)last_cmd_len, send_buf, resp->timeout);
+            client->resp_status = AT_RESP_TIMEOUT;
+            result = -RT_ETIMEOUT;
+        }
+        else if (client->resp_status != AT_RESP_OK)
+        {
+            LOG_D("execute command (%.*s) failed!", (int)last_cmd_len, send_buf);
+            result = -RT_ERROR;
+        }
+    }
+
+    client->resp = RT_NULL;
+    rt_mutex_release(client->lock);
+
+    return result;
+}
+
+rt_size_t at_client_obj_send(at_client_t client, const char *buf, rt_size_t size)
+{
+    rt_size_t len = 0;
+
+    if (client == RT_NULL)
+    {
+        return 0;
+    }
+
+    rt_mutex_take(client->lock, RT_WAITING_FOREVER);
+    len = rt_device_write(client->device, 0, buf, size);
+    rt_mutex_release(client->lock);
+
+    return len;
+}
+
+/* receiving */
+
+static rt_err_t at_client_getchar(at_client_t client, char *ch, rt_int32_t timeout)
+{
+    rt_err_t result = RT_EOK;
+
+    while (rt_device_read(client->device, 0, ch, 1) == 0)
+    {
+        result = rt_sem_take(client->rx_notice, rt_tick_from_millisecond(timeout));
+        if (result != RT_EOK)
+        {
+            return result;
+        }
+        rt_sem_control(client->rx_notice, RT_IPC_CMD_RESET, RT_NULL);
+    }
+
+    return RT_EOK;
+}
+
+rt_size_t at_client_obj_recv(at_client_t client, char *buf, rt_size_t size, rt_int32_t timeout)
+{
+    rt_size_t len = 0, read_len = 0;
+
+    if (client == RT_NULL)
+    {
+        return 0;
+    }
+
+    while (size)
+    {
+        rt_sem_control(client->rx_notice, RT_IPC_CMD_RESET, RT_NULL);
+
+        read_len = rt_device_read(client->device, 0, buf + len, size);
+        if (read_len > 0)
+        {
+            len += read_len;
+            size -= read_len;
+            continue;
+        }
+
+        if (rt_sem_take(client->rx_notice, timeout) != RT_EOK)
+        {
+            break;
+        }
+    }
+
+    return len;
+}
+
+void at_obj_set_end_sign(at_client_t client, char ch)
+{
+    if (client)
+    {
+        client->end_sign = ch;
+    }
+}
+
+int at_obj_set_urc_table(at_client_t client, const struct at_urc *urc_table, rt_size_t table_sz)
+{
+    struct at_urc_table *tables = RT_NULL;
+
+    if (client == RT_NULL)
+    {
+        return -RT_ERROR;
+    }
+
+    tables = realloc(client->urc_table, (client->urc_table_size + 1) * sizeof(*tables));
+    if (tables == RT_NULL)
+    {
+        return -RT_ENOMEM;
+    }
+    tables[client->urc_table_size].urc = urc_table;
+    tables[client->urc_table_size].urc_size = table_sz;
+    client->urc_table = tables;
+    client->urc_table_size++;
+
+    return RT_EOK;
+}
+
+static const struct at_urc *get_urc_obj(at_client_t client)
+{
+    const char *buffer = client->recv_line_buf;
+    rt_size_t buf_sz = client->recv_line_len, prefix_len = 0, suffix_len = 0;
+
+    for (rt_size_t i = 0; i < client->urc_table_size; i++)
+    {
+        for (rt_size_t j = 0; j < client->urc_table[i].urc_size; j++)
+        {
+            const struct at_urc *urc = &client->urc_table[i].urc[j];
+
+            prefix_len = strlen(urc->cmd_prefix);
+            suffix_len = strlen(urc->cmd_suffix);
+            if (buf_sz < prefix_len + suffix_len)
+            {
+                continue;
+            }
+            if ((prefix_len ? !strncmp(buffer, urc->cmd_prefix, prefix_len) : 1) &&
+                (suffix_len ? !strncmp(buffer + buf_sz - suffix_len, urc->cmd_suffix, suffix_len) : 1))
+            {
+                return urc;
+            }
+        }
+    }
+
+    return RT_NULL;
+}
+
+static int at_recv_readline(at_client_t client)
+{
+    rt_size_t read_len = 0;
+    char ch = 0, last_ch = 0;
+    rt_bool_t is_full = RT_FALSE;
+
+    memset(client->recv_line_buf, 0x00, client->recv_bufsz);
+    client->recv_line_len = 0;
+
+    while (1)
+    {
+        at_client_getchar(client, &ch, RT_WAITING_FOREVER);
+
+        if (read_len < client->recv_bufsz)
+        {
+            client->recv_line_buf[read_len++] = ch;
+            client->recv_line_len = read_len;
+        }
+        else
+        {
+            is_full = RT_TRUE;
+        }
+
+        /* is newline or URC data */
+        if ((ch == '\n' && last_ch == '\r') || (client->end_sign != 0 && ch == client->end_sign) ||
+            get_urc_obj(client))
+        {
+            if (is_full)
+            {
+                LOG_E("read line failed. The line data length is out of buffer size(%d)!", (int)client->recv_bufsz);
+                memset(client->recv_line_buf, 0x00, client->recv_bufsz);
+                client->recv_line_len = 0;
+                return -RT_EFULL;
+            }
+            break;
+        }
+        last_ch = ch;
+    }
+
+    return read_len;
+}
+
+static void client_parser(void *parameter)
+{
+    at_client_t client = parameter;
+    const struct at_urc *urc = RT_NULL;
+
+    while (1)
+    {
+        if (at_recv_readline(client) <= 0)
+        {
+            continue;
+        }
+
+        if ((urc = get_urc_obj(client)) != RT_NULL)
+        {
+            if (urc->func)
+            {
+                urc->func(client, client->recv_line_buf, client->recv_line_len);
+            }
+        }
+        else if (client->resp != RT_NULL)
+        {
+            at_response_t resp = client->resp;
+            char end_ch = client->recv_line_buf[client->recv_line_len - 1];
+
+            /* current receive is response */
+            client->recv_line_buf[client->recv_line_len - 1] = '\0';
+            if (resp->buf_len + client->recv_line_len < resp->buf_size)
+            {
+                memcpy(resp->buf + resp->buf_len, client->recv_line_buf, client->recv_line_len);
+                resp->buf_len += client->recv_line_len;
+                resp->line_counts++;
+            }
+            else
+            {
+                client->resp_status = AT_RESP_BUFF_FULL;
+                LOG_E("Read response buffer failed. The Response buffer size is out of buffer size(%d)!",
+                      (int)resp->buf_size);
+            }
+
+            /* check response result */
+            if (client->end_sign != 0 && end_ch == client->end_sign && resp->line_num == 0)
+            {
+                client->resp_status = AT_RESP_OK;
+            }
+            else if (memcmp(client->recv_line_buf, AT_RESP_END_OK, strlen(AT_RESP_END_OK)) == 0 &&
+                     resp->line_num == 0)
+            {
+                client->resp_status = AT_RESP_OK;
+            }
+            else if (strstr(client->recv_line_buf, AT_RESP_END_ERROR) ||
+                     memcmp(client->recv_line_buf, AT_RESP_END_FAIL, strlen(AT_RESP_END_FAIL)) == 0)
+            {
+                client->resp_status = AT_RESP_ERROR;
+            }
+            else if (resp->line_counts == resp->line_num && resp->line_num)
+            {
+                client->resp_status = AT_RESP_OK;
+            }
+            else
+            {
+                continue;
+            }
+
+            client->resp = RT_NULL;
+            rt_sem_release(client->resp_notice);
+        }
+        else
+        {
+            LOG_D("unrecognized line: %.*s", (int)client->recv_line_len, client->recv_line_buf);
+        }
+    }
+}
+
+static rt_err_t at_client_rx_ind(rt_device_t dev, rt_size_t size)
+{
+    for (int idx = 0; idx < AT_CLIENT_NUM_MAX; idx++)
+    {
+        if (at_client_table[idx].device == dev && size > 0)
+        {
+            rt_sem_release(at_client_table[idx].rx_notice);
+        }
+    }
+
+    return RT_EOK;
+}
+
+int at_client_init(const char *dev_name, rt_size_t recv_bufsz)
+{
+    at_client_t client = RT_NULL;
+    int idx = 0;
+
+    for (idx = 0; idx < AT_CLIENT_NUM_MAX && at_client_table[idx].device; idx++);
+    if (idx >= AT_CLIENT_NUM_MAX)
+    {
+        LOG_E("AT client initialize failed! Check the maximum number(%d) of AT client.", AT_CLIENT_NUM_MAX);
+        return -RT_EFULL;
+    }
+
+    client = &at_client_table[idx];
+    client->device = rt_device_find(dev_name);
+    if (client->device == RT_NULL)
+    {
+        LOG_E("AT client initialize failed! Not find the device(%s).", dev_name);
+        return -RT_ERROR;
+    }
+
+    client->recv_bufsz = recv_bufsz;
+    client->recv_line_buf = calloc(1, recv_bufsz);
+    client->lock = rt_mutex_create("at_c", RT_IPC_FLAG_PRIO);
+    client->rx_notice = rt_sem_create("at_cr", 0, RT_IPC_FLAG_FIFO);
+    client->resp_notice = rt_sem_create("at_cei", 0, RT_IPC_FLAG_FIFO);
+    client->parser = rt_thread_create("at_clnp0", client_parser, client,
+                                      AT_CLIENT_THREAD_STACK, AT_CLIENT_THREAD_PRIORITY, 5);
+    if (client->recv_line_buf == RT_NULL || client->parser == RT_NULL)
+    {
+        client->device = RT_NULL;
+        return -RT_ENOMEM;
+    }
+
+    rt_device_open(client->device, RT_DEVICE_OFLAG_RDWR | RT_DEVICE_FLAG_INT_RX);
+    rt_device_set_rx_indicate(client->device, at_client_rx_ind);
+
+    client->status = AT_STATUS_INITIALIZED;
+    rt_thread_startup(client->parser);
+
+    return RT_EOK;
+}
+
+at_client_t at_client_get(const char *dev_name)
+{
+    for (int idx = 0; idx < AT_CLIENT_NUM_MAX; idx++)
+    {
+        if (at_client_table[idx].device && strncmp(at_client_table[idx].device->name, dev_name, RT_NAME_MAX) == 0)
+        {
+            return &at_client_table[idx];
+        }
+    }
+
+    return RT_NULL;
+}
+
+at_client_t at_client_get_first(void)
+{
+    return at_client_table[0].device ? &at_client_table[0] : RT_NULL;
+}
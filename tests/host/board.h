@@ -0,0 +1,18 @@
+/*
+ * Copyright (c) 2023, RudyLo <luhuadong@163.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     agent        the first version
+ */
+
+/* no board on the host, the pins are in rtconfig.h */
+
+#ifndef __BOARD_H__
+#define __BOARD_H__
+
+#include <rtdevice.h>
+
+#endif /* __BOARD_H__ */
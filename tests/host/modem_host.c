@@ -0,0 +1,399 @@
+/*
+ * Copyright (c) 2023, RudyLo <luhuadong@163.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     agent        the first version
+ */
+
+/*
+ * Emulated BC28 for host tests. The socket commands (AT+NSOCR, AT+NSOST,
+ * AT+NSOCO, AT+NSOSD, AT+NSOCL) are served with host sockets, received
+ * data comes back as "+NSONMI" lines through bc28_socket_urc_recv() on a
+ * parser thread of its own, like the AT client does on the target. A line
+ * longer than AT_CLIENT_RECV_BUFF_LEN is dropped, as the AT client does.
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <rtthread.h>
+#include <at.h>
+
+#include "bc28_mqtt_internal.h"
+#include "modem_host.h"
+
+#define MODEM_LINE_MAX                2048
+#define MODEM_SOCKET_MAX              7
+
+static struct bc28_device device = {
+    .imei = "860000000000001",
+};
+
+static struct at_client client;
+static struct rt_mutex cmd_lock;
+
+static int sockets[MODEM_SOCKET_MAX];
+static pthread_mutex_t sockets_lock = PTHREAD_MUTEX_INITIALIZER;
+static rt_size_t longest;
+static volatile int dropped;
+static volatile int recovers;
+
+bc28_device_t bc28_get_device(void)
+{
+    return &device;
+}
+
+/* the transports report a lost link here, the tests count the calls */
+void bc28_recover(rt_uint8_t what)
+{
+    if (what & BC28_RECOVER_LINK)
+    {
+        recovers++;
+    }
+    device.stat = BC28_STAT_DISCONNECTED;
+}
+
+/* replies go straight into the response, see at_client_host.c for the helpers */
+
+static void resp_add_line(at_response_t resp, const char *fmt, ...)
+{
+    va_list args;
+    int n = 0;
+
+    if (resp == RT_NULL || resp->buf_len >= resp->buf_size)
+    {
+        return;
+    }
+
+    va_start(args, fmt);
+    n = vsnprintf(resp->buf + resp->buf_len, resp->buf_size - resp->buf_len, fmt, args);
+    va_end(args);
+
+    if (n < 0 || (rt_size_t)n >= resp->buf_size - resp->buf_len)
+    {
+        return;
+    }
+    resp->buf_len += n + 1;
+    resp->line_counts++;
+}
+
+/* the module side of the socket commands */
+
+static int hex_value(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+/* a length that disagrees with the hex data is an error, as on the module */
+static int hex_payload(const char *hex, unsigned len, rt_uint8_t *data)
+{
+    if (strlen(hex) != len * 2)
+    {
+        return -1;
+    }
+    for (unsigned i = 0; i < len; i++)
+    {
+        int hi = hex_value(hex[i * 2]), lo = hex_value(hex[i * 2 + 1]);
+        if (hi < 0 || lo < 0)
+        {
+            return -1;
+        }
+        data[i] = (rt_uint8_t)(hi << 4 | lo);
+    }
+
+    return 0;
+}
+
+static int socket_fd(int socket)
+{
+    int fd = -1;
+
+    pthread_mutex_lock(&sockets_lock);
+    if (socket >= 0 && socket < MODEM_SOCKET_MAX)
+    {
+        fd = sockets[socket] - 1;
+    }
+    pthread_mutex_unlock(&sockets_lock);
+
+    return fd;
+}
+
+static struct sockaddr_in socket_addr(const char *ip, unsigned port)
+{
+    struct sockaddr_in addr;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    inet_pton(AF_INET, ip, &addr.sin_addr);
+
+    return addr;
+}
+
+static int modem_command(at_response_t resp, char *line)
+{
+    rt_uint8_t data[BC28_SOCKET_PAYLOAD_MAX];
+    char type[8], ip[32], hex[BC28_SOCKET_PAYLOAD_MAX * 2 + 1];
+    unsigned port = 0, len = 0;
+    int id = 0, fd = 0, n = 0;
+    struct sockaddr_in addr;
+
+    if (strlen(line) > longest)
+    {
+        longest = strlen(line);
+    }
+
+    if (resp)
+    {
+        resp->buf_len = resp->line_counts = 0;
+    }
+
+    if (sscanf(line, "AT+NSOCR=%7[^,],%*d,%u,1", type, &port) == 2)
+    {
+        fd = socket(AF_INET, strcmp(type, "STREAM") == 0 ? SOCK_STREAM : SOCK_DGRAM, 0);
+        if (port)
+        {
+            addr = socket_addr("127.0.0.1", port);
+            bind(fd, (struct sockaddr *)&addr, sizeof(addr));
+        }
+
+        pthread_mutex_lock(&sockets_lock);
+        for (id = 0; id < MODEM_SOCKET_MAX && sockets[id]; id++);
+        if (id < MODEM_SOCKET_MAX)
+        {
+            sockets[id] = fd + 1;
+        }
+        pthread_mutex_unlock(&sockets_lock);
+
+        if (id == MODEM_SOCKET_MAX)
+        {
+            close(fd);
+            resp_add_line(resp, "ERROR");
+            return -RT_ERROR;
+        }
+        resp_add_line(resp, "%d", id);
+    }
+    else if (sscanf(line, "AT+NSOST=%d,%31[^,],%u,%u,%1024s", &id, ip, &port, &len, hex) == 5)
+    {
+        fd = socket_fd(id);
+        addr = socket_addr(ip, port);
+        if (fd < 0 || len > sizeof(data) || hex_payload(hex, len, data) != 0 ||
+            sendto(fd, data, len, 0, (struct sockaddr *)&addr, sizeof(addr)) != (ssize_t)len)
+        {
+            resp_add_line(resp, "ERROR");
+            return -RT_ERROR;
+        }
+        resp_add_line(resp, "%d,%u", id, len);
+    }
+    else if (sscanf(line, "AT+NSOCO=%d,%31[^,],%u", &id, ip, &port) == 3)
+    {
+        fd = socket_fd(id);
+        addr = socket_addr(ip, port);
+        if (fd < 0 || connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+        {
+            resp_add_line(resp, "ERROR");
+            return -RT_ERROR;
+        }
+    }
+    else if (sscanf(line, "AT+NSOSD=%d,%u,%1024s", &id, &len, hex) == 3)
+    {
+        fd = socket_fd(id);
+        if (fd < 0 || len > sizeof(data) || hex_payload(hex, len, data) != 0 ||
+            send(fd, data, len, MSG_NOSIGNAL) != (ssize_t)len)
+        {
+            resp_add_line(resp, "ERROR");
+            return -RT_ERROR;
+        }
+        resp_add_line(resp, "%d,%u", id, len);
+    }
+    else if (sscanf(line, "AT+NSOCL=%d", &id) == 1)
+    {
+        pthread_mutex_lock(&sockets_lock);
+        n = (id >= 0 && id < MODEM_SOCKET_MAX) ? sockets[id] : 0;
+        if (n)
+        {
+            sockets[id] = 0;
+            shutdown(n - 1, SHUT_RDWR);
+            close(n - 1);
+        }
+        pthread_mutex_unlock(&sockets_lock);
+    }
+    else
+    {
+        /* anything else is accepted, the tests only need the socket service */
+    }
+
+    resp_add_line(resp, "OK");
+    return RT_EOK;
+}
+
+/* the package's command path, served by the emulated module */
+
+int bc28_exec_vcmd(at_response_t resp, const char *cmd_expr, va_list args)
+{
+    char line[MODEM_LINE_MAX];
+    int result = 0;
+
+    rt_mutex_take(&cmd_lock, RT_WAITING_FOREVER);
+    vsnprintf(line, sizeof(line), cmd_expr, args);
+    result = modem_command(resp, line);
+    rt_mutex_release(&cmd_lock);
+
+    return result;
+}
+
+int bc28_exec_cmd(at_response_t resp, const char *cmd_expr, ...)
+{
+    va_list args;
+    int result = 0;
+
+    va_start(args, cmd_expr);
+    result = bc28_exec_vcmd(resp, cmd_expr, args);
+    va_end(args);
+
+    return result;
+}
+
+/* same contract as the target: pieces of at most AT_CMD_MAX_LEN bytes */
+int bc28_exec_long(at_response_t resp, bc28_cmd_body_t body, void *arg, const char *head_expr, ...)
+{
+    char line[MODEM_LINE_MAX], piece[AT_CMD_MAX_LEN];
+    rt_size_t len = 0, n = 0;
+    va_list args;
+    int result = 0;
+
+    rt_mutex_take(&cmd_lock, RT_WAITING_FOREVER);
+
+    va_start(args, head_expr);
+    len = vsnprintf(line, sizeof(line), head_expr, args);
+    va_end(args);
+
+    while ((n = body(piece, sizeof(piece), arg)) > 0)
+    {
+        assert(n < sizeof(piece));
+        if (len + n < sizeof(line))
+        {
+            memcpy(line + len, piece, n);
+            len += n;
+        }
+    }
+    line[len] = '\0';
+
+    result = modem_command(resp, line);
+    rt_mutex_release(&cmd_lock);
+
+    return result;
+}
+
+/* parser thread: socket data and peer closes become URCs */
+
+static void *modem_parser(void *arg)
+{
+    static char line[32 + BC28_SOCKET_PAYLOAD_MAX * 2 + 2];
+    rt_uint8_t data[BC28_SOCKET_PAYLOAD_MAX];           /* the module reports at most this per URC */
+    struct pollfd fds[MODEM_SOCKET_MAX];
+    struct sockaddr_in from;
+    socklen_t from_len;
+    int ids[MODEM_SOCKET_MAX];
+    int count = 0, n = 0, len = 0;
+
+    while (1)
+    {
+        pthread_mutex_lock(&sockets_lock);
+        for (count = 0, n = 0; n < MODEM_SOCKET_MAX; n++)
+        {
+            if (sockets[n])
+            {
+                fds[count].fd = sockets[n] - 1;
+                fds[count].events = POLLIN;
+                ids[count++] = n;
+            }
+        }
+        pthread_mutex_unlock(&sockets_lock);
+
+        if (poll(fds, count, 10) <= 0)
+        {
+            continue;
+        }
+
+        for (int i = 0; i < count; i++)
+        {
+            if (!(fds[i].revents & (POLLIN | POLLHUP | POLLERR)) || socket_fd(ids[i]) != fds[i].fd)
+            {
+                continue;
+            }
+
+            from_len = sizeof(from);
+            memset(&from, 0, sizeof(from));
+            len = recvfrom(fds[i].fd, data, sizeof(data), MSG_DONTWAIT, (struct sockaddr *)&from, &from_len);
+            if (len > 0)
+            {
+                n = snprintf(line, sizeof(line), "+NSONMI:%d,%s,%u,%d,", ids[i],
+                             inet_ntoa(from.sin_addr), ntohs(from.sin_port), len);
+                for (int k = 0; k < len; k++)
+                {
+                    n += sprintf(line + n, "%02X", data[k]);
+                }
+                n += sprintf(line + n, "\r\n");
+
+                /* the AT client drops a line longer than its buffer */
+                if (n > AT_CLIENT_RECV_BUFF_LEN)
+                {
+                    dropped++;
+                    continue;
+                }
+                bc28_socket_urc_recv(&client, line, n);
+            }
+            else if (len == 0)
+            {
+                /* stream closed by the peer */
+                pthread_mutex_lock(&sockets_lock);
+                sockets[ids[i]] = 0;
+                pthread_mutex_unlock(&sockets_lock);
+                close(fds[i].fd);
+
+                n = snprintf(line, sizeof(line), "+NSOCLI: %d\r\n", ids[i]);
+                bc28_socket_urc_close(&client, line, n);
+            }
+        }
+    }
+
+    return NULL;
+}
+
+void modem_host_init(void)
+{
+    pthread_t tid;
+
+    rt_mutex_init(&cmd_lock, "bc28cmd", RT_IPC_FLAG_PRIO);
+    client.lock = rt_mutex_create("at", RT_IPC_FLAG_PRIO);
+    device.client = &client;
+
+    pthread_create(&tid, NULL, modem_parser, NULL);
+    pthread_detach(tid);
+}
+
+rt_size_t modem_host_longest_cmd(void)
+{
+    return longest;
+}
+
+int modem_host_recover_count(void)
+{
+    return recovers;
+}
+
+int modem_host_dropped_urcs(void)
+{
+    return dropped;
+}
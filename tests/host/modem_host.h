@@ -0,0 +1,28 @@
+/*
+ * Copyright (c) 2023, RudyLo <luhuadong@163.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     agent        the first version
+ */
+
+#ifndef __MODEM_HOST_H__
+#define __MODEM_HOST_H__
+
+#include <rtthread.h>
+
+/* start the emulated module, before any package call */
+void      modem_host_init(void);
+
+/* longest command line the module has seen, head and payload */
+rt_size_t modem_host_longest_cmd(void);
+
+/* link recoveries the transports have asked for */
+int       modem_host_recover_count(void);
+
+/* received data URCs dropped for not fitting the AT client line buffer */
+int       modem_host_dropped_urcs(void);
+
+#endif /* __MODEM_HOST_H__ */
@@ -0,0 +1,27 @@
+/*
+ * Copyright (c) 2023, RudyLo <luhuadong@163.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     agent        the first version
+ */
+
+/* features under test are selected with -D by tests/run.sh */
+
+#ifndef __RTCONFIG_H__
+#define __RTCONFIG_H__
+
+#define PKG_USING_BC28_MQTT
+#define PKG_USING_BC28_MQTT_KEEP_ALIVE           60
+#define PKG_USING_BC28_MQTT_PRODUCT_KEY          "pk"
+#define PKG_USING_BC28_MQTT_DEVICE_NAME          "dn"
+#define PKG_USING_BC28_MQTT_DEVICE_SECRET        "ds"
+#define PKG_USING_BC28_AT_CLIENT_DEV_NAME        "uart2"
+#define PKG_USING_BC28_MQTT_BAUD_RATE            9600
+#define PKG_USING_BC28_MQTT_OP_BAND              8
+#define PKG_USING_BC28_RESET_PIN                 10
+#define PKG_USING_BC28_ADC0_PIN                  11
+
+#endif /* __RTCONFIG_H__ */
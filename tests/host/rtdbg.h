@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2023, RudyLo <luhuadong@163.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     agent        the first version
+ */
+
+/* log to stderr, set BC28_TEST_VERBOSE to see debug output */
+
+#ifndef DBG_ERROR
+#define DBG_ERROR                     3
+#define DBG_WARNING                   4
+#define DBG_INFO                      6
+#define DBG_LOG                       7
+#endif
+
+#ifndef DBG_LVL
+#define DBG_LVL                       DBG_WARNING
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#undef LOG_D
+#undef LOG_I
+#undef LOG_W
+#undef LOG_E
+
+#define BC28_HOST_LOG(lvl, tag, fmt, ...)                                         \
+    do                                                                            \
+    {                                                                             \
+        if (DBG_LVL >= (lvl) && ((lvl) <= DBG_WARNING || getenv("BC28_TEST_VERBOSE"))) \
+        {                                                                         \
+            fprintf(stderr, "[" tag "] [%s] " fmt "\n", DBG_TAG, ##__VA_ARGS__);  \
+        }                                                                         \
+    } while (0)
+
+#define LOG_D(fmt, ...)               BC28_HOST_LOG(DBG_LOG, "D", fmt, ##__VA_ARGS__)
+#define LOG_I(fmt, ...)               BC28_HOST_LOG(DBG_INFO, "I", fmt, ##__VA_ARGS__)
+#define LOG_W(fmt, ...)               BC28_HOST_LOG(DBG_WARNING, "W", fmt, ##__VA_ARGS__)
+#define LOG_E(fmt, ...)               BC28_HOST_LOG(DBG_ERROR, "E", fmt, ##__VA_ARGS__)
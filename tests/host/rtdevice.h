@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2023, RudyLo <luhuadong@163.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     agent        the first version
+ */
+
+#ifndef __RT_DEVICE_H__
+#define __RT_DEVICE_H__
+
+#include <rtthread.h>
+
+struct rt_ringbuffer
+{
+    rt_uint8_t *buffer_ptr;
+    rt_size_t   read_index;
+    rt_size_t   write_index;
+    rt_size_t   buffer_size;
+    rt_size_t   data_len;
+};
+
+void      rt_ringbuffer_init(struct rt_ringbuffer *rb, rt_uint8_t *pool, rt_int16_t size);
+void      rt_ringbuffer_reset(struct rt_ringbuffer *rb);
+rt_size_t rt_ringbuffer_put(struct rt_ringbuffer *rb, const rt_uint8_t *ptr, rt_uint16_t length);
+rt_size_t rt_ringbuffer_get(struct rt_ringbuffer *rb, rt_uint8_t *ptr, rt_uint16_t length);
+rt_size_t rt_ringbuffer_data_len(struct rt_ringbuffer *rb);
+
+#define rt_ringbuffer_space_len(rb)   ((rb)->buffer_size - rt_ringbuffer_data_len(rb))
+
+/* serial: the configuration is accepted and ignored */
+
+#define DATA_BITS_8                   8
+#define STOP_BITS_1                   0
+#define PARITY_NONE                   0
+#define RT_SERIAL_RB_BUFSZ            64
+
+struct serial_configure
+{
+    rt_uint32_t baud_rate;
+    rt_uint32_t data_bits;
+    rt_uint32_t stop_bits;
+    rt_uint32_t parity;
+    rt_uint32_t bufsz;
+};
+
+#define RT_SERIAL_CONFIG_DEFAULT      { 115200, DATA_BITS_8, STOP_BITS_1, PARITY_NONE, RT_SERIAL_RB_BUFSZ }
+
+/* pins: outputs only, a watcher sees every write */
+
+#define PIN_LOW                       0
+#define PIN_HIGH                      1
+#define PIN_MODE_OUTPUT               0
+#define PIN_MODE_INPUT                1
+
+void rt_pin_mode(rt_base_t pin, rt_uint8_t mode);
+void rt_pin_write(rt_base_t pin, rt_uint8_t value);
+int  rt_pin_read(rt_base_t pin);
+void rt_pin_host_watch(void (*watch)(rt_base_t pin, rt_uint8_t value));
+
+#endif /* __RT_DEVICE_H__ */
@@ -0,0 +1,20 @@
+/*
+ * Copyright (c) 2023, RudyLo <luhuadong@163.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     agent        the first version
+ */
+
+#ifndef __RT_HW_H__
+#define __RT_HW_H__
+
+#include <rtthread.h>
+
+/* one big lock stands in for disabled interrupts */
+rt_base_t rt_hw_interrupt_disable(void);
+void      rt_hw_interrupt_enable(rt_base_t level);
+
+#endif /* __RT_HW_H__ */
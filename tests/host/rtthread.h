@@ -0,0 +1,231 @@
+/*
+ * Copyright (c) 2023, RudyLo <luhuadong@163.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     agent        the first version
+ */
+
+/*
+ * Minimal RT-Thread kernel API on POSIX threads, just enough to run the
+ * package sources on the host. Ticks are milliseconds.
+ */
+
+#ifndef __RT_THREAD_H__
+#define __RT_THREAD_H__
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+
+#include <rtconfig.h>
+
+typedef int8_t                        rt_int8_t;
+typedef int16_t                       rt_int16_t;
+typedef int32_t                       rt_int32_t;
+typedef int64_t                       rt_int64_t;
+typedef uint8_t                       rt_uint8_t;
+typedef uint16_t                      rt_uint16_t;
+typedef uint32_t                      rt_uint32_t;
+typedef uint64_t                      rt_uint64_t;
+typedef int                           rt_bool_t;
+typedef long                          rt_base_t;
+typedef unsigned long                 rt_ubase_t;
+typedef rt_base_t                     rt_err_t;
+typedef rt_uint32_t                   rt_tick_t;
+typedef unsigned long                 rt_size_t;
+typedef long                          rt_off_t;
+
+#define RT_TRUE                       1
+#define RT_FALSE                      0
+#define RT_NULL                       NULL
+
+#define RT_EOK                        0
+#define RT_ERROR                      1
+#define RT_ETIMEOUT                   2
+#define RT_EFULL                      3
+#define RT_EEMPTY                     4
+#define RT_ENOMEM                     5
+#define RT_ENOSYS                     6
+#define RT_EBUSY                      7
+#define RT_EIO                        8
+#define RT_EINTR                      9
+#define RT_EINVAL                     10
+
+#define RT_WAITING_FOREVER            -1
+#define RT_WAITING_NO                 0
+
+#define RT_IPC_FLAG_FIFO              0x00
+#define RT_IPC_FLAG_PRIO              0x01
+#define RT_IPC_CMD_RESET              0x01
+
+#define RT_EVENT_FLAG_AND             0x01
+#define RT_EVENT_FLAG_OR              0x02
+#define RT_EVENT_FLAG_CLEAR           0x04
+
+#define RT_TIMER_FLAG_ONE_SHOT        0x0
+#define RT_TIMER_FLAG_PERIODIC        0x2
+#define RT_TIMER_FLAG_SOFT_TIMER      0x4
+#define RT_TIMER_CTRL_SET_TIME        0x0
+
+#define RT_DEVICE_FLAG_RDWR           0x003
+#define RT_DEVICE_FLAG_INT_RX         0x100
+#define RT_DEVICE_FLAG_DMA_RX         0x200
+#define RT_DEVICE_OFLAG_RDWR          0x003
+#define RT_DEVICE_CTRL_CONFIG         0x03
+
+#ifndef RT_TICK_PER_SECOND
+#define RT_TICK_PER_SECOND            1000
+#endif
+#ifndef RT_THREAD_PRIORITY_MAX
+#define RT_THREAD_PRIORITY_MAX        32
+#endif
+#ifndef RT_NAME_MAX
+#define RT_NAME_MAX                   8
+#endif
+
+#define RT_ASSERT(ex)                 assert(ex)
+
+#define rt_malloc                     malloc
+#define rt_calloc                     calloc
+#define rt_realloc                    realloc
+#define rt_free                       free
+#define rt_memcpy                     memcpy
+#define rt_memset                     memset
+#define rt_memmove                    memmove
+#define rt_memcmp                     memcmp
+#define rt_strlen                     strlen
+#define rt_strcmp                     strcmp
+#define rt_strncmp                    strncmp
+#define rt_strncpy                    strncpy
+#define rt_strstr                     strstr
+#define rt_strdup                     strdup
+#define rt_snprintf                   snprintf
+#define rt_vsnprintf                  vsnprintf
+#define rt_sprintf                    sprintf
+#define rt_kprintf                    printf
+
+/* components are started by hand on the host, except what must exist
+ * before anything runs */
+#define INIT_BOARD_EXPORT(fn)
+#define INIT_PREV_EXPORT(fn)          static void __attribute__((constructor)) fn##_host(void) { fn(); }
+#define INIT_DEVICE_EXPORT(fn)
+#define INIT_COMPONENT_EXPORT(fn)
+#define INIT_ENV_EXPORT(fn)
+#define INIT_APP_EXPORT(fn)
+#define MSH_CMD_EXPORT(cmd, desc)
+#define MSH_CMD_EXPORT_ALIAS(cmd, alias, desc)
+
+typedef struct rt_device *rt_device_t;
+
+struct rt_mutex
+{
+    void *impl;
+};
+typedef struct rt_mutex *rt_mutex_t;
+
+typedef struct rt_semaphore *rt_sem_t;
+typedef struct rt_event *rt_event_t;
+typedef struct rt_messagequeue *rt_mq_t;
+typedef struct rt_thread *rt_thread_t;
+typedef struct rt_timer *rt_timer_t;
+
+/* the stack is a real one, filled with '#' like the target does */
+struct rt_thread
+{
+    char        name[RT_NAME_MAX];
+    pthread_t   tid;
+    void      (*entry)(void *parameter);
+    void       *parameter;
+    void       *stack_addr;
+    rt_uint32_t stack_size;
+    struct rt_thread *next;         /* every thread ever created, like the object container */
+};
+
+enum rt_device_class_type
+{
+    RT_Device_Class_Char = 0,
+    RT_Device_Class_Unknown
+};
+
+struct rt_device
+{
+    char        name[RT_NAME_MAX];
+    struct rt_device *next;
+
+    enum rt_device_class_type type;
+    rt_uint16_t flag;
+    rt_uint16_t open_flag;
+    rt_uint8_t  ref_count;
+
+    rt_err_t  (*rx_indicate)(rt_device_t dev, rt_size_t size);
+    rt_err_t  (*tx_complete)(rt_device_t dev, void *buffer);
+
+    rt_err_t  (*init)(rt_device_t dev);
+    rt_err_t  (*open)(rt_device_t dev, rt_uint16_t oflag);
+    rt_err_t  (*close)(rt_device_t dev);
+    rt_size_t (*read)(rt_device_t dev, rt_off_t pos, void *buffer, rt_size_t size);
+    rt_size_t (*write)(rt_device_t dev, rt_off_t pos, const void *buffer, rt_size_t size);
+    rt_err_t  (*control)(rt_device_t dev, int cmd, void *args);
+
+    void       *user_data;
+};
+
+rt_tick_t   rt_tick_get(void);
+rt_int32_t  rt_tick_from_millisecond(rt_int32_t ms);
+rt_err_t    rt_thread_delay(rt_tick_t tick);
+rt_err_t    rt_thread_mdelay(rt_int32_t ms);
+
+rt_err_t    rt_mutex_init(rt_mutex_t mutex, const char *name, rt_uint8_t flag);
+rt_err_t    rt_mutex_detach(rt_mutex_t mutex);
+rt_mutex_t  rt_mutex_create(const char *name, rt_uint8_t flag);
+rt_err_t    rt_mutex_delete(rt_mutex_t mutex);
+rt_err_t    rt_mutex_take(rt_mutex_t mutex, rt_int32_t timeout);
+rt_err_t    rt_mutex_release(rt_mutex_t mutex);
+
+rt_sem_t    rt_sem_create(const char *name, rt_uint32_t value, rt_uint8_t flag);
+rt_err_t    rt_sem_delete(rt_sem_t sem);
+rt_err_t    rt_sem_take(rt_sem_t sem, rt_int32_t timeout);
+rt_err_t    rt_sem_release(rt_sem_t sem);
+rt_err_t    rt_sem_control(rt_sem_t sem, int cmd, void *arg);
+
+rt_event_t  rt_event_create(const char *name, rt_uint8_t flag);
+rt_err_t    rt_event_send(rt_event_t event, rt_uint32_t set);
+rt_err_t    rt_event_recv(rt_event_t event, rt_uint32_t set, rt_uint8_t opt,
+                          rt_int32_t timeout, rt_uint32_t *recved);
+
+rt_mq_t     rt_mq_create(const char *name, rt_size_t msg_size, rt_size_t max_msgs, rt_uint8_t flag);
+rt_err_t    rt_mq_send(rt_mq_t mq, const void *buffer, rt_size_t size);
+rt_err_t    rt_mq_recv(rt_mq_t mq, void *buffer, rt_size_t size, rt_int32_t timeout);
+rt_err_t    rt_mq_control(rt_mq_t mq, int cmd, void *arg);
+
+rt_thread_t rt_thread_create(const char *name, void (*entry)(void *parameter), void *parameter,
+                             rt_uint32_t stack_size, rt_uint8_t priority, rt_uint32_t tick);
+rt_err_t    rt_thread_startup(rt_thread_t thread);
+
+rt_timer_t  rt_timer_create(const char *name, void (*timeout)(void *parameter), void *parameter,
+                            rt_tick_t time, rt_uint8_t flag);
+rt_err_t    rt_timer_start(rt_timer_t timer);
+rt_err_t    rt_timer_stop(rt_timer_t timer);
+rt_err_t    rt_timer_control(rt_timer_t timer, int cmd, void *arg);
+
+void        rt_enter_critical(void);
+void        rt_exit_critical(void);
+
+rt_device_t rt_device_find(const char *name);
+rt_err_t    rt_device_register(rt_device_t dev, const char *name, rt_uint16_t flags);
+rt_err_t    rt_device_open(rt_device_t dev, rt_uint16_t oflag);
+rt_err_t    rt_device_close(rt_device_t dev);
+rt_size_t   rt_device_read(rt_device_t dev, rt_off_t pos, void *buffer, rt_size_t size);
+rt_size_t   rt_device_write(rt_device_t dev, rt_off_t pos, const void *buffer, rt_size_t size);
+rt_err_t    rt_device_control(rt_device_t dev, int cmd, void *arg);
+rt_err_t    rt_device_set_rx_indicate(rt_device_t dev, rt_err_t (*rx_ind)(rt_device_t dev, rt_size_t size));
+
+#endif /* __RT_THREAD_H__ */
@@ -0,0 +1,720 @@
+/*
+ * Copyright (c) 2023, RudyLo <luhuadong@163.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     agent        the first version
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+
+#include <rtthread.h>
+#include <rthw.h>
+#include <rtdevice.h>
+
+static pthread_mutex_t big_lock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+
+rt_tick_t rt_tick_get(void)
+{
+    static struct timespec start;
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (start.tv_sec == 0 && start.tv_nsec == 0)
+    {
+        start = now;
+    }
+
+    /* start at 1 so a zero tick still means "never" to the package */
+    return (rt_tick_t)((now.tv_sec - start.tv_sec) * 1000 + (now.tv_nsec - start.tv_nsec) / 1000000 + 1);
+}
+
+rt_int32_t rt_tick_from_millisecond(rt_int32_t ms)
+{
+    return ms < 0 ? RT_WAITING_FOREVER : ms * RT_TICK_PER_SECOND / 1000;
+}
+
+rt_err_t rt_thread_delay(rt_tick_t tick)
+{
+    struct timespec ts = { tick / 1000, (tick % 1000) * 1000000L };
+
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR);
+    return RT_EOK;
+}
+
+rt_err_t rt_thread_mdelay(rt_int32_t ms)
+{
+    return rt_thread_delay(ms);
+}
+
+/* absolute CLOCK_REALTIME deadline for the pthread timed waits */
+static struct timespec deadline_of(rt_int32_t timeout)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec  += timeout / 1000;
+    ts.tv_nsec += (timeout % 1000) * 1000000L;
+    if (ts.tv_nsec >= 1000000000L)
+    {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+
+    return ts;
+}
+
+/* mutex: recursive, like the RT-Thread one */
+
+rt_err_t rt_mutex_init(rt_mutex_t mutex, const char *name, rt_uint8_t flag)
+{
+    pthread_mutexattr_t attr;
+    pthread_mutex_t *m = malloc(sizeof(*m));
+
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(m, &attr);
+    pthread_mutexattr_destroy(&attr);
+    mutex->impl = m;
+
+    return RT_EOK;
+}
+
+rt_err_t rt_mutex_detach(rt_mutex_t mutex)
+{
+    pthread_mutex_destroy(mutex->impl);
+    free(mutex->impl);
+    return RT_EOK;
+}
+
+rt_mutex_t rt_mutex_create(const char *name, rt_uint8_t flag)
+{
+    rt_mutex_t mutex = malloc(sizeof(*mutex));
+
+    rt_mutex_init(mutex, name, flag);
+    return mutex;
+}
+
+rt_err_t rt_mutex_delete(rt_mutex_t mutex)
+{
+    rt_mutex_detach(mutex);
+    free(mutex);
+    return RT_EOK;
+}
+
+rt_err_t rt_mutex_take(rt_mutex_t mutex, rt_int32_t timeout)
+{
+    struct timespec ts;
+
+    if (timeout == RT_WAITING_FOREVER)
+    {
+        return pthread_mutex_lock(mutex->impl) == 0 ? RT_EOK : -RT_ERROR;
+    }
+    if (timeout == RT_WAITING_NO)
+    {
+        return pthread_mutex_trylock(mutex->impl) == 0 ? RT_EOK : -RT_ETIMEOUT;
+    }
+
+    ts = deadline_of(timeout);
+    return pthread_mutex_timedlock(mutex->impl, &ts) == 0 ? RT_EOK : -RT_ETIMEOUT;
+}
+
+rt_err_t rt_mutex_release(rt_mutex_t mutex)
+{
+    return pthread_mutex_unlock(mutex->impl) == 0 ? RT_EOK : -RT_ERROR;
+}
+
+/* semaphore and event share one condition based waiter */
+
+struct rt_semaphore
+{
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+    rt_uint32_t     value;
+};
+
+struct rt_event
+{
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+    rt_uint32_t     set;
+};
+
+static int cond_wait(pthread_cond_t *cond, pthread_mutex_t *lock, rt_int32_t timeout, const struct timespec *ts)
+{
+    if (timeout == RT_WAITING_FOREVER)
+    {
+        return pthread_cond_wait(cond, lock);
+    }
+    if (timeout == RT_WAITING_NO)
+    {
+        return ETIMEDOUT;
+    }
+
+    return pthread_cond_timedwait(cond, lock, ts);
+}
+
+rt_sem_t rt_sem_create(const char *name, rt_uint32_t value, rt_uint8_t flag)
+{
+    rt_sem_t sem = calloc(1, sizeof(*sem));
+
+    pthread_mutex_init(&sem->lock, NULL);
+    pthread_cond_init(&sem->cond, NULL);
+    sem->value = value;
+
+    return sem;
+}
+
+rt_err_t rt_sem_delete(rt_sem_t sem)
+{
+    pthread_mutex_destroy(&sem->lock);
+    pthread_cond_destroy(&sem->cond);
+    free(sem);
+    return RT_EOK;
+}
+
+rt_err_t rt_sem_take(rt_sem_t sem, rt_int32_t timeout)
+{
+    struct timespec ts = deadline_of(timeout < 0 ? 0 : timeout);
+    rt_err_t result = RT_EOK;
+
+    pthread_mutex_lock(&sem->lock);
+    while (sem->value == 0)
+    {
+        if (cond_wait(&sem->cond, &sem->lock, timeout, &ts) == ETIMEDOUT && sem->value == 0)
+        {
+            result = -RT_ETIMEOUT;
+            break;
+        }
+    }
+    if (result == RT_EOK)
+    {
+        sem->value--;
+    }
+    pthread_mutex_unlock(&sem->lock);
+
+    return result;
+}
+
+rt_err_t rt_sem_release(rt_sem_t sem)
+{
+    pthread_mutex_lock(&sem->lock);
+    sem->value++;
+    pthread_cond_signal(&sem->cond);
+    pthread_mutex_unlock(&sem->lock);
+
+    return RT_EOK;
+}
+
+rt_err_t rt_sem_control(rt_sem_t sem, int cmd, void *arg)
+{
+    if (cmd == RT_IPC_CMD_RESET)
+    {
+        pthread_mutex_lock(&sem->lock);
+        sem->value = arg ? (rt_uint32_t)(rt_ubase_t)arg : 0;
+        pthread_mutex_unlock(&sem->lock);
+    }
+
+    return RT_EOK;
+}
+
+rt_event_t rt_event_create(const char *name, rt_uint8_t flag)
+{
+    rt_event_t event = calloc(1, sizeof(*event));
+
+    pthread_mutex_init(&event->lock, NULL);
+    pthread_cond_init(&event->cond, NULL);
+
+    return event;
+}
+
+rt_err_t rt_event_send(rt_event_t event, rt_uint32_t set)
+{
+    pthread_mutex_lock(&event->lock);
+    event->set |= set;
+    pthread_cond_broadcast(&event->cond);
+    pthread_mutex_unlock(&event->lock);
+
+    return RT_EOK;
+}
+
+rt_err_t rt_event_recv(rt_event_t event, rt_uint32_t set, rt_uint8_t opt,
+                       rt_int32_t timeout, rt_uint32_t *recved)
+{
+    struct timespec ts = deadline_of(timeout < 0 ? 0 : timeout);
+    rt_err_t result = RT_EOK;
+
+    pthread_mutex_lock(&event->lock);
+    while (!((opt & RT_EVENT_FLAG_AND) ? (event->set & set) == set : (event->set & set) != 0))
+    {
+        if (cond_wait(&event->cond, &event->lock, timeout, &ts) == ETIMEDOUT)
+        {
+            result = -RT_ETIMEOUT;
+            break;
+        }
+    }
+    if (result == RT_EOK)
+    {
+        if (recved)
+        {
+            *recved = event->set & set;
+        }
+        if (opt & RT_EVENT_FLAG_CLEAR)
+        {
+            event->set &= ~set;
+        }
+    }
+    pthread_mutex_unlock(&event->lock);
+
+    return result;
+}
+
+/* message queue: fixed size slots in a ring */
+
+struct rt_messagequeue
+{
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+    rt_size_t       msg_size;
+    rt_size_t       max_msgs;
+    rt_size_t       head;
+    rt_size_t       count;
+    rt_uint8_t     *pool;
+};
+
+rt_mq_t rt_mq_create(const char *name, rt_size_t msg_size, rt_size_t max_msgs, rt_uint8_t flag)
+{
+    rt_mq_t mq = calloc(1, sizeof(*mq));
+
+    pthread_mutex_init(&mq->lock, NULL);
+    pthread_cond_init(&mq->cond, NULL);
+    mq->msg_size = msg_size;
+    mq->max_msgs = max_msgs;
+    mq->pool = malloc(msg_size * max_msgs);
+
+    return mq;
+}
+
+rt_err_t rt_mq_send(rt_mq_t mq, const void *buffer, rt_size_t size)
+{
+    rt_err_t result = RT_EOK;
+
+    pthread_mutex_lock(&mq->lock);
+    if (size > mq->msg_size)
+    {
+        result = -RT_ERROR;
+    }
+    else if (mq->count == mq->max_msgs)
+    {
+        result = -RT_EFULL;
+    }
+    else
+    {
+        memcpy(mq->pool + ((mq->head + mq->count) % mq->max_msgs) * mq->msg_size, buffer, size);
+        mq->count++;
+        pthread_cond_signal(&mq->cond);
+    }
+    pthread_mutex_unlock(&mq->lock);
+
+    return result;
+}
+
+rt_err_t rt_mq_recv(rt_mq_t mq, void *buffer, rt_size_t size, rt_int32_t timeout)
+{
+    struct timespec ts = deadline_of(timeout < 0 ? 0 : timeout);
+    rt_err_t result = RT_EOK;
+
+    pthread_mutex_lock(&mq->lock);
+    while (mq->count == 0)
+    {
+        if (cond_wait(&mq->cond, &mq->lock, timeout, &ts) == ETIMEDOUT && mq->count == 0)
+        {
+            result = -RT_ETIMEOUT;
+            break;
+        }
+    }
+    if (result == RT_EOK)
+    {
+        memcpy(buffer, mq->pool + mq->head * mq->msg_size, size < mq->msg_size ? size : mq->msg_size);
+        mq->head = (mq->head + 1) % mq->max_msgs;
+        mq->count--;
+    }
+    pthread_mutex_unlock(&mq->lock);
+
+    return result;
+}
+
+rt_err_t rt_mq_control(rt_mq_t mq, int cmd, void *arg)
+{
+    if (cmd == RT_IPC_CMD_RESET)
+    {
+        pthread_mutex_lock(&mq->lock);
+        mq->head = mq->count = 0;
+        pthread_mutex_unlock(&mq->lock);
+    }
+
+    return RT_EOK;
+}
+
+/* threads run detached, the host process exit ends them. The host C
+ * library needs far more stack than the target, so every thread gets
+ * HOST_STACK_EXTRA on top of what it asked for. */
+
+#define HOST_STACK_EXTRA              (256 * 1024)
+
+/* exited threads are never reclaimed, the list keeps them reachable */
+static rt_thread_t threads;
+
+static void *thread_main(void *arg)
+{
+    rt_thread_t thread = arg;
+
+    thread->entry(thread->parameter);
+    return NULL;
+}
+
+rt_thread_t rt_thread_create(const char *name, void (*entry)(void *parameter), void *parameter,
+                             rt_uint32_t stack_size, rt_uint8_t priority, rt_uint32_t tick)
+{
+    rt_thread_t thread = calloc(1, sizeof(*thread));
+
+    snprintf(thread->name, sizeof(thread->name), "%s", name);
+    thread->entry = entry;
+    thread->parameter = parameter;
+    thread->stack_size = (stack_size + HOST_STACK_EXTRA + 4095) & ~4095u;
+    if (posix_memalign(&thread->stack_addr, 4096, thread->stack_size) != 0)
+    {
+        free(thread);
+        return RT_NULL;
+    }
+    memset(thread->stack_addr, '#', thread->stack_size);
+
+    rt_enter_critical();
+    thread->next = threads;
+    threads = thread;
+    rt_exit_critical();
+
+    return thread;
+}
+
+rt_err_t rt_thread_startup(rt_thread_t thread)
+{
+    pthread_attr_t attr;
+    int result = 0;
+
+    pthread_attr_init(&attr);
+    pthread_attr_setstack(&attr, thread->stack_addr, thread->stack_size);
+    result = pthread_create(&thread->tid, &attr, thread_main, thread);
+    pthread_attr_destroy(&attr);
+    if (result != 0)
+    {
+        return -RT_ERROR;
+    }
+    pthread_detach(thread->tid);
+
+    return RT_EOK;
+}
+
+/* timers: one thread per started timer, enough for the few the package uses */
+
+struct rt_timer
+{
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+    void          (*timeout)(void *parameter);
+    void           *parameter;
+    rt_tick_t       time;
+    rt_uint8_t      flag;
+    rt_uint32_t     generation;     /* bumped by every start and stop */
+    rt_bool_t       running;
+};
+
+struct timer_run
+{
+    rt_timer_t  timer;
+    rt_uint32_t generation;
+};
+
+static void *timer_main(void *arg)
+{
+    struct timer_run run = *(struct timer_run *)arg;
+    rt_timer_t timer = run.timer;
+    struct timespec ts;
+    int fire = 0;
+
+    free(arg);
+
+    do
+    {
+        pthread_mutex_lock(&timer->lock);
+        ts = deadline_of(timer->time);
+        while (timer->generation == run.generation &&
+               pthread_cond_timedwait(&timer->cond, &timer->lock, &ts) != ETIMEDOUT);
+        fire = (timer->generation == run.generation);
+        if (fire && !(timer->flag & RT_TIMER_FLAG_PERIODIC))
+        {
+            timer->running = RT_FALSE;
+        }
+        pthread_mutex_unlock(&timer->lock);
+
+        if (fire)
+        {
+            timer->timeout(timer->parameter);
+        }
+    } while (fire && (timer->flag & RT_TIMER_FLAG_PERIODIC));
+
+    return NULL;
+}
+
+rt_timer_t rt_timer_create(const char *name, void (*timeout)(void *parameter), void *parameter,
+                           rt_tick_t time, rt_uint8_t flag)
+{
+    rt_timer_t timer = calloc(1, sizeof(*timer));
+
+    pthread_mutex_init(&timer->lock, NULL);
+    pthread_cond_init(&timer->cond, NULL);
+    timer->timeout = timeout;
+    timer->parameter = parameter;
+    timer->time = time;
+    timer->flag = flag;
+
+    return timer;
+}
+
+rt_err_t rt_timer_start(rt_timer_t timer)
+{
+    struct timer_run *run = malloc(sizeof(*run));
+    pthread_t tid;
+
+    pthread_mutex_lock(&timer->lock);
+    timer->generation++;
+    timer->running = RT_TRUE;
+    pthread_cond_broadcast(&timer->cond);
+    run->timer = timer;
+    run->generation = timer->generation;
+    pthread_mutex_unlock(&timer->lock);
+
+    if (pthread_create(&tid, NULL, timer_main, run) != 0)
+    {
+        free(run);
+        return -RT_ERROR;
+    }
+    pthread_detach(tid);
+
+    return RT_EOK;
+}
+
+rt_err_t rt_timer_stop(rt_timer_t timer)
+{
+    rt_err_t result = RT_EOK;
+
+    pthread_mutex_lock(&timer->lock);
+    result = timer->running ? RT_EOK : -RT_ERROR;
+    timer->generation++;
+    timer->running = RT_FALSE;
+    pthread_cond_broadcast(&timer->cond);
+    pthread_mutex_unlock(&timer->lock);
+
+    return result;
+}
+
+rt_err_t rt_timer_control(rt_timer_t timer, int cmd, void *arg)
+{
+    if (cmd == RT_TIMER_CTRL_SET_TIME)
+    {
+        pthread_mutex_lock(&timer->lock);
+        timer->time = *(rt_tick_t *)arg;
+        pthread_mutex_unlock(&timer->lock);
+    }
+
+    return RT_EOK;
+}
+
+void rt_enter_critical(void)
+{
+    pthread_mutex_lock(&big_lock);
+}
+
+void rt_exit_critical(void)
+{
+    pthread_mutex_unlock(&big_lock);
+}
+
+rt_base_t rt_hw_interrupt_disable(void)
+{
+    pthread_mutex_lock(&big_lock);
+    return 0;
+}
+
+void rt_hw_interrupt_enable(rt_base_t level)
+{
+    pthread_mutex_unlock(&big_lock);
+}
+
+/* ring buffer, byte at a time is plenty for the tests */
+
+void rt_ringbuffer_init(struct rt_ringbuffer *rb, rt_uint8_t *pool, rt_int16_t size)
+{
+    rb->buffer_ptr = pool;
+    rb->buffer_size = size;
+    rt_ringbuffer_reset(rb);
+}
+
+void rt_ringbuffer_reset(struct rt_ringbuffer *rb)
+{
+    rb->read_index = rb->write_index = rb->data_len = 0;
+}
+
+rt_size_t rt_ringbuffer_data_len(struct rt_ringbuffer *rb)
+{
+    return rb->data_len;
+}
+
+rt_size_t rt_ringbuffer_put(struct rt_ringbuffer *rb, const rt_uint8_t *ptr, rt_uint16_t length)
+{
+    rt_size_t n = 0;
+
+    for (; n < length && rb->data_len < rb->buffer_size; n++, rb->data_len++)
+    {
+        rb->buffer_ptr[rb->write_index] = ptr[n];
+        rb->write_index = (rb->write_index + 1) % rb->buffer_size;
+    }
+
+    return n;
+}
+
+rt_size_t rt_ringbuffer_get(struct rt_ringbuffer *rb, rt_uint8_t *ptr, rt_uint16_t length)
+{
+    rt_size_t n = 0;
+
+    for (; n < length && rb->data_len > 0; n++, rb->data_len--)
+    {
+        ptr[n] = rb->buffer_ptr[rb->read_index];
+        rb->read_index = (rb->read_index + 1) % rb->buffer_size;
+    }
+
+    return n;
+}
+
+/* devices: a list by name, calls go straight to the driver */
+
+static struct rt_device *devices;
+
+rt_device_t rt_device_find(const char *name)
+{
+    struct rt_device *dev = devices;
+
+    while (dev && strncmp(dev->name, name, RT_NAME_MAX) != 0)
+    {
+        dev = dev->next;
+    }
+
+    return dev;
+}
+
+rt_err_t rt_device_register(rt_device_t dev, const char *name, rt_uint16_t flags)
+{
+    if (rt_device_find(name))
+    {
+        return -RT_ERROR;
+    }
+
+    memcpy(dev->name, name, strnlen(name, RT_NAME_MAX));
+    dev->flag = flags;
+    dev->ref_count = 0;
+    dev->next = devices;
+    devices = dev;
+
+    return RT_EOK;
+}
+
+rt_err_t rt_device_open(rt_device_t dev, rt_uint16_t oflag)
+{
+    rt_err_t result = RT_EOK;
+
+    if (dev->ref_count == 0 && dev->open)
+    {
+        result = dev->open(dev, oflag);
+    }
+    if (result == RT_EOK)
+    {
+        dev->open_flag = oflag;
+        dev->ref_count++;
+    }
+
+    return result;
+}
+
+rt_err_t rt_device_close(rt_device_t dev)
+{
+    if (dev->ref_count == 0)
+    {
+        return -RT_ERROR;
+    }
+    if (--dev->ref_count == 0 && dev->close)
+    {
+        return dev->close(dev);
+    }
+
+    return RT_EOK;
+}
+
+rt_size_t rt_device_read(rt_device_t dev, rt_off_t pos, void *buffer, rt_size_t size)
+{
+    return dev->read ? dev->read(dev, pos, buffer, size) : 0;
+}
+
+rt_size_t rt_device_write(rt_device_t dev, rt_off_t pos, const void *buffer, rt_size_t size)
+{
+    return dev->write ? dev->write(dev, pos, buffer, size) : 0;
+}
+
+rt_err_t rt_device_control(rt_device_t dev, int cmd, void *arg)
+{
+    return dev->control ? dev->control(dev, cmd, arg) : -RT_ENOSYS;
+}
+
+rt_err_t rt_device_set_rx_indicate(rt_device_t dev, rt_err_t (*rx_ind)(rt_device_t dev, rt_size_t size))
+{
+    dev->rx_indicate = rx_ind;
+    return RT_EOK;
+}
+
+/* pins */
+
+#define HOST_PIN_MAX                  128
+
+static rt_uint8_t pins[HOST_PIN_MAX];
+static void (*pin_watch)(rt_base_t pin, rt_uint8_t value);
+
+void rt_pin_mode(rt_base_t pin, rt_uint8_t mode)
+{
+}
+
+void rt_pin_write(rt_base_t pin, rt_uint8_t value)
+{
+    if (pin >= 0 && pin < HOST_PIN_MAX)
+    {
+        pins[pin] = value;
+    }
+    if (pin_watch)
+    {
+        pin_watch(pin, value);
+    }
+}
+
+int rt_pin_read(rt_base_t pin)
+{
+    return (pin >= 0 && pin < HOST_PIN_MAX) ? pins[pin] : PIN_LOW;
+}
+
+/* the emulated module watches its reset line */
+void rt_pin_host_watch(void (*watch)(rt_base_t pin, rt_uint8_t value))
+{
+    pin_watch = watch;
+}
@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2023, RudyLo <luhuadong@163.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     agent        the first version
+ */
+
+#include <pthread.h>
+
+#include <rtthread.h>
+
+#include "test_host.h"
+
+#define RECV_QUEUE_LEN                16
+#define RECV_TOPIC_LEN                128
+#define RECV_PAYLOAD_LEN              1024
+
+struct recv_msg
+{
+    char      topic[RECV_TOPIC_LEN];
+    char      payload[RECV_PAYLOAD_LEN];
+    rt_size_t len;
+};
+
+int test_failed;
+int test_checked;
+
+static struct recv_msg queue[RECV_QUEUE_LEN];
+static int head, count;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+void test_recv_push(const char *topic, rt_size_t topic_len, const char *payload, rt_size_t len)
+{
+    struct recv_msg *msg = RT_NULL;
+
+    pthread_mutex_lock(&lock);
+    if (count < RECV_QUEUE_LEN)
+    {
+        msg = &queue[(head + count++) % RECV_QUEUE_LEN];
+        snprintf(msg->topic, sizeof(msg->topic), "%.*s", (int)topic_len, topic);
+        msg->len = len < sizeof(msg->payload) ? len : sizeof(msg->payload);
+        memcpy(msg->payload, payload, msg->len);
+    }
+    pthread_mutex_unlock(&lock);
+}
+
+int test_recv_wait(char *topic, rt_size_t topic_size, char *payload, rt_size_t size,
+                   rt_size_t *len, rt_int32_t timeout)
+{
+    rt_tick_t deadline = rt_tick_get() + timeout;
+    struct recv_msg *msg = RT_NULL;
+
+    pthread_mutex_lock(&lock);
+    while (count == 0 && (rt_int32_t)(deadline - rt_tick_get()) > 0)
+    {
+        pthread_mutex_unlock(&lock);
+        rt_thread_delay(5);
+        pthread_mutex_lock(&lock);
+    }
+    if (count == 0)
+    {
+        pthread_mutex_unlock(&lock);
+        return -RT_ETIMEOUT;
+    }
+
+    msg = &queue[head];
+    head = (head + 1) % RECV_QUEUE_LEN;
+    count--;
+
+    snprintf(topic, topic_size, "%s", msg->topic);
+    *len = msg->len < size ? msg->len : size;
+    memcpy(payload, msg->payload, *len);
+    pthread_mutex_unlock(&lock);
+
+    return RT_EOK;
+}
+
+int test_report(const char *name)
+{
+    printf("%s: %d checks, %d failed\n", name, test_checked, test_failed);
+    return test_failed ? 1 : 0;
+}
@@ -0,0 +1,38 @@
+/*
+ * Copyright (c) 2023, RudyLo <luhuadong@163.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     agent        the first version
+ */
+
+#ifndef __TEST_HOST_H__
+#define __TEST_HOST_H__
+
+#include <rtthread.h>
+
+extern int test_failed;
+extern int test_checked;
+
+#define TEST_CHECK(expr)                                                          \
+    do                                                                            \
+    {                                                                             \
+        test_checked++;                                                           \
+        if (!(expr))                                                              \
+        {                                                                         \
+            test_failed++;                                                        \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #expr); \
+        }                                                                         \
+    } while (0)
+
+/* messages handed to bc28_recv_dispatch(), oldest first */
+void test_recv_push(const char *topic, rt_size_t topic_len, const char *payload, rt_size_t len);
+int  test_recv_wait(char *topic, rt_size_t topic_size, char *payload, rt_size_t size,
+                    rt_size_t *len, rt_int32_t timeout);
+
+/* print the summary, returns the process exit code */
+int  test_report(const char *name);
+
+#endif /* __TEST_HOST_H__ */
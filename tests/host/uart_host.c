@@ -0,0 +1,608 @@
+/*
+ * Copyright (c) 2023, RudyLo <luhuadong@163.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     agent        the first version
+ */
+
+/*
+ * Emulated BC28 behind a UART, for host tests that run the whole package:
+ * the AT client opens PKG_USING_BC28_AT_CLIENT_DEV_NAME and talks to it,
+ * the reset pin reboots it. It prints the boot banner, registers some time
+ * after AT+CGATT=1 (with +CEREG reports once AT+CEREG=2 is set) and runs
+ * the firmware MQTT client, AT+QMTxxx, against a loopback broker: what is
+ * published on a subscribed topic comes back as +QMTRECV.
+ *
+ * Everything the module sends is scheduled on a timeline and written out
+ * by one thread, so replies keep their order and arrive no earlier than
+ * the configured delays.
+ */
+
+#include <pthread.h>
+
+#include <rtthread.h>
+#include <rtdevice.h>
+
+#include "uart_host.h"
+
+#define UART_RX_LEN                   16384      /* module to host, not yet read */
+#define UART_TX_LEN                   4096       /* host to module, not yet parsed */
+#define UART_SUB_MAX                  8
+#define UART_TOPIC_LEN                128
+#define UART_PUB_MAX                  1024
+#define UART_IMEI                     "860000000000001"
+#define UART_IMSI                     "460001234567890"
+#define UART_TAC                      "1A2B"
+#define UART_CI                       "0C3D4E5F"
+
+struct uart_event
+{
+    struct uart_event *next;
+    rt_tick_t   due;
+    void      (*action)(void);
+    rt_size_t   len;
+    char        text[];
+};
+
+static struct
+{
+    struct rt_device parent;
+    struct uart_host_timing timing;
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+
+    rt_uint8_t  rx[UART_RX_LEN];
+    rt_size_t   rx_head, rx_len;
+    char        tx[UART_TX_LEN];
+    rt_size_t   tx_len;
+    rt_bool_t   indicate;
+    struct uart_event *events;
+
+    rt_bool_t   held;               /* reset line asserted */
+    rt_bool_t   ready;
+    rt_bool_t   registering;
+    rt_bool_t   registered;
+    int         cereg;
+    rt_bool_t   opened;
+    rt_bool_t   connected;
+    char        subs[UART_SUB_MAX][UART_TOPIC_LEN];
+    char        pub_topic[UART_TOPIC_LEN];
+    char        pub[UART_PUB_MAX + 1];
+    rt_size_t   pub_len, pub_left;
+
+    rt_uint32_t commands;
+    rt_uint32_t boots;
+} uart = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER,
+};
+
+/* the module's side of the wire, call with the lock held */
+
+static void emit(const char *text, rt_size_t len)
+{
+    for (rt_size_t i = 0; i < len && uart.rx_len < UART_RX_LEN; i++)
+    {
+        uart.rx[(uart.rx_head + uart.rx_len++) % UART_RX_LEN] = text[i];
+    }
+    uart.indicate = RT_TRUE;
+}
+
+static void schedule(rt_uint32_t delay, void (*action)(void), const char *fmt, ...)
+{
+    struct uart_event *event = RT_NULL, **p = &uart.events;
+    va_list args;
+    int len = 0;
+
+    if (fmt)
+    {
+        va_start(args, fmt);
+        len = vsnprintf(RT_NULL, 0, fmt, args);
+        va_end(args);
+    }
+
+    event = calloc(1, sizeof(*event) + len + 1);
+    event->due = rt_tick_get() + rt_tick_from_millisecond(delay);
+    event->action = action;
+    event->len = len;
+    if (fmt)
+    {
+        va_start(args, fmt);
+        vsnprintf(event->text, len + 1, fmt, args);
+        va_end(args);
+    }
+
+    /* after everything due at the same time, the wire keeps the order */
+    while (*p && (rt_int32_t)((*p)->due - event->due) <= 0)
+    {
+        p = &(*p)->next;
+    }
+    event->next = *p;
+    *p = event;
+
+    pthread_cond_signal(&uart.cond);
+}
+
+#define reply(fmt, ...)               schedule(uart.timing.reply_ms, RT_NULL, "\r\n" fmt "\r\n", ##__VA_ARGS__)
+#define report(fmt, ...)              schedule(uart.timing.reply_ms * 2, RT_NULL, "\r\n" fmt "\r\n", ##__VA_ARGS__)
+
+static void forget(void)
+{
+    struct uart_event *event = RT_NULL;
+
+    while ((event = uart.events) != RT_NULL)
+    {
+        uart.events = event->next;
+        free(event);
+    }
+
+    uart.tx_len      = 0;
+    uart.ready       = RT_FALSE;
+    uart.registering = RT_FALSE;
+    uart.registered  = RT_FALSE;
+    uart.cereg       = 0;
+    uart.opened      = RT_FALSE;
+    uart.connected   = RT_FALSE;
+    uart.pub_left    = 0;
+    memset(uart.subs, 0, sizeof(uart.subs));
+}
+
+static void boot_done(void)
+{
+    uart.ready = RT_TRUE;
+    uart.boots++;
+}
+
+static void reboot(const char *cause)
+{
+    forget();
+    schedule(uart.timing.boot_ms, boot_done,
+             "\r\nBoot: Unsigned\r\nSecurity B.. Verified\r\nProtocol A.. Verified\r\nApps A...... Verified\r\n"
+             "\r\nREBOOT_CAUSE_%s\r\nNeul \r\nOK\r\n", cause);
+}
+
+static void registered(void)
+{
+    char text[64];
+    int n = 0;
+
+    uart.registering = RT_FALSE;
+    uart.registered  = RT_TRUE;
+
+    if (uart.cereg == 1)
+    {
+        n = snprintf(text, sizeof(text), "\r\n+CEREG:1\r\n");
+    }
+    else if (uart.cereg >= 2)
+    {
+        n = snprintf(text, sizeof(text), "\r\n+CEREG:1,\"" UART_TAC "\",\"" UART_CI "\",7\r\n");
+    }
+    emit(text, n);
+}
+
+static void opened(void)
+{
+    uart.opened = uart.registered;
+}
+
+static void connected(void)
+{
+    uart.connected = uart.opened;
+}
+
+/* MQTT topic filter match, '+' one level and '#' the rest */
+static rt_bool_t topic_match(const char *filter, const char *topic)
+{
+    while (*filter)
+    {
+        if (*filter == '#')
+        {
+            return RT_TRUE;
+        }
+        if (*filter == '+')
+        {
+            while (*topic && *topic != '/') topic++;
+            filter++;
+            continue;
+        }
+        if (*filter++ != *topic++)
+        {
+            return RT_FALSE;
+        }
+    }
+
+    return *topic == '\0';
+}
+
+static void publish_done(void)
+{
+    uart.pub[uart.pub_len] = '\0';
+
+    reply("OK");
+    reply("+QMTPUB: 0,0,0");
+
+    for (int i = 0; i < UART_SUB_MAX; i++)
+    {
+        if (uart.subs[i][0] && topic_match(uart.subs[i], uart.pub_topic))
+        {
+            report("+QMTRECV: 0,0,\"%s\",%s", uart.pub_topic, uart.pub);
+            break;
+        }
+    }
+}
+
+static void subscribe(const char *topic)
+{
+    int free_slot = -1;
+
+    for (int i = 0; i < UART_SUB_MAX; i++)
+    {
+        if (!strcmp(uart.subs[i], topic))
+        {
+            return;
+        }
+        if (free_slot < 0 && uart.subs[i][0] == '\0')
+        {
+            free_slot = i;
+        }
+    }
+    if (free_slot >= 0)
+    {
+        snprintf(uart.subs[free_slot], UART_TOPIC_LEN, "%s", topic);
+    }
+}
+
+static void unsubscribe(const char *topic)
+{
+    for (int i = 0; i < UART_SUB_MAX; i++)
+    {
+        if (!strcmp(uart.subs[i], topic))
+        {
+            uart.subs[i][0] = '\0';
+        }
+    }
+}
+
+static void command(const char *line)
+{
+    char topic[UART_TOPIC_LEN];
+    int id = 0, qos = 0, retain = 0, n = 0;
+    unsigned len = 0;
+
+    uart.commands++;
+
+    if (!strcmp(line, "AT+NRB"))
+    {
+        reboot("APPLICATION_AT");
+        reply("REBOOTING");
+        return;
+    }
+    else if (!strcmp(line, "AT+CGSN=1"))
+    {
+        reply("+CGSN:" UART_IMEI);
+    }
+    else if (!strcmp(line, "AT+CIMI"))
+    {
+        reply(UART_IMSI);
+    }
+    else if (sscanf(line, "AT+CEREG=%d", &n) == 1)
+    {
+        uart.cereg = n;
+    }
+    else if (!strcmp(line, "AT+CEREG?"))
+    {
+        if (uart.registered && uart.cereg >= 2)
+        {
+            reply("+CEREG:%d,1,\"" UART_TAC "\",\"" UART_CI "\",7", uart.cereg);
+        }
+        else
+        {
+            reply("+CEREG:%d,%d", uart.cereg, uart.registered ? 1 : (uart.registering ? 2 : 0));
+        }
+    }
+    else if (!strcmp(line, "AT+CGATT=1"))
+    {
+        if (!uart.registered && !uart.registering)
+        {
+            uart.registering = RT_TRUE;
+            schedule(uart.timing.reg_ms, registered, RT_NULL);
+        }
+    }
+    else if (!strcmp(line, "AT+CGATT=0"))
+    {
+        uart.registered = uart.registering = RT_FALSE;
+        uart.opened = uart.connected = RT_FALSE;
+        if (uart.cereg)
+        {
+            reply("OK");
+            report("+CEREG:0");
+            return;
+        }
+    }
+    else if (!strcmp(line, "AT+CGATT?"))
+    {
+        reply("+CGATT:%d", uart.registered);
+    }
+    else if (!strcmp(line, "AT+CGPADDR"))
+    {
+        reply("+CGPADDR:0%s", uart.registered ? ",10.0.0.2" : "");
+    }
+    else if (!strcmp(line, "AT+CSQ"))
+    {
+        reply("+CSQ:%s", uart.registered ? "20,0" : "99,99");
+    }
+    else if (!strcmp(line, "AT+NUESTATS"))
+    {
+        reply("Signal power:-850\r\nTotal power:-700\r\nTX power:100\r\nCell ID:214843215\r\n"
+              "ECL:0\r\nSNR:120\r\nEARFCN:2506\r\nPCI:91\r\nRSRQ:-105");
+    }
+    else if (!strncmp(line, "AT+QMTOPEN=0,", 13))
+    {
+        reply("OK");
+        schedule(uart.timing.reply_ms * 2, opened, RT_NULL);
+        report("+QMTOPEN: 0,%d", uart.registered ? 0 : 3);
+        return;
+    }
+    else if (!strcmp(line, "AT+QMTCLOSE=0"))
+    {
+        uart.opened = uart.connected = RT_FALSE;
+        reply("OK");
+        report("+QMTCLOSE: 0,0");
+        return;
+    }
+    else if (!strncmp(line, "AT+QMTCONN=0,", 13))
+    {
+        if (!uart.opened)
+        {
+            reply("ERROR");
+            return;
+        }
+        reply("OK");
+        schedule(uart.timing.reply_ms * 2, connected, RT_NULL);
+        report("+QMTCONN: 0,0,0");
+        return;
+    }
+    else if (!strcmp(line, "AT+QMTDISC=0"))
+    {
+        uart.opened = uart.connected = RT_FALSE;
+        reply("OK");
+        report("+QMTDISC: 0,0");
+        return;
+    }
+    else if (sscanf(line, "AT+QMTSUB=0,%d,\"%127[^\"]\",%d", &id, topic, &qos) == 3)
+    {
+        if (!uart.connected)
+        {
+            reply("ERROR");
+            return;
+        }
+        /* the broker refuses anything under "refused/" */
+        n = strncmp(topic, "refused/", 8) ? qos : 128;
+        if (n != 128)
+        {
+            subscribe(topic);
+        }
+        reply("OK");
+        report("+QMTSUB: 0,%d,0,%d", id, n);
+        return;
+    }
+    else if (sscanf(line, "AT+QMTUNS=0,%d, \"%127[^\"]\"", &id, topic) == 2)
+    {
+        unsubscribe(topic);
+        reply("OK");
+        report("+QMTUNS: 0,%d,0", id);
+        return;
+    }
+    else if (sscanf(line, "AT+QMTPUB=0,%d,%d,%d,\"%127[^\"]\",%u", &id, &qos, &retain, topic, &len) == 5)
+    {
+        if (!uart.connected || len == 0 || len > UART_PUB_MAX)
+        {
+            reply("ERROR");
+            return;
+        }
+        snprintf(uart.pub_topic, sizeof(uart.pub_topic), "%s", topic);
+        uart.pub_len  = 0;
+        uart.pub_left = len;
+        schedule(uart.timing.reply_ms, RT_NULL, "\r\n>");
+        return;
+    }
+    else if (strncmp(line, "AT", 2) != 0)
+    {
+        reply("ERROR");
+        return;
+    }
+
+    /* everything else, AT+QMTCFG and the attach settings, is accepted */
+    reply("OK");
+}
+
+/* parse what the host wrote, call with the lock held */
+static void input(void)
+{
+    char line[UART_TX_LEN + 1];
+    rt_size_t n = 0;
+
+    while (uart.tx_len > 0)
+    {
+        if (uart.pub_left)
+        {
+            n = uart.tx_len < uart.pub_left ? uart.tx_len : uart.pub_left;
+            memcpy(uart.pub + uart.pub_len, uart.tx, n);
+            uart.pub_len  += n;
+            uart.pub_left -= n;
+            memmove(uart.tx, uart.tx + n, uart.tx_len -= n);
+            if (uart.pub_left == 0)
+            {
+                publish_done();
+            }
+            continue;
+        }
+
+        for (n = 0; n < uart.tx_len && uart.tx[n] != '\r' && uart.tx[n] != '\n'; n++);
+        if (n == uart.tx_len)
+        {
+            /* a line longer than the buffer is noise */
+            if (uart.tx_len == UART_TX_LEN)
+            {
+                uart.tx_len = 0;
+            }
+            return;
+        }
+
+        memcpy(line, uart.tx, n);
+        line[n] = '\0';
+        /* the line ends at CR, a LF right behind it belongs to it */
+        n += (uart.tx[n] == '\r' && n + 1 < uart.tx_len && uart.tx[n + 1] == '\n') ? 2 : 1;
+        memmove(uart.tx, uart.tx + n, uart.tx_len -= n);
+
+        if (line[0] && uart.ready)
+        {
+            command(line);
+        }
+    }
+}
+
+static void *uart_main(void *arg)
+{
+    struct uart_event *event = RT_NULL;
+    struct timespec ts;
+    rt_int32_t wait = 0;
+
+    pthread_mutex_lock(&uart.lock);
+    while (1)
+    {
+        input();
+
+        while ((event = uart.events) != RT_NULL && (rt_int32_t)(event->due - rt_tick_get()) <= 0)
+        {
+            uart.events = event->next;
+            if (event->len)
+            {
+                emit(event->text, event->len);
+            }
+            if (event->action)
+            {
+                event->action();
+            }
+            free(event);
+        }
+
+        if (uart.indicate)
+        {
+            uart.indicate = RT_FALSE;
+            pthread_mutex_unlock(&uart.lock);
+            if (uart.parent.rx_indicate)
+            {
+                uart.parent.rx_indicate(&uart.parent, uart.rx_len);
+            }
+            pthread_mutex_lock(&uart.lock);
+            continue;
+        }
+
+        wait = uart.events ? (rt_int32_t)(uart.events->due - rt_tick_get()) : 50;
+        wait = wait < 1 ? 1 : (wait > 50 ? 50 : wait);
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_nsec += wait * 1000000L;
+        ts.tv_sec  += ts.tv_nsec / 1000000000L;
+        ts.tv_nsec %= 1000000000L;
+
+        /* writes signal, and they need the lock this wait gives up */
+        pthread_cond_timedwait(&uart.cond, &uart.lock, &ts);
+    }
+
+    return NULL;
+}
+
+/* the UART driver */
+
+static rt_size_t uart_read(rt_device_t dev, rt_off_t pos, void *buffer, rt_size_t size)
+{
+    rt_uint8_t *data = buffer;
+    rt_size_t n = 0;
+
+    pthread_mutex_lock(&uart.lock);
+    for (; n < size && uart.rx_len > 0; n++, uart.rx_len--)
+    {
+        data[n] = uart.rx[uart.rx_head];
+        uart.rx_head = (uart.rx_head + 1) % UART_RX_LEN;
+    }
+    pthread_mutex_unlock(&uart.lock);
+
+    return n;
+}
+
+static rt_size_t uart_write(rt_device_t dev, rt_off_t pos, const void *buffer, rt_size_t size)
+{
+    rt_size_t n = 0;
+
+    pthread_mutex_lock(&uart.lock);
+    if (!uart.held)
+    {
+        n = UART_TX_LEN - uart.tx_len;
+        n = n < size ? n : size;
+        memcpy(uart.tx + uart.tx_len, buffer, n);
+        uart.tx_len += n;
+        pthread_cond_signal(&uart.cond);
+    }
+    pthread_mutex_unlock(&uart.lock);
+
+    /* the wire takes everything, a full module buffer loses it */
+    return size;
+}
+
+static rt_err_t uart_control(rt_device_t dev, int cmd, void *args)
+{
+    return RT_EOK;
+}
+
+static void uart_pin(rt_base_t pin, rt_uint8_t value)
+{
+    if (pin != PKG_USING_BC28_RESET_PIN)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&uart.lock);
+    if (value == PIN_HIGH)
+    {
+        uart.held = RT_TRUE;
+        forget();
+    }
+    else if (uart.held)
+    {
+        uart.held = RT_FALSE;
+        reboot("SECURITY_RESET_PIN");
+    }
+    pthread_mutex_unlock(&uart.lock);
+}
+
+void uart_host_init(const struct uart_host_timing *timing)
+{
+    pthread_t tid;
+
+    uart.timing = *timing;
+    uart.ready  = RT_TRUE;          /* powered up long ago, not registered */
+
+    uart.parent.type    = RT_Device_Class_Char;
+    uart.parent.read    = uart_read;
+    uart.parent.write   = uart_write;
+    uart.parent.control = uart_control;
+    rt_device_register(&uart.parent, PKG_USING_BC28_AT_CLIENT_DEV_NAME, RT_DEVICE_FLAG_RDWR | RT_DEVICE_FLAG_INT_RX);
+    rt_pin_host_watch(uart_pin);
+
+    pthread_create(&tid, NULL, uart_main, NULL);
+    pthread_detach(tid);
+}
+
+rt_uint32_t uart_host_commands(void)
+{
+    return uart.commands;
+}
+
+rt_uint32_t uart_host_boots(void)
+{
+    return uart.boots;
+}
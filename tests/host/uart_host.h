@@ -0,0 +1,32 @@
+/*
+ * Copyright (c) 2023, RudyLo <luhuadong@163.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     agent        the first version
+ */
+
+#ifndef __UART_HOST_H__
+#define __UART_HOST_H__
+
+#include <rtthread.h>
+
+struct uart_host_timing
+{
+    rt_uint32_t boot_ms;    /* reset released or AT+NRB to the end of the boot banner */
+    rt_uint32_t reg_ms;     /* AT+CGATT=1 to registered */
+    rt_uint32_t reply_ms;   /* command to its reply, and reply to the result URC */
+};
+
+/* register the module's UART and watch its reset line, before bc28_init() */
+void        uart_host_init(const struct uart_host_timing *timing);
+
+/* command lines the module has answered since it was started */
+rt_uint32_t uart_host_commands(void);
+
+/* times the module booted */
+rt_uint32_t uart_host_boots(void);
+
+#endif /* __UART_HOST_H__ */
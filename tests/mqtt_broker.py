@@ -0,0 +1,193 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2023, RudyLo <luhuadong@163.com>
+#
+# SPDX-License-Identifier: LGPL-2.1
+#
+# Change Logs:
+# Date           Author       Notes
+# 2026-10-19     agent        the first version
+#
+"""
+MQTT 3.1.1 broker stand-in for the broker test when mosquitto is not
+installed, TCP on 127.0.0.1.
+
+QoS 0, 1 and 2 both ways, "#" and "+" filters, no retained messages and no
+will. Sessions with clean session 0 keep their subscriptions across
+connects. Subscribing to "refused/..." is answered with 0x80.
+
+Usage: mqtt_broker.py <port>
+"""
+
+import select
+import socket
+import struct
+import sys
+
+CONNECT, CONNACK, PUBLISH, PUBACK, PUBREC, PUBREL, PUBCOMP = 1, 2, 3, 4, 5, 6, 7
+SUBSCRIBE, SUBACK, UNSUBSCRIBE, UNSUBACK = 8, 9, 10, 11
+PINGREQ, PINGRESP, DISCONNECT = 12, 13, 14
+
+
+def packet(kind, flags, body=b""):
+    n, length = len(body), b""
+    while True:
+        byte, n = n % 128, n // 128
+        length += bytes([byte | (0x80 if n else 0)])
+        if not n:
+            break
+    return bytes([kind << 4 | flags]) + length + body
+
+
+def remaining(buf):
+    """Fixed header length and remaining length, None until both have arrived."""
+    length, mult = 0, 1
+    for at in range(1, min(len(buf), 5)):
+        length += (buf[at] & 0x7F) * mult
+        mult *= 128
+        if not buf[at] & 0x80:
+            return at + 1, length
+    return None
+
+
+def string(data, at):
+    n = struct.unpack(">H", data[at:at + 2])[0]
+    return data[at + 2:at + 2 + n].decode(), at + 2 + n
+
+
+def matches(filt, topic):
+    f, t = filt.split("/"), topic.split("/")
+    for i, level in enumerate(f):
+        if level == "#":
+            return True
+        if i >= len(t) or (level != "+" and level != t[i]):
+            return False
+    return len(f) == len(t)
+
+
+class Session:
+    def __init__(self):
+        self.subs = {}            # filter -> granted QoS
+        self.qos2_rx = set()      # ids received with QoS 2, waiting for PUBREL
+        self.msg_id = 0
+
+
+class Broker:
+    def __init__(self, port):
+        self.listener = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        self.listener.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        self.listener.bind(("127.0.0.1", port))
+        self.listener.listen(4)
+        self.conns = {}           # socket -> [received bytes, session or None]
+        self.sessions = {}        # client id -> Session
+
+    def drop(self, sock):
+        self.conns.pop(sock, None)
+        sock.close()
+
+    def deliver(self, topic, payload, qos):
+        for sock, (_, session) in list(self.conns.items()):
+            if session is None:
+                continue
+            granted = [q for f, q in session.subs.items() if matches(f, topic)]
+            if not granted:
+                continue
+            q = min(qos, max(granted))
+            body = struct.pack(">H", len(topic)) + topic.encode()
+            if q:
+                session.msg_id = session.msg_id % 0xFFFF + 1
+                body += struct.pack(">H", session.msg_id)
+            sock.sendall(packet(PUBLISH, q << 1, body + payload))
+
+    def handle(self, sock, kind, flags, body):
+        session = self.conns[sock][1]
+
+        if kind == CONNECT:
+            at = string(body, 0)[1]
+            clean = body[at + 1] & 0x02
+            client_id = string(body, at + 4)[0]
+            present = 0 if clean else int(client_id in self.sessions)
+            if clean or client_id not in self.sessions:
+                self.sessions[client_id] = Session()
+            self.conns[sock][1] = self.sessions[client_id]
+            sock.sendall(packet(CONNACK, 0, bytes([present, 0])))
+        elif session is None:
+            self.drop(sock)
+        elif kind == PUBLISH:
+            qos = (flags >> 1) & 0x03
+            topic, at = string(body, 0)
+            msg_id = struct.unpack(">H", body[at:at + 2])[0] if qos else 0
+            payload = body[at + 2:] if qos else body[at:]
+            if qos == 1:
+                sock.sendall(packet(PUBACK, 0, struct.pack(">H", msg_id)))
+            elif qos == 2:
+                sock.sendall(packet(PUBREC, 0, struct.pack(">H", msg_id)))
+                if msg_id in session.qos2_rx:
+                    return
+                session.qos2_rx.add(msg_id)
+            self.deliver(topic, payload, qos)
+        elif kind == PUBREL:
+            msg_id = struct.unpack(">H", body[:2])[0]
+            session.qos2_rx.discard(msg_id)
+            sock.sendall(packet(PUBCOMP, 0, body[:2]))
+        elif kind == PUBREC:
+            sock.sendall(packet(PUBREL, 0x02, body[:2]))
+        elif kind in (PUBACK, PUBCOMP):
+            pass
+        elif kind in (SUBSCRIBE, UNSUBSCRIBE):
+            msg_id, at, codes = body[:2], 2, b""
+            while at < len(body):
+                filt, at = string(body, at)
+                if kind == SUBSCRIBE:
+                    qos, at = body[at], at + 1
+                    if filt.startswith("refused/"):
+                        codes += b"\x80"
+                    else:
+                        session.subs[filt] = qos
+                        codes += bytes([qos])
+                else:
+                    session.subs.pop(filt, None)
+            if kind == SUBSCRIBE:
+                sock.sendall(packet(SUBACK, 0, msg_id + codes))
+            else:
+                sock.sendall(packet(UNSUBACK, 0, msg_id))
+        elif kind == PINGREQ:
+            sock.sendall(packet(PINGRESP, 0))
+        elif kind == DISCONNECT:
+            self.drop(sock)
+
+    def receive(self, sock):
+        data = sock.recv(4096)
+        if not data:
+            self.drop(sock)
+            return
+        buf = self.conns[sock][0] + data
+
+        while True:
+            header = remaining(buf)
+            if header is None or len(buf) < sum(header):
+                break
+            at, length = header
+            kind, flags, body = buf[0] >> 4, buf[0] & 0x0F, buf[at:at + length]
+            buf = buf[at + length:]
+            self.handle(sock, kind, flags, body)
+            if sock not in self.conns:
+                return
+
+        self.conns[sock][0] = buf
+
+    def run(self):
+        while True:
+            ready = select.select([self.listener] + list(self.conns), [], [])[0]
+            for sock in ready:
+                if sock is self.listener:
+                    conn = self.listener.accept()[0]
+                    self.conns[conn] = [b"", None]
+                elif sock in self.conns:
+                    self.receive(sock)
+
+
+if __name__ == "__main__":
+    broker = Broker(int(sys.argv[1]))
+    print("ready", flush=True)
+    broker.run()
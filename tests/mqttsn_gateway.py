@@ -0,0 +1,189 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2023, RudyLo <luhuadong@163.com>
+#
+# SPDX-License-Identifier: LGPL-2.1
+#
+# Change Logs:
+# Date           Author       Notes
+# 2026-10-19     agent        the first version
+#
+"""
+MQTT-SN gateway stand-in for the loopback test, one UDP socket on 127.0.0.1.
+
+Every publish is delivered back to the clients subscribed to its topic, so a
+single client sees its own messages. Predefined topic 1 is "pre/topic".
+Publishing "truncate" to short topic "ct" makes the gateway answer with
+malformed PUBLISH packets followed by a good one, "badlen" does the same with
+length fields that do not match the datagram; publishing "kick" to "ct"
+makes it send a DISCONNECT.
+
+Usage: mqttsn_gateway.py <port>
+"""
+
+import socket
+import struct
+import sys
+import time
+
+CONNECT, CONNACK, REGISTER, REGACK = 0x04, 0x05, 0x0A, 0x0B
+PUBLISH, PUBACK, SUBSCRIBE, SUBACK = 0x0C, 0x0D, 0x12, 0x13
+UNSUBSCRIBE, UNSUBACK, PINGREQ, PINGRESP, DISCONNECT = 0x14, 0x15, 0x16, 0x17, 0x18
+
+TOPIC_NORMAL, TOPIC_PREDEFINED, TOPIC_SHORT = 0, 1, 2
+QOS_MASK, QOS_1 = 0x60, 0x20
+
+PREDEFINED = {1: "pre/topic"}
+
+
+def packet(*fields):
+    body = b"".join(fields)
+    if len(body) + 1 <= 0xFF:
+        return bytes([len(body) + 1]) + body
+    return b"\x01" + struct.pack(">H", len(body) + 3) + body
+
+
+class Client:
+    def __init__(self):
+        self.subs = set()
+        self.registered = {}      # topic name -> id told to the client
+        self.asleep = False
+        self.buffered = []
+
+
+class Gateway:
+    def __init__(self, port):
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self.sock.bind(("127.0.0.1", port))
+        self.clients = {}
+        self.ids = {}             # topic name -> normal topic id
+        self.msg_id = 0
+
+    def topic_id(self, name):
+        if name not in self.ids:
+            self.ids[name] = 0x100 + len(self.ids)
+        return self.ids[name]
+
+    def topic_name(self, flags, tid):
+        kind = flags & 0x03
+        if kind == TOPIC_SHORT:
+            return struct.pack(">H", tid).decode()
+        if kind == TOPIC_PREDEFINED:
+            return PREDEFINED.get(tid)
+        for name, i in self.ids.items():
+            if i == tid:
+                return name
+        return None
+
+    def send(self, addr, data):
+        self.sock.sendto(data, addr)
+
+    def deliver(self, addr, client, name, payload):
+        if len(name) == 2:
+            flags, tid = TOPIC_SHORT, struct.unpack(">H", name.encode())[0]
+        elif name in PREDEFINED.values():
+            flags = TOPIC_PREDEFINED
+            tid = [k for k, v in PREDEFINED.items() if v == name][0]
+        else:
+            flags, tid = TOPIC_NORMAL, self.topic_id(name)
+            if name not in client.registered:
+                self.msg_id += 1
+                self.send(addr, packet(bytes([REGISTER]), struct.pack(">HH", tid, self.msg_id), name.encode()))
+                client.registered[name] = tid
+        pkt = packet(bytes([PUBLISH, flags]), struct.pack(">HH", tid, 0), payload)
+        if client.asleep:
+            client.buffered.append(pkt)
+        else:
+            self.send(addr, pkt)
+
+    def publish(self, addr, flags, tid, msg_id, payload):
+        name = self.topic_name(flags, tid)
+        if flags & QOS_MASK == QOS_1:
+            self.send(addr, packet(bytes([PUBACK]), struct.pack(">HH", tid, msg_id), b"\x00"))
+        if name is None:
+            return
+
+        if name == "ct" and payload == b"truncate":
+            # every length a PUBLISH body can be cut short at, paced so the
+            # client's four packet receive queue keeps up
+            for cut in range(1, 6):
+                self.send(addr, bytes([cut + 1]) + (bytes([PUBLISH, TOPIC_SHORT]) + b"ct\x00\x00")[:cut])
+                time.sleep(0.02)
+            self.send(addr, packet(bytes([PUBLISH, TOPIC_SHORT]), b"ct", b"\x00\x00", b"after"))
+            return
+        if name == "ct" and payload == b"badlen":
+            good = packet(bytes([PUBLISH, TOPIC_SHORT]), b"ct", b"\x00\x00", b"wrong")
+            for bad in (b"\x01\x0c", b"\x01\x00\x03", bytes([len(good) + 1]) + good[1:],
+                        b"\x01" + struct.pack(">H", len(good) + 1) + good[1:]):
+                self.send(addr, bad)
+                time.sleep(0.02)
+            self.send(addr, packet(bytes([PUBLISH, TOPIC_SHORT]), b"ct", b"\x00\x00", b"after"))
+            return
+        if name == "ct" and payload == b"kick":
+            self.send(addr, packet(bytes([DISCONNECT])))
+            return
+
+        for peer, client in self.clients.items():
+            if name in client.subs:
+                self.deliver(peer, client, name, payload)
+
+    def handle(self, data, addr):
+        if data[0] == 0x01:
+            body = data[3:]
+        else:
+            body = data[1:]
+        kind = body[0]
+        client = self.clients.setdefault(addr, Client())
+
+        if kind == CONNECT:
+            client.subs.clear()
+            client.registered.clear()
+            client.asleep = False
+            self.send(addr, packet(bytes([CONNACK, 0])))
+        elif kind == REGISTER:
+            msg_id = struct.unpack(">H", body[3:5])[0]
+            name = body[5:].decode()
+            tid = self.topic_id(name)
+            client.registered[name] = tid
+            self.send(addr, packet(bytes([REGACK]), struct.pack(">HH", tid, msg_id), b"\x00"))
+        elif kind == PUBLISH:
+            flags = body[1]
+            tid, msg_id = struct.unpack(">HH", body[2:6])
+            self.publish(addr, flags, tid, msg_id, body[6:])
+        elif kind in (SUBSCRIBE, UNSUBSCRIBE):
+            flags = body[1]
+            msg_id = struct.unpack(">H", body[2:4])[0]
+            if flags & 0x03 == TOPIC_PREDEFINED:
+                name = PREDEFINED.get(struct.unpack(">H", body[4:6])[0])
+            else:
+                name = body[4:].decode()
+            if kind == SUBSCRIBE:
+                client.subs.add(name)
+                tid = self.topic_id(name) if flags & 0x03 == TOPIC_NORMAL else 0
+                if tid:
+                    client.registered[name] = tid
+                self.send(addr, packet(bytes([SUBACK, flags & QOS_MASK]), struct.pack(">HH", tid, msg_id), b"\x00"))
+            else:
+                client.subs.discard(name)
+                self.send(addr, packet(bytes([UNSUBACK]), struct.pack(">H", msg_id)))
+        elif kind == PINGREQ:
+            # a sleeping client wakes to collect what was buffered for it
+            for pkt in client.buffered:
+                self.send(addr, pkt)
+            client.buffered = []
+            self.send(addr, packet(bytes([PINGRESP])))
+        elif kind == DISCONNECT:
+            client.asleep = len(body) >= 3
+            self.send(addr, packet(bytes([DISCONNECT])))
+
+    def run(self):
+        while True:
+            data, addr = self.sock.recvfrom(2048)
+            if len(data) >= 2:
+                self.handle(data, addr)
+
+
+if __name__ == "__main__":
+    gateway = Gateway(int(sys.argv[1]))
+    print("ready", flush=True)
+    gateway.run()
@@ -0,0 +1,138 @@
+#!/bin/sh
+#
+# Copyright (c) 2023, RudyLo <luhuadong@163.com>
+#
+# SPDX-License-Identifier: LGPL-2.1
+#
+# Change Logs:
+# Date           Author       Notes
+# 2026-10-19     agent        the first version
+#
+# Build and run the host tests: tests/run.sh [test ...]
+# Every test is built from the package sources with the shims in tests/host,
+# the output goes to tests/build (or $BUILD).
+
+set -e
+
+TESTS=$(cd "$(dirname "$0")" && pwd)
+ROOT=$(dirname "$TESTS")
+BUILD=${BUILD:-$TESTS/build}
+CC=${CC:-cc}
+CFLAGS="-std=gnu99 -g -O1 -Wall -Wno-unused-parameter -Wno-format -Wno-stringop-truncation -fsanitize=address,undefined -pthread \
+        -I$TESTS/host -I$ROOT/inc -I$ROOT/src"
+BENCH_CFLAGS="-std=gnu99 -O2 -Wall -Wno-unused-parameter -Wno-format -Wno-stringop-truncation -pthread -I$TESTS/host -I$ROOT/inc -I$ROOT/src"
+HOST="$TESTS/host/rtthread_host.c $TESTS/host/at_client_host.c $TESTS/host/test_host.c"
+
+mkdir -p "$BUILD"
+
+free_port()
+{
+    python3 -c 'import socket; s = socket.socket(socket.AF_INET, socket.SOCK_DGRAM); s.bind(("127.0.0.1", 0)); print(s.getsockname()[1])'
+}
+
+# start a helper, wait for it to print "ready" (or $READY)
+start_helper()
+{
+    "$@" > "$BUILD/helper.log" 2>&1 &
+    HELPER=$!
+    for i in $(seq 50); do
+        grep -q "${READY:-ready}" "$BUILD/helper.log" 2>/dev/null && return 0
+        sleep 0.1
+    done
+    echo "helper $1 did not start"
+    kill $HELPER 2>/dev/null
+    return 1
+}
+
+stop_helper()
+{
+    kill $HELPER 2>/dev/null || true
+    wait $HELPER 2>/dev/null || true
+}
+
+run_mqtt_codec()
+{
+    $CC $CFLAGS -DPKG_USING_BC28_MQTT_CODEC \
+        -o "$BUILD/test_mqtt_codec" "$TESTS/test_mqtt_codec.c" $HOST "$ROOT/src/bc28_mqtt_codec.c"
+    "$BUILD/test_mqtt_codec"
+}
+
+run_mqttsn_loopback()
+{
+    port=$(free_port)
+    $CC $CFLAGS -DPKG_USING_BC28_MQTT_SN -DPKG_USING_BC28_MQTT_RECV_BUFF_LEN=512 \
+        -DPKG_USING_BC28_MQTT_SN_GATEWAY_ADDR='"127.0.0.1"' -DPKG_USING_BC28_MQTT_SN_GATEWAY_PORT=$port \
+        -o "$BUILD/test_mqttsn_loopback" "$TESTS/test_mqttsn_loopback.c" $HOST "$TESTS/host/modem_host.c" \
+        "$ROOT/src/bc28_mqttsn.c" "$ROOT/src/bc28_socket.c"
+    start_helper python3 "$TESTS/mqttsn_gateway.py" $port
+    status=0
+    timeout 60 "$BUILD/test_mqttsn_loopback" || status=$?
+    stop_helper
+    return $status
+}
+
+# mosquitto when installed, the stand-in otherwise
+run_mqttc_broker()
+{
+    port=$(free_port)
+    $CC $CFLAGS -DPKG_USING_BC28_MQTT_CODEC -DPKG_USING_BC28_MQTT_CODEC_QOS=2 -DPKG_USING_BC28_MQTT_RECV_BUFF_LEN=1100 \
+        -DPKG_USING_BC28_MQTT_CODEC_BROKER_PORT=$port \
+        -o "$BUILD/test_mqttc_broker" "$TESTS/test_mqttc_broker.c" $HOST "$TESTS/host/modem_host.c" \
+        "$ROOT/src/bc28_mqttc.c" "$ROOT/src/bc28_mqtt_codec.c" "$ROOT/src/bc28_socket.c"
+    if command -v mosquitto > /dev/null; then
+        printf 'listener %s 127.0.0.1\nallow_anonymous true\n' $port > "$BUILD/mosquitto.conf"
+        READY=running start_helper mosquitto -v -c "$BUILD/mosquitto.conf"
+    else
+        echo "mosquitto not installed, using tests/mqtt_broker.py"
+        start_helper python3 "$TESTS/mqtt_broker.py" $port
+    fi
+    status=0
+    BROKER_PID=$HELPER timeout 60 "$BUILD/test_mqttc_broker" || status=$?
+    stop_helper
+    return $status
+}
+
+# a capture of the emulated module replayed through the AT client, BC28_TAP_CAPTURE
+# names another capture to replay and report
+run_tap_replay()
+{
+    $CC $CFLAGS -DPKG_USING_BC28_MQTT_TAP \
+        -o "$BUILD/test_tap_replay" "$TESTS/test_tap_replay.c" $HOST "$TESTS/host/uart_host.c" \
+        "$ROOT/src/bc28_mqtt.c" "$ROOT/src/bc28_tap.c"
+    timeout 120 "$BUILD/test_tap_replay" "$BUILD/tap_replay.tap" $BC28_TAP_CAPTURE
+}
+
+# the fault scenarios on the emulated module, one JSON line each in $BUILD/fault.json,
+# FAULT_SCENARIO picks one
+run_fault()
+{
+    $CC $CFLAGS -DPKG_USING_BC28_MQTT_TAP -DPKG_USING_BC28_MQTT_FAULT \
+        -o "$BUILD/test_fault" "$TESTS/test_fault.c" $HOST "$TESTS/host/uart_host.c" \
+        "$ROOT/src/bc28_mqtt.c" "$ROOT/src/bc28_tap.c" "$ROOT/src/bc28_fault.c"
+    timeout 600 "$BUILD/test_fault" "$BUILD/fault.json" $FAULT_SCENARIO
+}
+
+run_aggr_bench()
+{
+    $CC $BENCH_CFLAGS -DPKG_USING_BC28_MQTT_AGGR -DPKG_USING_BC28_MQTT_AGGR_PERCENTILE \
+        -DPKG_USING_BC28_MQTT_AGGR_SERIES=4096 \
+        -o "$BUILD/bench_aggr" "$TESTS/bench_aggr.c" $HOST "$ROOT/src/bc28_aggr.c"
+    timeout 120 "$BUILD/bench_aggr"
+}
+
+# the whole package on the emulated module, reset to first publish
+run_attach_bench()
+{
+    $CC $BENCH_CFLAGS -o "$BUILD/bench_attach" "$TESTS/bench_attach.c" $HOST "$TESTS/host/uart_host.c" \
+        "$ROOT/src/bc28_mqtt.c"
+    timeout 120 "$BUILD/bench_attach"
+}
+
+ALL="mqtt_codec mqttsn_loopback mqttc_broker tap_replay fault aggr_bench attach_bench"
+failed=0
+for t in ${*:-$ALL}; do
+    echo "== $t"
+    run_$t || { echo "FAILED $t"; failed=1; }
+done
+
+exit $failed
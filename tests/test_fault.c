@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2023, RudyLo <luhuadong@163.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     agent        the first version
+ */
+
+/*
+ * Every fault scenario of src/bc28_fault.c against the emulated module of
+ * tests/host/uart_host.c: the link has to come back from each of them.
+ * The JSON lines go to stdout and to the file given on the command line.
+ * Run by tests/run.sh.
+ *
+ * Usage: test_fault <json file> [scenario]
+ */
+
+#include <rtthread.h>
+
+#include "bc28_mqtt_internal.h"
+#include "test_host.h"
+#include "uart_host.h"
+
+int main(int argc, char *argv[])
+{
+    struct uart_host_timing timing = { 200, 300, 5 };
+    char line[512];
+    rt_uint32_t commands = 0;
+    int lines = 0, passed = 0;
+    FILE *fp = RT_NULL;
+
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <json file> [scenario]\n", argv[0]);
+        return 2;
+    }
+
+    /* the scenarios append, and open the file without permission bits */
+    if ((fp = fopen(argv[1], "w")) != RT_NULL)
+    {
+        fclose(fp);
+    }
+
+    uart_host_init(&timing);
+    TEST_CHECK(bc28_init() == RT_EOK);
+    TEST_CHECK(bc28_client_attach() == RT_EOK);
+    TEST_CHECK(bc28_build_mqtt_network() == RT_EOK);
+
+    TEST_CHECK(bc28_fault_run(argc >= 3 ? argv[2] : "all", argv[1]) == 0);
+
+    fp = fopen(argv[1], "r");
+    TEST_CHECK(fp != RT_NULL);
+    while (fp && fgets(line, sizeof(line), fp))
+    {
+        lines++;
+        passed += strstr(line, "\"result\":\"pass\"") != RT_NULL;
+    }
+    if (fp)
+    {
+        fclose(fp);
+    }
+    TEST_CHECK(lines > 0 && passed == lines);
+    TEST_CHECK(uart_host_boots() > 1);
+
+    /* an ERROR in place of the '>' prompt, the body is never sent as a command */
+    TEST_CHECK(bc28_mqtt_disconnect() == RT_EOK);
+    commands = uart_host_commands();
+    TEST_CHECK(bc28_mqtt_publish("pk/dn/user/update", "{\"seq\":0}") != RT_EOK);
+    TEST_CHECK(uart_host_commands() == commands + 1);
+
+    return test_report("fault");
+}
@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2023, RudyLo <luhuadong@163.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     agent        the first version
+ */
+
+/*
+ * MQTT 3.1.1 encoder and decoder: remaining length edge cases, truncated
+ * and malformed packets, reserved flags. Run by tests/run.sh.
+ */
+
+#include <rtthread.h>
+
+#include "bc28_mqtt_internal.h"
+#include "test_host.h"
+
+static int decode(const rt_uint8_t *buf, rt_size_t len, struct bc28_mqtt_packet *pkt)
+{
+    return bc28_mqtt_decode(buf, len, pkt);
+}
+
+#define DECODE(pkt, ...)                                                          \
+    ({                                                                            \
+        static const rt_uint8_t bytes_[] = { __VA_ARGS__ };                       \
+        decode(bytes_, sizeof(bytes_), (pkt));                                    \
+    })
+
+static void test_remaining_length(void)
+{
+    /* the largest remaining length for 1, 2, 3 and 4 length bytes and one past it */
+    static const rt_size_t edges[] = { 127, 128, 16383, 16384, 2097151, 2097152, 268435455 };
+    static const rt_size_t bytes[] = { 1,   2,   2,     3,     3,       4,       4 };
+    rt_uint8_t header[8];
+    struct bc28_mqtt_packet pkt;
+    rt_size_t n = 0;
+
+    for (rt_size_t i = 0; i < sizeof(edges) / sizeof(edges[0]); i++)
+    {
+        /* PUBLISH "t" QoS 0: topic length 2 + topic 1, the rest is payload */
+        n = bc28_mqtt_encode_publish(header, sizeof(header), "t", 0, 0, 0, edges[i] - 3);
+        TEST_CHECK(n == 1 + bytes[i] + 3);
+
+        /* header alone: the decoder waits for the rest */
+        TEST_CHECK(decode(header, n, &pkt) == 0);
+    }
+
+    /* one past the maximum does not encode */
+    TEST_CHECK(bc28_mqtt_encode_publish(header, sizeof(header), "t", 0, 0, 0, BC28_MQTT_REMAINING_MAX - 2) == 0);
+
+    /* complete packets either side of the 1 and 2 byte boundaries, decoded back */
+    {
+        static rt_uint8_t buf[2 + 16384 + 4];
+        rt_size_t sizes[] = { 127, 128, 16383, 16384 };
+
+        for (rt_size_t i = 0; i < 4; i++)
+        {
+            n = bc28_mqtt_encode_publish(buf, sizeof(buf), "t", 0, 0, 0, sizes[i] - 3);
+            memset(buf + n, 'x', sizes[i] - 3);
+            TEST_CHECK(decode(buf, n + sizes[i] - 3, &pkt) == (int)(n + sizes[i] - 3));
+            TEST_CHECK(pkt.payload_len == sizes[i] - 3 && pkt.payload == buf + n);
+            TEST_CHECK(decode(buf, n + sizes[i] - 4, &pkt) == 0);
+        }
+    }
+
+    /* a fifth length byte is malformed, whether or not it has arrived */
+    TEST_CHECK(DECODE(&pkt, 0x30, 0x80, 0x80, 0x80, 0x80, 0x01) < 0);
+    TEST_CHECK(DECODE(&pkt, 0x30, 0x80, 0x80, 0x80, 0x80) < 0);
+    TEST_CHECK(DECODE(&pkt, 0x30, 0xFF, 0xFF, 0xFF, 0x7F) == 0);
+
+    /* not enough for a header yet */
+    TEST_CHECK(DECODE(&pkt, 0x30) == 0);
+    TEST_CHECK(DECODE(&pkt, 0x30, 0x80) == 0);
+}
+
+static void test_truncated(void)
+{
+    struct bc28_mqtt_packet pkt;
+
+    /* complete packets whose remaining length is too short for their fields */
+    TEST_CHECK(DECODE(&pkt, 0x20, 0x01, 0x00) < 0);                       /* CONNACK */
+    TEST_CHECK(DECODE(&pkt, 0x30, 0x01, 0x00) < 0);                       /* PUBLISH, half a topic length */
+    TEST_CHECK(DECODE(&pkt, 0x30, 0x03, 0x00, 0x05, 't') < 0);           /* PUBLISH, topic past the end */
+    TEST_CHECK(DECODE(&pkt, 0x32, 0x04, 0x00, 0x01, 't', 0x00) < 0);     /* PUBLISH QoS 1, half a packet id */
+    TEST_CHECK(DECODE(&pkt, 0x40, 0x01, 0x00) < 0);                       /* PUBACK */
+    TEST_CHECK(DECODE(&pkt, 0x90, 0x02, 0x00, 0x01) < 0);                 /* SUBACK without return code */
+    TEST_CHECK(DECODE(&pkt, 0xB0, 0x00) < 0);                             /* UNSUBACK */
+
+    /* a packet cut by the stream is only incomplete */
+    TEST_CHECK(DECODE(&pkt, 0x40, 0x02, 0x00) == 0);
+
+    /* QoS 0 PUBLISH with an empty payload is fine */
+    TEST_CHECK(DECODE(&pkt, 0x30, 0x03, 0x00, 0x01, 't') == 5);
+    TEST_CHECK(pkt.topic_len == 1 && pkt.payload_len == 0);
+}
+
+static void test_flags(void)
+{
+    struct bc28_mqtt_packet pkt;
+    rt_uint8_t buf[4];
+
+    /* PUBREL must carry 0b0010, the other acks 0 */
+    TEST_CHECK(DECODE(&pkt, 0x62, 0x02, 0x12, 0x34) == 4);
+    TEST_CHECK(pkt.type == BC28_MQTT_PUBREL && pkt.id == 0x1234);
+    TEST_CHECK(DECODE(&pkt, 0x60, 0x02, 0x12, 0x34) < 0);
+    TEST_CHECK(DECODE(&pkt, 0x63, 0x02, 0x12, 0x34) < 0);
+    TEST_CHECK(DECODE(&pkt, 0x42, 0x02, 0x12, 0x34) < 0);
+    TEST_CHECK(DECODE(&pkt, 0x21, 0x02, 0x00, 0x00) < 0);
+    TEST_CHECK(DECODE(&pkt, 0xD1, 0x00) < 0);
+
+    /* PUBLISH: QoS 3 is malformed, DUP and RETAIN are fine */
+    TEST_CHECK(DECODE(&pkt, 0x36, 0x05, 0x00, 0x01, 't', 0x00, 0x01) < 0);
+    TEST_CHECK(DECODE(&pkt, 0x3D, 0x05, 0x00, 0x01, 't', 0x00, 0x07) == 7);
+    TEST_CHECK(pkt.id == 7 && (pkt.flags & 0x01));
+
+    /* nothing a broker sends to a client */
+    TEST_CHECK(DECODE(&pkt, 0x10, 0x00) < 0);
+    TEST_CHECK(DECODE(&pkt, 0x82, 0x00) < 0);
+    TEST_CHECK(DECODE(&pkt, 0x00, 0x00) < 0);
+    TEST_CHECK(DECODE(&pkt, 0xF0, 0x00) < 0);
+
+    /* and the encoder sets them right */
+    TEST_CHECK(bc28_mqtt_encode_ack(buf, BC28_MQTT_PUBREL, 0x0102) == 4 && buf[0] == 0x62);
+    TEST_CHECK(bc28_mqtt_encode_ack(buf, BC28_MQTT_PUBACK, 0x0102) == 4 && buf[0] == 0x40);
+    TEST_CHECK(buf[2] == 0x01 && buf[3] == 0x02);
+}
+
+static void test_encode(void)
+{
+    static const rt_uint8_t connect[] = {
+        0x10, 0x1A, 0x00, 0x04, 'M', 'Q', 'T', 'T', 0x04, 0xC2, 0x00, 0x3C,
+        0x00, 0x02, 'i', 'd', 0x00, 0x04, 'u', 's', 'e', 'r', 0x00, 0x04, 'p', 'a', 's', 's',
+    };
+    static const rt_uint8_t subscribe[] = {
+        0x82, 0x08, 0x00, 0x05, 0x00, 0x03, 'a', '/', 'b', 0x01,
+    };
+    struct bc28_mqtt_connect opt = { "id", "user", "pass", 60, 1 };
+    struct bc28_mqtt_packet pkt;
+    rt_uint8_t buf[64];
+    rt_size_t n = 0;
+
+    n = bc28_mqtt_encode_connect(buf, sizeof(buf), &opt);
+    TEST_CHECK(n == sizeof(connect) && memcmp(buf, connect, n) == 0);
+    TEST_CHECK(bc28_mqtt_encode_connect(buf, sizeof(connect) - 1, &opt) == 0);
+
+    n = bc28_mqtt_encode_subscribe(buf, sizeof(buf), BC28_MQTT_SUBSCRIBE, 5, "a/b", 1);
+    TEST_CHECK(n == sizeof(subscribe) && memcmp(buf, subscribe, n) == 0);
+
+    /* PUBLISH QoS 1 header, then the payload sent from where it lives */
+    n = bc28_mqtt_encode_publish(buf, sizeof(buf), "a/b", 0x0A0B, 1, 1, 3);
+    TEST_CHECK(n == 9 && buf[0] == 0x33 && buf[1] == 10);
+    memcpy(buf + n, "xyz", 3);
+    TEST_CHECK(decode(buf, n + 3, &pkt) == (int)n + 3);
+    TEST_CHECK(pkt.id == 0x0A0B && pkt.topic_len == 3 && memcmp(pkt.topic, "a/b", 3) == 0);
+    TEST_CHECK(pkt.payload_len == 3 && memcmp(pkt.payload, "xyz", 3) == 0);
+
+    /* header does not fit */
+    TEST_CHECK(bc28_mqtt_encode_publish(buf, 8, "a/b", 1, 1, 0, 3) == 0);
+
+    /* two packets back to back are decoded one at a time */
+    n  = bc28_mqtt_encode_ack(buf, BC28_MQTT_PUBACK, 1);
+    n += bc28_mqtt_encode_simple(buf + n, BC28_MQTT_PINGRESP);
+    TEST_CHECK(decode(buf, n, &pkt) == 4 && pkt.type == BC28_MQTT_PUBACK);
+    TEST_CHECK(decode(buf + 4, n - 4, &pkt) == 2 && pkt.type == BC28_MQTT_PINGRESP);
+}
+
+int main(void)
+{
+    test_remaining_length();
+    test_truncated();
+    test_flags();
+    test_encode();
+
+    return test_report("mqtt_codec");
+}
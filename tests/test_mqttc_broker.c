@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2023, RudyLo <luhuadong@163.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     agent        the first version
+ */
+
+/*
+ * MQTT 3.1.1 client against a broker on loopback (mosquitto, or
+ * tests/mqtt_broker.py when it is not installed), through the emulated
+ * module sockets. The broker pid is in $BROKER_PID, the test stops it at
+ * the end to see the lost link reported. Run by tests/run.sh.
+ */
+
+#include <signal.h>
+
+#include <rtthread.h>
+
+#include "bc28_mqtt_internal.h"
+#include "modem_host.h"
+#include "test_host.h"
+
+#define RECV_TIMEOUT                  2000
+#define BIG_LEN                       800        /* two NSOSD commands */
+#define SEQ_COUNT                     8          /* twice the default window */
+
+void bc28_recv_dispatch(const char *topic, rt_size_t topic_len, const char *payload, rt_size_t len)
+{
+    test_recv_push(topic, topic_len, payload, len);
+}
+
+static int expect(const char *want_topic, const void *want, rt_size_t want_len)
+{
+    char topic[64], payload[BIG_LEN];
+    rt_size_t len = 0;
+
+    return test_recv_wait(topic, sizeof(topic), payload, sizeof(payload), &len, RECV_TIMEOUT) == RT_EOK &&
+           strcmp(topic, want_topic) == 0 && len == want_len && memcmp(payload, want, len) == 0;
+}
+
+int main(void)
+{
+    char big[BIG_LEN], topic[64], msg[16];
+    const char *pid = getenv("BROKER_PID");
+    rt_size_t len = 0;
+
+    modem_host_init();
+
+    TEST_CHECK(bc28_mqttc_ops.connect() == RT_EOK);
+    TEST_CHECK(bc28_get_device()->stat == BC28_STAT_CONNECTED);
+    TEST_CHECK(bc28_mqttc_ops.subscribe("loop/#") == RT_EOK);
+
+    /* each QoS both ways, the subscription is granted QoS 2 */
+    for (int qos = 0; qos <= 2; qos++)
+    {
+        snprintf(msg, sizeof(msg), "qos %d", qos);
+        TEST_CHECK(bc28_mqttc_publish("loop/qos", msg, strlen(msg), qos, 0) == RT_EOK);
+        TEST_CHECK(expect("loop/qos", msg, strlen(msg)));
+    }
+
+    /* one PUBLISH split over several module commands */
+    for (rt_size_t i = 0; i < sizeof(big); i++)
+    {
+        big[i] = 'A' + i % 26;
+    }
+    TEST_CHECK(bc28_mqttc_publish("loop/big", big, sizeof(big), 1, 0) == RT_EOK);
+    TEST_CHECK(expect("loop/big", big, sizeof(big)));
+
+    /* the generic limit leaves room for the echo in the 1024 byte receive stream */
+    TEST_CHECK(bc28_mqttc_ops.payload_max >= sizeof(big) && bc28_mqttc_ops.payload_max < 1024);
+
+    /* twice the window in flight, flush waits for every ack */
+    for (int i = 0; i < SEQ_COUNT; i++)
+    {
+        snprintf(msg, sizeof(msg), "seq %d", i);
+        TEST_CHECK(bc28_mqttc_publish("loop/seq", msg, strlen(msg), 1 + i % 2, 0) == RT_EOK);
+    }
+    TEST_CHECK(bc28_mqttc_flush(RECV_TIMEOUT) == RT_EOK);
+    for (int i = 0; i < SEQ_COUNT; i++)
+    {
+        snprintf(msg, sizeof(msg), "seq %d", i);
+        TEST_CHECK(expect("loop/seq", msg, strlen(msg)));
+    }
+
+    TEST_CHECK(bc28_mqttc_ops.unsubscribe("loop/#") == RT_EOK);
+    TEST_CHECK(bc28_mqttc_publish("loop/qos", "gone", 4, 1, 0) == RT_EOK);
+    TEST_CHECK(test_recv_wait(topic, sizeof(topic), big, sizeof(big), &len, 300) == -RT_ETIMEOUT);
+
+    /* a close asked for is not a loss */
+    TEST_CHECK(bc28_mqttc_ops.close() == RT_EOK);
+    TEST_CHECK(bc28_get_device()->stat == BC28_STAT_DISCONNECTED);
+    TEST_CHECK(modem_host_recover_count() == 0);
+
+    /* the broker going away is, and it is handed to recovery once */
+    TEST_CHECK(bc28_mqttc_ops.connect() == RT_EOK);
+    TEST_CHECK(pid != RT_NULL && kill(atoi(pid), SIGTERM) == 0);
+    for (int i = 0; i < 100 && modem_host_recover_count() == 0; i++)
+    {
+        rt_thread_delay(20);
+    }
+    TEST_CHECK(modem_host_recover_count() == 1);
+    TEST_CHECK(bc28_get_device()->stat == BC28_STAT_DISCONNECTED);
+    TEST_CHECK(bc28_mqttc_publish("loop/qos", "lost", 4, 0, 0) != RT_EOK);
+    TEST_CHECK(bc28_mqttc_ops.close() == RT_EOK);
+    TEST_CHECK(modem_host_recover_count() == 1);
+
+    return test_report("mqttc_broker");
+}
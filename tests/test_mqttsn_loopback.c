@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2023, RudyLo <luhuadong@163.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     agent        the first version
+ */
+
+/*
+ * MQTT-SN client against tests/mqttsn_gateway.py on loopback, through the
+ * emulated module sockets. Run by tests/run.sh.
+ */
+
+#include <pthread.h>
+
+#include <rtthread.h>
+
+#include "bc28_mqtt_internal.h"
+#include "modem_host.h"
+#include "test_host.h"
+
+#define RECV_TIMEOUT                  2000
+
+void bc28_recv_dispatch(const char *topic, rt_size_t topic_len, const char *payload, rt_size_t len)
+{
+    test_recv_push(topic, topic_len, payload, len);
+}
+
+int main(void)
+{
+    char big[BC28_SOCKET_PAYLOAD_MAX], topic[64];
+    rt_size_t len = 0;
+
+    modem_host_init();
+
+    TEST_CHECK(bc28_mqttsn_predefine("pre/topic", 1) == RT_EOK);
+    TEST_CHECK(bc28_mqttsn_ops.connect() == RT_EOK);
+    TEST_CHECK(bc28_get_device()->stat == BC28_STAT_CONNECTED);
+
+    TEST_CHECK(bc28_mqttsn_ops.subscribe("loop/echo") == RT_EOK);
+    TEST_CHECK(bc28_mqttsn_ops.subscribe("pre/topic") == RT_EOK);
+    TEST_CHECK(bc28_mqttsn_ops.subscribe("ab") == RT_EOK);
+
+    /* QoS 0 on a registered topic, the gateway REGISTERs it back first */
+    TEST_CHECK(bc28_mqttsn_publish("loop/echo", "hello", 5, 0) == RT_EOK);
+    TEST_CHECK(test_recv_wait(topic, sizeof(topic), big, sizeof(big), &len, RECV_TIMEOUT) == RT_EOK);
+    TEST_CHECK(strcmp(topic, "loop/echo") == 0 && len == 5 && memcmp(big, "hello", 5) == 0);
+
+    /* QoS 1 datagram far beyond AT_CMD_MAX_LEN */
+    for (rt_size_t i = 0; i < 200; i++)
+    {
+        big[i] = 'a' + i % 26;
+    }
+    TEST_CHECK(bc28_mqttsn_publish("loop/echo", big, 200, 1) == RT_EOK);
+    TEST_CHECK(modem_host_longest_cmd() > AT_CMD_MAX_LEN);
+    TEST_CHECK(test_recv_wait(topic, sizeof(topic), big, sizeof(big), &len, RECV_TIMEOUT) == RT_EOK);
+    TEST_CHECK(len == 200 && big[199] == 'a' + 199 % 26);
+
+    /* QoS -1 on a predefined id, short topic with QoS 1 */
+    TEST_CHECK(bc28_mqttsn_publish("pre/topic", "minus", 5, -1) == RT_EOK);
+    TEST_CHECK(test_recv_wait(topic, sizeof(topic), big, sizeof(big), &len, RECV_TIMEOUT) == RT_EOK);
+    TEST_CHECK(strcmp(topic, "pre/topic") == 0 && len == 5);
+
+    TEST_CHECK(bc28_mqttsn_publish("ab", "short", 5, 1) == RT_EOK);
+    TEST_CHECK(test_recv_wait(topic, sizeof(topic), big, sizeof(big), &len, RECV_TIMEOUT) == RT_EOK);
+    TEST_CHECK(strcmp(topic, "ab") == 0 && len == 5);
+
+    /* truncated PUBLISH packets are dropped, the next good one gets through */
+    TEST_CHECK(bc28_mqttsn_publish("ct", "truncate", 8, 0) == RT_EOK);
+    TEST_CHECK(test_recv_wait(topic, sizeof(topic), big, sizeof(big), &len, RECV_TIMEOUT) == RT_EOK);
+    TEST_CHECK(strcmp(topic, "ct") == 0 && len == 5 && memcmp(big, "after", 5) == 0);
+
+    /* length fields that disagree with the datagram are dropped too */
+    TEST_CHECK(bc28_mqttsn_publish("ct", "badlen", 6, 0) == RT_EOK);
+    TEST_CHECK(test_recv_wait(topic, sizeof(topic), big, sizeof(big), &len, RECV_TIMEOUT) == RT_EOK);
+    TEST_CHECK(strcmp(topic, "ct") == 0 && len == 5 && memcmp(big, "after", 5) == 0);
+
+    /* a datagram whose URC does not fit the AT client line buffer never arrives */
+    for (rt_size_t i = 0; i < 300; i++)
+    {
+        big[i] = 'a' + i % 26;
+    }
+    TEST_CHECK(32 + 2 * (300 + 10) > AT_CLIENT_RECV_BUFF_LEN);
+    TEST_CHECK(bc28_mqttsn_publish("loop/echo", big, 300, 0) == RT_EOK);
+    TEST_CHECK(test_recv_wait(topic, sizeof(topic), big, sizeof(big), &len, 300) == -RT_ETIMEOUT);
+    TEST_CHECK(modem_host_dropped_urcs() == 1);
+    TEST_CHECK(bc28_mqttsn_publish("loop/echo", "fits", 4, 0) == RT_EOK);
+    TEST_CHECK(test_recv_wait(topic, sizeof(topic), big, sizeof(big), &len, RECV_TIMEOUT) == RT_EOK);
+    TEST_CHECK(strcmp(topic, "loop/echo") == 0 && len == 4);
+
+    /* one module datagram at most, the generic limit says so */
+    TEST_CHECK(bc28_mqttsn_ops.payload_max == BC28_SOCKET_PAYLOAD_MAX - 9);
+    TEST_CHECK(bc28_mqttsn_publish("zz", big, bc28_mqttsn_ops.payload_max, 0) == RT_EOK);
+    TEST_CHECK(bc28_mqttsn_publish("zz", big, bc28_mqttsn_ops.payload_max + 1, 0) == -RT_EFULL);
+
+    /* a DISCONNECT nobody asked for is a lost link, handed to recovery */
+    TEST_CHECK(modem_host_recover_count() == 0);
+    TEST_CHECK(bc28_mqttsn_publish("ct", "kick", 4, 0) == RT_EOK);
+    for (int i = 0; i < 100 && modem_host_recover_count() == 0; i++)
+    {
+        rt_thread_delay(20);
+    }
+    TEST_CHECK(modem_host_recover_count() == 1);
+    TEST_CHECK(bc28_get_device()->stat == BC28_STAT_DISCONNECTED);
+    TEST_CHECK(bc28_mqttsn_publish("ab", "lost", 4, 0) != RT_EOK);
+
+    /* what the worker does next: connect and subscribe again */
+    TEST_CHECK(bc28_mqttsn_ops.connect() == RT_EOK);
+    TEST_CHECK(bc28_mqttsn_ops.subscribe("pre/topic") == RT_EOK);
+    TEST_CHECK(bc28_mqttsn_ops.subscribe("ab") == RT_EOK);
+    TEST_CHECK(bc28_mqttsn_publish("ab", "again", 5, 1) == RT_EOK);
+    TEST_CHECK(test_recv_wait(topic, sizeof(topic), big, sizeof(big), &len, RECV_TIMEOUT) == RT_EOK);
+    TEST_CHECK(strcmp(topic, "ab") == 0 && len == 5 && memcmp(big, "again", 5) == 0);
+
+    /* the gateway holds messages while asleep and hands them out on wake */
+    TEST_CHECK(bc28_mqttsn_sleep(60) == RT_EOK);
+    TEST_CHECK(bc28_mqttsn_publish("pre/topic", "sleepy", 6, -1) == RT_EOK);
+    TEST_CHECK(test_recv_wait(topic, sizeof(topic), big, sizeof(big), &len, 300) == -RT_ETIMEOUT);
+    TEST_CHECK(bc28_mqttsn_wake() == RT_EOK);
+    TEST_CHECK(test_recv_wait(topic, sizeof(topic), big, sizeof(big), &len, RECV_TIMEOUT) == RT_EOK);
+    TEST_CHECK(strcmp(topic, "pre/topic") == 0 && len == 6);
+
+    /* a close asked for is not */
+    TEST_CHECK(bc28_mqttsn_ops.close() == RT_EOK);
+    TEST_CHECK(bc28_get_device()->stat == BC28_STAT_DISCONNECTED);
+    TEST_CHECK(modem_host_recover_count() == 1);
+
+    return test_report("mqttsn_loopback");
+}
@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2023, RudyLo <luhuadong@163.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     agent        the first version
+ */
+
+/*
+ * BC28TAP1 capture and replay through the AT client and the URC handlers.
+ * One child attaches, connects, subscribes and publishes against the
+ * emulated module of tests/host/uart_host.c while the tap records; a
+ * second one runs the same session on the capture alone, at full speed.
+ * A capture given on the command line is replayed the same way and only
+ * reported. Run by tests/run.sh.
+ *
+ * Usage: test_tap_replay <capture> [other capture]
+ */
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <rtthread.h>
+
+#include "bc28_mqtt_internal.h"
+#include "test_host.h"
+#include "uart_host.h"
+
+#define TAP_TOPIC                     "pk/dn/user/get"
+#define TAP_MSG                       "{\"seq\":1}"
+#define TAP_WAIT                      15000      /* longer than the tap's wait for a command */
+
+struct tap_run
+{
+    int          result;
+    rt_uint32_t  session_ms;        /* attach to the publish echoed back */
+    rt_uint32_t  module_cmds;       /* commands the emulated module answered */
+    int          received;
+    struct bc28_tap_info info;
+};
+
+static volatile int received;
+
+static void on_message(const char *json)
+{
+    if (strcmp(json, TAP_MSG) == 0)
+    {
+        received++;
+    }
+}
+
+static int session(void)
+{
+    if (bc28_client_attach() != RT_EOK || bc28_build_mqtt_network() != RT_EOK ||
+        bc28_mqtt_subscribe(TAP_TOPIC) != RT_EOK || bc28_mqtt_publish(TAP_TOPIC, TAP_MSG) != RT_EOK)
+    {
+        return -RT_ERROR;
+    }
+
+    for (int i = 0; i < 100 && received == 0; i++)
+    {
+        rt_thread_mdelay(10);
+    }
+
+    return received ? RT_EOK : -RT_ETIMEOUT;
+}
+
+/* a booted module, the tap either records or replays the session */
+static void tap_child(const char *path, rt_bool_t replay, struct tap_run *run)
+{
+    struct uart_host_timing timing = { 100, 300, 2 };
+    rt_uint32_t commands = 0;
+    rt_tick_t start = 0;
+
+    uart_host_init(&timing);
+    bc28_bind_parser(on_message);
+    if (bc28_init() != RT_EOK)
+    {
+        run->result = -RT_ERROR;
+        return;
+    }
+
+    commands = uart_host_commands();
+    run->result = replay ? bc28_tap_replay(path, 0) : bc28_tap_record(path);
+    if (run->result != RT_EOK)
+    {
+        return;
+    }
+
+    start = rt_tick_get();
+    run->result = session();
+    run->session_ms = (rt_tick_get() - start) * 1000 / RT_TICK_PER_SECOND;
+    run->received = received;
+
+    if (replay)
+    {
+        for (int i = 0; i < TAP_WAIT / 10; i++)
+        {
+            bc28_tap_info_get(&run->info);
+            if (!run->info.replaying)
+            {
+                break;
+            }
+            rt_thread_mdelay(10);
+        }
+    }
+    else
+    {
+        bc28_tap_stop();
+    }
+    bc28_tap_info_get(&run->info);
+    run->module_cmds = uart_host_commands() - commands;
+}
+
+static int tap_run(const char *path, rt_bool_t replay, struct tap_run *run)
+{
+    int fds[2], status = 0;
+    pid_t pid;
+
+    memset(run, 0, sizeof(*run));
+    if (pipe(fds) != 0 || (pid = fork()) < 0)
+    {
+        return -1;
+    }
+
+    if (pid == 0)
+    {
+        close(fds[0]);
+        tap_child(path, replay, run);
+        write(fds[1], run, sizeof(*run));
+        _exit(0);
+    }
+
+    close(fds[1]);
+    if (read(fds[0], run, sizeof(*run)) != sizeof(*run))
+    {
+        run->result = -RT_ERROR;
+    }
+    close(fds[0]);
+    waitpid(pid, &status, 0);
+
+    return run->result;
+}
+
+int main(int argc, char *argv[])
+{
+    struct tap_run record, replay;
+    FILE *fp = RT_NULL;
+
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <capture> [other capture]\n", argv[0]);
+        return 2;
+    }
+
+    /* the tap creates the file without permission bits */
+    if ((fp = fopen(argv[1], "w")) != RT_NULL)
+    {
+        fclose(fp);
+    }
+
+    TEST_CHECK(tap_run(argv[1], RT_FALSE, &record) == RT_EOK);
+    TEST_CHECK(record.received == 1);
+    TEST_CHECK(record.info.recorded > 8 && record.info.dropped == 0);
+    TEST_CHECK(record.module_cmds > 0);
+
+    TEST_CHECK(tap_run(argv[1], RT_TRUE, &replay) == RT_EOK);
+    TEST_CHECK(replay.received == 1);
+    TEST_CHECK(!replay.info.replaying && replay.info.records > 0);
+    TEST_CHECK(replay.info.mismatch == 0 && replay.info.stalled == 0);
+    TEST_CHECK(replay.module_cmds == 0);
+    TEST_CHECK(replay.session_ms < record.session_ms);
+
+    printf("recorded %u bytes, session %u ms\n", record.info.recorded, record.session_ms);
+    printf("replayed %u records in %u ms, session %u ms\n",
+           replay.info.records, replay.info.replay_ms, replay.session_ms);
+
+    if (argc >= 3)
+    {
+        tap_run(argv[2], RT_TRUE, &replay);
+        printf("%s: session %s, %u records in %u ms, %u mismatched, %u stalled\n", argv[2],
+               replay.result == RT_EOK ? "done" : "failed", replay.info.records, replay.info.replay_ms,
+               replay.info.mismatch, replay.info.stalled);
+    }
+
+    return test_report("tap_replay");
+}
@@ -0,0 +1,269 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2023, RudyLo <luhuadong@163.com>
+#
+# SPDX-License-Identifier: LGPL-2.1
+#
+# Change Logs:
+# Date           Author       Notes
+# 2026-10-19     agent        the first version
+#
+
+"""
+RAM / ROM / stack budget of the bc28_mqtt package.
+
+Reads the GNU ld map file of a BSP build and the .su files written when
+PKG_USING_BC28_MQTT_STACK_USAGE adds -fstack-usage, and reports per source
+file the flash (text, rodata, data) and RAM (data, bss) used, and the
+largest stack frames.
+
+  report : one existing build
+      bc28_footprint.py report --map rtthread.map --build build
+
+  sweep  : rebuild the BSP once per feature set and compare with the base
+      bc28_footprint.py sweep --bsp bsp/stm32/xxx [--set FLAG[,FLAG...]] ...
+
+Results can be saved with --json and compared with an earlier run with
+--compare, so growth is caught per feature flag.
+"""
+
+import argparse
+import json
+import os
+import re
+import shutil
+import subprocess
+import sys
+
+OBJ_RE = re.compile(r'(bc28_[A-Za-z0-9_]+)\.o\)?$')
+
+# feature sets built by "sweep" when --set is not given
+DEFAULT_SETS = [
+    ['PKG_USING_BC28_MQTT_ADAPTIVE_KEEPALIVE'],
+    ['PKG_USING_BC28_MQTT_LINK_MONITOR'],
+    ['PKG_USING_BC28_MQTT_SN'],
+    ['PKG_USING_BC28_MQTT_CODEC'],
+    ['PKG_USING_BC28_MQTT_TAP'],
+    ['PKG_USING_BC28_MQTT_TAP', 'PKG_USING_BC28_MQTT_FAULT'],
+    ['PKG_USING_BC28_MQTT_AGGR'],
+    ['PKG_USING_BC28_MQTT_AGGR', 'PKG_USING_BC28_MQTT_AGGR_PERCENTILE'],
+    ['PKG_USING_BC28_MQTT_CODEC', 'PKG_USING_BC28_MQTT_OTA'],
+]
+
+
+def section_kind(name):
+    """ROM/RAM class of an input section."""
+    if name.startswith('.text') or name.startswith('.rodata') or name.startswith('.glue'):
+        return 'rom'
+    if name.startswith('.data'):
+        return 'data'
+    if name.startswith('.bss') or name == 'COMMON':
+        return 'bss'
+    return None
+
+
+def parse_map(path):
+    """Sum input section sizes of the bc28 objects: {file: {rom, data, bss}}."""
+    usage = {}
+    pending = None
+    in_memory_map = False
+
+    with open(path, errors='replace') as f:
+        for line in f:
+            # discarded sections are listed before the memory map
+            if line.startswith('Linker script and memory map'):
+                in_memory_map = True
+                continue
+            if not in_memory_map:
+                continue
+
+            fields = line.split()
+            if not fields:
+                pending = None
+                continue
+
+            # " .text.foo" alone, address/size/object on the next line
+            if len(fields) == 1 and line.startswith(' ') and not line.startswith('  '):
+                pending = fields[0]
+                continue
+
+            if pending and len(fields) >= 3 and fields[0].startswith('0x'):
+                name, addr, size, obj = pending, fields[0], fields[1], fields[-1]
+            elif line.startswith(' ') and len(fields) >= 4 and fields[1].startswith('0x'):
+                name, addr, size, obj = fields[0], fields[1], fields[2], fields[-1]
+            else:
+                pending = None
+                continue
+            pending = None
+
+            kind = section_kind(name)
+            match = OBJ_RE.search(obj)
+            if kind is None or match is None:
+                continue
+            try:
+                size = int(size, 16)
+            except ValueError:
+                continue
+
+            entry = usage.setdefault(match.group(1), {'rom': 0, 'data': 0, 'bss': 0})
+            entry[kind] += size
+
+    return usage
+
+
+def parse_su(build):
+    """Stack frames from the .su files: {file: [(bytes, function, qualifier)]}."""
+    frames = {}
+
+    for root, _, files in os.walk(build):
+        for name in files:
+            if not (name.startswith('bc28_') and name.endswith('.su')):
+                continue
+            unit = name[:-3]
+            with open(os.path.join(root, name), errors='replace') as f:
+                for line in f:
+                    # "bc28_mqtt.c:301:12:check_send_cmd\t64\tstatic"
+                    parts = line.rstrip('\n').split('\t')
+                    if len(parts) < 3:
+                        continue
+                    func = parts[0].rsplit(':', 1)[-1]
+                    frames.setdefault(unit, []).append((int(parts[1]), func, parts[2]))
+
+    for unit in frames:
+        frames[unit].sort(reverse=True)
+
+    return frames
+
+
+def collect(map_path, build):
+    usage = parse_map(map_path)
+    frames = parse_su(build) if build else {}
+    result = {'files': {}, 'total': {'rom': 0, 'ram': 0, 'stack': 0}}
+
+    for unit in sorted(set(usage) | set(frames)):
+        u = usage.get(unit, {'rom': 0, 'data': 0, 'bss': 0})
+        f = frames.get(unit, [])
+        # compiled out by its feature flag
+        if not f and not any(u.values()):
+            continue
+        entry = {
+            'rom': u['rom'] + u['data'],
+            'ram': u['data'] + u['bss'],
+            'stack': f[0][0] if f else 0,
+            'frames': [[size, func, qual] for size, func, qual in f[:5]],
+        }
+        result['files'][unit] = entry
+        result['total']['rom'] += entry['rom']
+        result['total']['ram'] += entry['ram']
+        result['total']['stack'] = max(result['total']['stack'], entry['stack'])
+
+    return result
+
+
+def print_report(label, result, top):
+    print('== %s ==' % label)
+    print('%-20s %8s %8s %8s  %s' % ('file', 'ROM', 'RAM', 'frame', 'largest frames'))
+    for unit, e in result['files'].items():
+        largest = ', '.join('%s %d%s' % (func, size, '' if qual == 'static' else ' (%s)' % qual)
+                            for size, func, qual in e['frames'][:top])
+        print('%-20s %8d %8d %8d  %s' % (unit, e['rom'], e['ram'], e['stack'], largest))
+    t = result['total']
+    print('%-20s %8d %8d %8d' % ('total', t['rom'], t['ram'], t['stack']))
+    print()
+
+
+def print_compare(runs, old):
+    print('%-56s %10s %10s %8s' % ('feature set', 'ROM', 'RAM', 'frame'))
+    for label, result in runs.items():
+        t = result['total']
+        line = '%-56s %10d %10d %8d' % (label, t['rom'], t['ram'], t['stack'])
+        if old and label in old:
+            o = old[label]['total']
+            line += '   (%+d, %+d, %+d)' % (t['rom'] - o['rom'], t['ram'] - o['ram'], t['stack'] - o['stack'])
+        print(line)
+
+
+def find_map(bsp):
+    for name in os.listdir(bsp):
+        if name.endswith('.map'):
+            return os.path.join(bsp, name)
+    return None
+
+
+def build_with(bsp, flags, scons):
+    """Build the BSP with extra defines appended to rtconfig.h."""
+    config = os.path.join(bsp, 'rtconfig.h')
+    backup = config + '.footprint'
+    shutil.copyfile(config, backup)
+    try:
+        with open(backup) as f:
+            text = f.read()
+        extra = ''.join('#define %s\n' % flag for flag in flags + ['PKG_USING_BC28_MQTT_STACK_USAGE'])
+        # before the closing include guard
+        pos = text.rfind('#endif')
+        text = text[:pos] + extra + text[pos:] if pos >= 0 else text + extra
+        with open(config, 'w') as f:
+            f.write(text)
+
+        # scons -c leaves .su files behind, a disabled feature would still show up
+        subprocess.run(scons + ' -c', shell=True, cwd=bsp, stdout=subprocess.DEVNULL)
+        for root, _, files in os.walk(os.path.join(bsp, 'build')):
+            for name in files:
+                if name.startswith('bc28_') and name.endswith('.su'):
+                    os.remove(os.path.join(root, name))
+        subprocess.run(scons, shell=True, cwd=bsp, check=True, stdout=subprocess.DEVNULL)
+    finally:
+        shutil.move(backup, config)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='bc28_mqtt RAM/ROM/stack budget')
+    sub = parser.add_subparsers(dest='cmd', required=True)
+
+    rep = sub.add_parser('report', help='report one existing build')
+    rep.add_argument('--map', required=True, help='GNU ld map file')
+    rep.add_argument('--build', help='directory holding the .su files')
+    rep.add_argument('--label', default='build')
+
+    sw = sub.add_parser('sweep', help='rebuild the BSP per feature set')
+    sw.add_argument('--bsp', required=True, help='BSP directory with rtconfig.h and SConstruct')
+    sw.add_argument('--set', action='append', help='comma separated flags, repeat for more sets')
+    sw.add_argument('--scons', default='scons -j%d' % (os.cpu_count() or 1))
+
+    for p in (rep, sw):
+        p.add_argument('--top', type=int, default=3, help='largest frames listed per file')
+        p.add_argument('--json', help='save the results')
+        p.add_argument('--compare', help='results saved by an earlier run')
+
+    args = parser.parse_args()
+    runs = {}
+
+    if args.cmd == 'report':
+        runs[args.label] = collect(args.map, args.build or os.path.dirname(args.map))
+    else:
+        sets = [s.split(',') for s in args.set] if args.set else DEFAULT_SETS
+        for flags in [[]] + sets:
+            label = '+'.join(f.replace('PKG_USING_BC28_MQTT_', '') for f in flags) or 'base'
+            print('building %s ...' % label, file=sys.stderr)
+            build_with(args.bsp, flags, args.scons)
+            map_path = find_map(args.bsp)
+            if map_path is None:
+                sys.exit('no map file in %s, add -Wl,-Map to LFLAGS' % args.bsp)
+            runs[label] = collect(map_path, os.path.join(args.bsp, 'build'))
+
+    for label, result in runs.items():
+        print_report(label, result, args.top)
+
+    old = None
+    if args.compare:
+        with open(args.compare) as f:
+            old = json.load(f)
+    print_compare(runs, old)
+
+    if args.json:
+        with open(args.json, 'w') as f:
+            json.dump(runs, f, indent=2)
+
+
+if __name__ == '__main__':
+    main()